@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <example-robot-data/path.hpp>
+#include <iostream>
+#include <pinocchio/parsers/urdf.hpp>
+#include <sobec/designer.hpp>
+#include <string>
+#include <vector>
+
+// Duration of the update of the feet placements and of the CoM by
+// RobotDesigner, on the full Talos model (all the joints controlled):
+// complete forward kinematics, frames and CoM (updateReducedModel) against
+// the single pass of updateReducedKinematics, with and without the CoM.
+//
+// Usage: bench-designer-kinematics [calls]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const std::string kUrdf =
+    EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/robots/talos_full_v2.urdf";
+const std::string kSrdf =
+    EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/srdf/talos.srdf";
+
+sobec::RobotDesigner buildDesigner() {
+  pinocchio::Model model;
+  pinocchio::urdf::buildModel(kUrdf, pinocchio::JointModelFreeFlyer(), model);
+
+  sobec::RobotDesignerSettings settings;
+  settings.urdfPath = kUrdf;
+  settings.srdfPath = kSrdf;
+  settings.leftFootName = "left_sole_link";
+  settings.rightFootName = "right_sole_link";
+  settings.controlledJointsNames.assign(model.names.begin() + 1,
+                                        model.names.end());
+  return sobec::RobotDesigner(settings);
+}
+
+double percentile(std::vector<double> samples, const double p) {
+  std::sort(samples.begin(), samples.end());
+  const std::size_t i = std::min(
+      samples.size() - 1,
+      static_cast<std::size_t>(p / 100. * static_cast<double>(samples.size())));
+  return samples[i];
+}
+
+template <typename Update>
+void run(const std::string& name, const std::vector<Eigen::VectorXd>& qs,
+         Update update) {
+  std::vector<double> durations;
+  durations.reserve(qs.size());
+  for (const Eigen::VectorXd& q : qs) {
+    const Clock::time_point start = Clock::now();
+    update(q);
+    durations.push_back(
+        1e6 * std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  std::cout << name << ": p50 " << percentile(durations, 50) << " us, p99 "
+            << percentile(durations, 99) << " us" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int calls = argc > 1 ? std::max(10, std::atoi(argv[1])) : 10000;
+
+  std::cout << "*** Benchmark start ***" << std::endl;
+  sobec::RobotDesigner designer = buildDesigner();
+  const Eigen::VectorXd q0 = designer.get_q0();
+  std::cout << "nq = " << q0.size() << ", " << calls << " calls" << std::endl;
+
+  std::vector<Eigen::VectorXd> qs(calls, q0);
+  for (Eigen::VectorXd& q : qs)
+    q.tail(q.size() - 7) += 0.1 * Eigen::VectorXd::Random(q.size() - 7);
+
+  run("updateReducedModel", qs, [&designer](const Eigen::VectorXd& q) {
+    designer.updateReducedModel(q);
+  });
+  run("updateReducedKinematics", qs, [&designer](const Eigen::VectorXd& q) {
+    designer.updateReducedKinematics(q);
+  });
+  run("updateReducedKinematics without CoM", qs,
+      [&designer](const Eigen::VectorXd& q) {
+        designer.updateReducedKinematics(q, false);
+      });
+
+  // Both paths must give the same feet and CoM.
+  double error = 0;
+  for (const Eigen::VectorXd& q : qs) {
+    designer.updateReducedModel(q);
+    const pinocchio::SE3 LF = designer.get_LF_frame();
+    const Eigen::Vector3d com = designer.get_com_position();
+    designer.updateReducedKinematics(q);
+    error = std::max(error, (LF.toHomogeneousMatrix() -
+                             designer.get_LF_frame().toHomogeneousMatrix())
+                                .norm());
+    error = std::max(error, (com - designer.get_com_position()).norm());
+  }
+  std::cout << "Max difference between the paths: " << error << std::endl;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sobec/designer.hpp>
+#include <sobec/horizon_manager.hpp>
+#include <sobec/model_factory.hpp>
+#include <string>
+#include <vector>
+
+#include "factory/designer.hpp"
+
+// Latency of the receding HorizonManager::solve on a standing Talos horizon,
+// against the previous implementation which reallocated the solver data and
+// rebuilt the warm start at each tick. The medians of consecutive blocks of
+// ticks show whether the latency stays flat over time.
+//
+// Usage: bench-horizon-solve [T] [ticks]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+sobec::HorizonManager buildHorizon(const int T) {
+  const sobec::unittest::TalosDesignerFactory factory;
+  sobec::RobotDesigner designer = factory.create();
+  sobec::ModelMaker maker(factory.create_makerSettings(designer), designer);
+
+  const std::vector<sobec::AMA> models = maker.formulateHorizon(T);
+  sobec::HorizonManagerSettings horizonSettings;
+  horizonSettings.leftFootName = designer.get_LF_name();
+  horizonSettings.rightFootName = designer.get_RF_name();
+  return sobec::HorizonManager(horizonSettings, designer.get_x0(), models,
+                               models.back());
+}
+
+// HorizonManager::solve as it was: warm start rebuilt by erase/push_back and
+// solver data reallocated at each call.
+void legacySolve(sobec::HorizonManager& horizon, const Eigen::VectorXd& x,
+                 const std::size_t iterations) {
+  const sobec::DDP ddp = horizon.get_ddp();
+  std::vector<Eigen::VectorXd> xs = ddp->get_xs();
+  xs.erase(xs.begin());
+  xs[0] = x;
+  xs.push_back(xs[xs.size() - 1]);
+  std::vector<Eigen::VectorXd> us = ddp->get_us();
+  us.erase(us.begin());
+  us.push_back(us[us.size() - 1]);
+  ddp->get_problem()->set_x0(x);
+  ddp->allocateData();
+  ddp->solve(xs, us, iterations, false);
+}
+
+double percentile(std::vector<double> samples, const double p) {
+  std::sort(samples.begin(), samples.end());
+  const std::size_t i = std::min(
+      samples.size() - 1,
+      static_cast<std::size_t>(p / 100. * static_cast<double>(samples.size())));
+  return samples[i];
+}
+
+void run(const std::string& name, sobec::HorizonManager& horizon,
+         const int ticks, const bool legacy) {
+  const Eigen::VectorXd x = horizon.get_ddp()->get_problem()->get_x0();
+  std::vector<Eigen::VectorXd> xs(horizon.size() + 1, x);
+  std::vector<Eigen::VectorXd> us(
+      horizon.size(),
+      Eigen::VectorXd::Zero(horizon.get_ddp()->get_us()[0].size()));
+  horizon.get_ddp()->solve(xs, us, 100, false);
+
+  std::vector<double> durations;
+  durations.reserve(ticks);
+  for (int i = 0; i < ticks; ++i) {
+    horizon.recede();
+    const Clock::time_point start = Clock::now();
+    if (legacy) {
+      legacySolve(horizon, x, 1);
+    } else {
+      horizon.solve(x, 1);
+    }
+    durations.push_back(
+        1e3 * std::chrono::duration<double>(Clock::now() - start).count());
+  }
+
+  std::cout << name << ": p50 " << percentile(durations, 50) << " ms, p99 "
+            << percentile(durations, 99) << " ms, max "
+            << *std::max_element(durations.begin(), durations.end())
+            << " ms" << std::endl
+            << "  block medians (ms):";
+  const int block = std::max(1, ticks / 10);
+  for (int b = 0; b + block <= ticks; b += block) {
+    std::cout << " "
+              << percentile(std::vector<double>(durations.begin() + b,
+                                                durations.begin() + b + block),
+                            50);
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int T = argc > 1 ? std::max(2, std::atoi(argv[1])) : 100;
+  const int ticks = argc > 2 ? std::max(10, std::atoi(argv[2])) : 1000;
+
+  std::cout << "*** Benchmark start ***" << std::endl;
+  // Copies of a HorizonManager share their solver: each run builds its own.
+  sobec::HorizonManager steady = buildHorizon(T);
+  sobec::HorizonManager legacy = buildHorizon(T);
+  std::cout << "T = " << T << ", " << ticks << " ticks, 1 iteration"
+            << std::endl;
+  run("steady-state solve", steady, ticks, false);
+  run("legacy solve", legacy, ticks, true);
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <chrono>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <sobec/designer.hpp>
+#include <sobec/model_factory.hpp>
+#include <thread>
+#include <vector>
+
+#include "factory/designer.hpp"
+
+// Construction time of ModelMaker::formulateHorizon on a walking Talos
+// cycle, against the number of nodes and of threads.
+//
+// Usage: bench-model-maker [max threads]
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Same pattern as WBC::generateWalkigCycle, repeated up to T nodes.
+std::vector<sobec::Support> walkingSupports(const std::size_t T) {
+  const std::size_t Tsingle = 100, Tstep = 150;
+  std::vector<sobec::Support> supports(T);
+  for (std::size_t i = 0; i < T; i++) {
+    const std::size_t t = i % (2 * Tstep);
+    if (t < Tsingle)
+      supports[i] = sobec::LEFT;
+    else if (t < Tstep)
+      supports[i] = sobec::DOUBLE;
+    else if (t < Tstep + Tsingle)
+      supports[i] = sobec::RIGHT;
+    else
+      supports[i] = sobec::DOUBLE;
+  }
+  return supports;
+}
+
+std::size_t nbActiveContacts(const sobec::AMA& model) {
+  return boost::static_pointer_cast<
+             crocoddyl::DifferentialActionModelContactFwdDynamics>(
+             boost::static_pointer_cast<crocoddyl::IntegratedActionModelEuler>(
+                 model)
+                 ->get_differential())
+      ->get_contacts()
+      ->get_active_set()
+      .size();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int maxThreads =
+      argc > 1 ? std::max(1, std::atoi(argv[1]))
+               : std::max(1u, std::thread::hardware_concurrency());
+
+  std::cout << "*** Benchmark start ***" << std::endl;
+  const sobec::unittest::TalosDesignerFactory factory;
+  sobec::RobotDesigner designer = factory.create();
+  sobec::ModelMakerSettings settings = factory.create_makerSettings(designer);
+
+  std::cout << "nodes threads time(ms) speedup" << std::endl;
+  for (const std::size_t T : {50, 100, 300, 600}) {
+    const std::vector<sobec::Support> supports = walkingSupports(T);
+    double sequential = 0;
+    std::vector<sobec::AMA> reference;
+    for (int nthreads = 1; nthreads <= maxThreads; nthreads *= 2) {
+      settings.nthreads = nthreads;
+      sobec::ModelMaker maker(settings, designer);
+      const Clock::time_point start = Clock::now();
+      const std::vector<sobec::AMA> models = maker.formulateHorizon(supports);
+      const double duration =
+          1e3 * std::chrono::duration<double>(Clock::now() - start).count();
+      if (nthreads == 1) {
+        sequential = duration;
+        reference = models;
+      }
+      // The nodes must follow the supports whatever the thread count.
+      for (std::size_t i = 0; i < T; i++) {
+        if (nbActiveContacts(models[i]) != nbActiveContacts(reference[i])) {
+          std::cerr << "Node " << i << " differs with " << nthreads
+                    << " threads" << std::endl;
+          return 1;
+        }
+      }
+      std::cout << T << " " << nthreads << " " << duration << " "
+                << sequential / duration << std::endl;
+    }
+  }
+}
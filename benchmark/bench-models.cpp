@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <crocoddyl/core/costs/cost-sum.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/multibody/contacts/contact-3d.hpp>
+#include <crocoddyl/multibody/data/multibody.hpp>
+#include <crocoddyl/multibody/states/multibody.hpp>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "factory/contact1d.hpp"
+#include "factory/contact3d.hpp"
+#include "factory/cost.hpp"
+#include "factory/diff-action.hpp"
+#include "factory/lpf.hpp"
+#include "factory/statelpf.hpp"
+
+// Cost of calc and calcDiff of the sobec components, next to the crocoddyl
+// built-ins they replace or extend, on the Talos and random humanoid models.
+// The components are built by the unittest factories (tests/factory).
+//
+// Usage: bench-models [repetitions]
+
+namespace {
+
+using namespace sobec::unittest;
+typedef std::chrono::steady_clock Clock;
+
+int nrep = 10000;
+
+// Median over 5 batches of the duration of f, in ns.
+template <typename F>
+double measure(F f) {
+  for (int i = 0; i < nrep / 10; ++i) f();
+  std::vector<double> batches;
+  for (int b = 0; b < 5; ++b) {
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < nrep; ++i) f();
+    batches.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count() /
+        nrep);
+  }
+  std::sort(batches.begin(), batches.end());
+  return batches[batches.size() / 2];
+}
+
+void printHeader(const std::string& title) {
+  std::cout << std::endl
+            << "### " << title << std::endl
+            << std::setw(56) << std::left << "component" << std::right
+            << std::setw(14) << "calc (ns)" << std::setw(16)
+            << "calcDiff (ns)" << std::endl;
+}
+
+void printRow(const std::string& name, const double calc,
+              const double calcDiff) {
+  std::cout << std::setw(56) << std::left << name << std::right
+            << std::setw(14) << std::fixed << std::setprecision(0) << calc
+            << std::setw(16) << calcDiff << std::endl;
+}
+
+template <typename T>
+std::string str(const T& type) {
+  std::ostringstream os;
+  os << type;
+  return os.str();
+}
+
+void benchCost(const boost::shared_ptr<crocoddyl::CostModelAbstract>& model,
+               const std::string& name) {
+  const boost::shared_ptr<crocoddyl::StateMultibody> state =
+      boost::static_pointer_cast<crocoddyl::StateMultibody>(model->get_state());
+  pinocchio::Model& pinocchio_model = *state->get_pinocchio();
+  pinocchio::Data pinocchio_data(pinocchio_model);
+  crocoddyl::DataCollectorMultibody shared_data(&pinocchio_data);
+  const boost::shared_ptr<crocoddyl::CostDataAbstract> data =
+      model->createData(&shared_data);
+  const Eigen::VectorXd x = state->rand();
+  const Eigen::VectorXd u = Eigen::VectorXd::Random(model->get_nu());
+  updateAllPinocchio(&pinocchio_model, &pinocchio_data, x);
+
+  const double calc = measure([&]() { model->calc(data, x, u); });
+  const double calcDiff = measure([&]() { model->calcDiff(data, x, u); });
+  printRow(name, calc, calcDiff);
+}
+
+void benchContact(
+    const boost::shared_ptr<crocoddyl::ContactModelAbstract>& model,
+    const std::string& name) {
+  const boost::shared_ptr<pinocchio::Model>& pinocchio_model =
+      model->get_state()->get_pinocchio();
+  pinocchio::Data pinocchio_data(*pinocchio_model);
+  const boost::shared_ptr<crocoddyl::ContactDataAbstract> data =
+      model->createData(&pinocchio_data);
+  const Eigen::VectorXd x = model->get_state()->rand();
+  updateAllPinocchio(pinocchio_model.get(), &pinocchio_data, x);
+
+  const double calc = measure([&]() { model->calc(data, x); });
+  const double calcDiff = measure([&]() { model->calcDiff(data, x); });
+  printRow(name, calc, calcDiff);
+}
+
+void benchState(const boost::shared_ptr<crocoddyl::StateAbstract>& state,
+                const std::string& name) {
+  const Eigen::VectorXd x1 = state->rand();
+  const Eigen::VectorXd x2 = state->rand();
+  Eigen::VectorXd dx = Eigen::VectorXd::Zero(state->get_ndx());
+  Eigen::VectorXd x = state->zero();
+  Eigen::MatrixXd J1 =
+      Eigen::MatrixXd::Zero(state->get_ndx(), state->get_ndx());
+  Eigen::MatrixXd J2 = J1;
+  state->diff(x1, x2, dx);
+
+  printRow(name + " diff/Jdiff", measure([&]() { state->diff(x1, x2, dx); }),
+           measure([&]() { state->Jdiff(x1, x2, J1, J2, crocoddyl::both); }));
+  printRow(name + " integrate/Jintegrate",
+           measure([&]() { state->integrate(x1, dx, x); }),
+           measure([&]() {
+             state->Jintegrate(x1, dx, J1, J2, crocoddyl::both);
+           }));
+}
+
+void benchAction(
+    const boost::shared_ptr<crocoddyl::ActionModelAbstract>& model,
+    const std::string& name) {
+  const boost::shared_ptr<crocoddyl::ActionDataAbstract> data =
+      model->createData();
+  const Eigen::VectorXd x = model->get_state()->rand();
+  const Eigen::VectorXd u = Eigen::VectorXd::Random(model->get_nu());
+
+  const double calc = measure([&]() { model->calc(data, x, u); });
+  const double calcDiff = measure([&]() { model->calcDiff(data, x, u); });
+  printRow(name, calc, calcDiff);
+}
+
+// The LPF action model and the Euler integration of the same differential
+// model, with the parameters of the LPF factory.
+void benchLPF(
+    const boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract>& dam,
+    const std::string& name) {
+  const double dt = 1e-3;
+  boost::shared_ptr<sobec::IntegratedActionModelLPF> lpf =
+      boost::make_shared<sobec::IntegratedActionModelLPF>(dam, dt, true, 50,
+                                                          true, 0, false);
+  lpf->set_control_reg_cost(0.02, Eigen::VectorXd::Zero(dam->get_nu()));
+  lpf->set_control_lim_cost(1.);
+  benchAction(lpf, "sobec::IntegratedActionModelLPF " + name);
+  benchAction(
+      boost::make_shared<crocoddyl::IntegratedActionModelEuler>(dam, dt),
+      "crocoddyl::IntegratedActionModelEuler " + name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) nrep = std::max(10, std::atoi(argv[1]));
+  std::cout << "*** Benchmark start ***" << std::endl;
+
+  const PinocchioModelTypes::Type models[] = {
+      PinocchioModelTypes::Talos, PinocchioModelTypes::RandomHumanoid};
+  const StateModelTypes::Type states[] = {
+      StateModelTypes::StateMultibody_Talos,
+      StateModelTypes::StateMultibody_RandomHumanoid};
+
+  // Residual costs: the sobec residuals are listed with the crocoddyl ones.
+  printHeader("Residual costs (quadratic activation)");
+  CostModelFactory costFactory;
+  for (const StateModelTypes::Type state : states) {
+    for (const CostModelTypes::Type cost : CostModelTypes::all) {
+      benchCost(costFactory.create(cost, state,
+                                   ActivationModelTypes::ActivationModelQuad),
+                str(cost) + " " + str(state));
+    }
+  }
+
+  // Contacts: sobec ContactModel3D/1D against crocoddyl ContactModel3D, which
+  // only supports the LOCAL reference.
+  printHeader("Contacts");
+  ContactModel3DFactory contact3DFactory;
+  ContactModel1DFactory contact1DFactory;
+  const Eigen::Vector2d gains(0, 100);
+  for (const PinocchioModelTypes::Type model : models) {
+    PinocchioModelFactory modelFactory(model);
+    for (const PinocchioReferenceTypes::Type ref :
+         PinocchioReferenceTypes::all) {
+      benchContact(contact3DFactory.create(model, ref, gains),
+                   "sobec::ContactModel3D " + str(ref) + " " + str(model));
+      benchContact(
+          contact1DFactory.create(ContactModelMaskTypes::Z, model, ref, gains),
+          "sobec::ContactModel1D " + str(ref) + " " + str(model));
+    }
+    boost::shared_ptr<crocoddyl::StateMultibody> state =
+        boost::make_shared<crocoddyl::StateMultibody>(modelFactory.create());
+    benchContact(boost::make_shared<crocoddyl::ContactModel3D>(
+                     state, modelFactory.get_frame_id(),
+                     Eigen::Vector3d::Zero(), state->get_nv(), gains),
+                 "crocoddyl::ContactModel3D LOCAL " + str(model));
+  }
+
+  // StateLPF against the multibody state it extends.
+  printHeader("States");
+  StateLPFModelFactory stateLPFFactory;
+  const StateLPFModelTypes::Type statesLPF[] = {
+      StateLPFModelTypes::StateLPF_Talos,
+      StateLPFModelTypes::StateLPF_RandomHumanoid};
+  for (const StateLPFModelTypes::Type type : statesLPF) {
+    boost::shared_ptr<sobec::StateLPF> state = stateLPFFactory.create(type);
+    benchState(state, "sobec::StateLPF " + str(type));
+    benchState(boost::make_shared<crocoddyl::StateMultibody>(
+                   state->get_pinocchio()),
+               "crocoddyl::StateMultibody " + str(type));
+  }
+
+  // LPF action models against the Euler integration of the same model. The
+  // contact factory only supports the arm and quadruped models.
+  printHeader("Action models");
+  DifferentialActionModelFactory damFactory;
+  for (const StateModelTypes::Type state : states) {
+    benchLPF(damFactory.create_freeFwdDynamics(
+                 state, ActuationModelTypes::ActuationModelFloatingBase),
+             "free " + str(state));
+  }
+  const DifferentialActionModelTypes::Type contactDAMs[] = {
+      DifferentialActionModelTypes::
+          DifferentialActionModelContact3DFwdDynamics_TalosArm,
+      DifferentialActionModelTypes::
+          DifferentialActionModelContact3DFwdDynamics_HyQ};
+  for (const DifferentialActionModelTypes::Type type : contactDAMs) {
+    benchLPF(damFactory.create(type), str(type));
+  }
+}
@@ -1,18 +1,266 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <crocoddyl/core/solvers/fddp.hpp>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
 #include <iostream>
 #include <sobec/fwd.hpp>
 #include <sobec/mpc-walk.hpp>
 #include <sobec/py2cpp.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
+// Latency of the MPC ticks, for a sweep of Tmpc, solver_maxiter and nthreads.
+// Each configuration is warmed up, then run several times; the percentiles of
+// the tick durations are given for all ticks, and separately for the ticks
+// starting in single and in double support.
+//
+// Usage: bench-mpc-walk [--tmpc 60,120] [--maxiter 1,2] [--nthreads 1,4]
+//                       [--warmup 20] [--ticks 200] [--runs 5]
+//                       [--output bench-mpc-walk.json]
+// The defaults sweep Tmpc/2 and Tmpc, 1 and solver_maxiter iterations, and 1
+// and all the hardware threads.
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  std::vector<int> tmpc;
+  std::vector<int> maxiter;
+  std::vector<int> nthreads;
+  int warmup = 20;
+  int ticks = 200;
+  int runs = 5;
+  std::string output = "bench-mpc-walk.json";
+};
+
+std::vector<int> parseList(const char* arg) {
+  std::vector<int> values;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) values.push_back(std::atoi(item.c_str()));
+  return values;
+}
+
+Options parseOptions(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string key = argv[i];
+    if (key == "--tmpc") {
+      options.tmpc = parseList(argv[i + 1]);
+    } else if (key == "--maxiter") {
+      options.maxiter = parseList(argv[i + 1]);
+    } else if (key == "--nthreads") {
+      options.nthreads = parseList(argv[i + 1]);
+    } else if (key == "--warmup") {
+      options.warmup = std::atoi(argv[i + 1]);
+    } else if (key == "--ticks") {
+      options.ticks = std::atoi(argv[i + 1]);
+    } else if (key == "--runs") {
+      options.runs = std::atoi(argv[i + 1]);
+    } else if (key == "--output") {
+      options.output = argv[i + 1];
+    } else {
+      std::cerr << "Unknown option " << key << std::endl;
+      std::exit(1);
+    }
+  }
+  return options;
+}
+
+void setDefault(std::vector<int>& values, const int a, const int b) {
+  if (!values.empty()) return;
+  values.push_back(a);
+  if (b != a) values.push_back(b);
+}
+
+// Percentiles (in ms) of a sample of durations (in s).
+struct Stats {
+  std::size_t count = 0;
+  double min = 0, p50 = 0, p90 = 0, p99 = 0, max = 0, mean = 0;
+};
+
+Stats computeStats(std::vector<double> samples) {
+  Stats s;
+  s.count = samples.size();
+  if (samples.empty()) return s;
+  std::sort(samples.begin(), samples.end());
+  const auto percentile = [&samples](const double p) {
+    const std::size_t rank = static_cast<std::size_t>(
+        std::ceil(p / 100. * static_cast<double>(samples.size())));
+    const std::size_t i = std::min(std::max<std::size_t>(rank, 1),
+                                   samples.size());
+    return 1e3 * samples[i - 1];
+  };
+  s.min = 1e3 * samples.front();
+  s.max = 1e3 * samples.back();
+  s.p50 = percentile(50);
+  s.p90 = percentile(90);
+  s.p99 = percentile(99);
+  double sum = 0;
+  for (const double v : samples) sum += v;
+  s.mean = 1e3 * sum / static_cast<double>(samples.size());
+  return s;
+}
+
+void writeStats(std::ostream& os, const Stats& s) {
+  os << "{\"count\": " << s.count << ", \"min\": " << s.min
+     << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90
+     << ", \"p99\": " << s.p99 << ", \"max\": " << s.max
+     << ", \"mean\": " << s.mean << "}";
+}
+
+// True if the storage node n is in single support, following the contact
+// pattern of the walk: start, then double, single, double, single.
+bool isSingleSupport(const sobec::MPCWalk& mpc, const int n) {
+  if (n < mpc.Tstart) return false;
+  const int p = n - mpc.Tstart;
+  const int Tcycle = 2 * (mpc.Tdouble + mpc.Tsingle);
+  return (p >= mpc.Tdouble && p < mpc.Tdouble + mpc.Tsingle) ||
+         (p >= 2 * mpc.Tdouble + mpc.Tsingle && p < Tcycle);
+}
+
+boost::shared_ptr<sobec::MPCWalk> buildMPC(
+    const sobec::MPCWalk& base, const int Tmpc, const int maxiter,
+    const int nthreads, const std::vector<Eigen::VectorXd>& xs,
+    const std::vector<Eigen::VectorXd>& us) {
+  boost::shared_ptr<sobec::MPCWalk> mpc =
+      boost::make_shared<sobec::MPCWalk>(base.storage);
+  mpc->Tstart = base.Tstart;
+  mpc->Tdouble = base.Tdouble;
+  mpc->Tsingle = base.Tsingle;
+  mpc->Tend = base.Tend;
+  mpc->DT = base.DT;
+  mpc->vcomRef = base.vcomRef;
+  mpc->x0 = base.x0;
+  mpc->solver_th_stop = base.solver_th_stop;
+  mpc->solver_reg_min = base.solver_reg_min;
+  mpc->stateRegCostName = base.stateRegCostName;
+  mpc->Tmpc = Tmpc;
+  mpc->solver_maxiter = maxiter;
+  mpc->nthreads = nthreads;
+  mpc->initialize(
+      std::vector<Eigen::VectorXd>(xs.begin(), xs.begin() + Tmpc + 1),
+      std::vector<Eigen::VectorXd>(us.begin(), us.begin() + Tmpc));
+  return mpc;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
   using namespace sobec;
   using namespace crocoddyl;
+
+  Options options = parseOptions(argc, argv);
+
   std::cout << "*** Benchmark start ***" << std::endl;
-  boost::shared_ptr<sobec::MPCWalk> mpc =
-      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/benchmark/mpc_description.py");
+  boost::shared_ptr<MPCWalk> base =
+      initMPCWalk(PROJECT_SOURCE_DIR "/benchmark/mpc_description.py");
+  boost::shared_ptr<ShootingProblem> storage = base->storage;
+  const int T = static_cast<int>(storage->get_T());
+
+  const int hw =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  setDefault(options.tmpc, base->Tmpc / 2, base->Tmpc);
+  setDefault(options.maxiter, 1, base->solver_maxiter);
+  setDefault(options.nthreads, 1, hw);
+
+  // Solution of the full walk, from which each MPC is initialized.
+  std::vector<Eigen::VectorXd> xs(T + 1, storage->get_x0());
+  std::vector<Eigen::VectorXd> us(T);
+  for (int t = 0; t < T; ++t)
+    us[t] = Eigen::VectorXd::Zero(storage->get_runningModels()[t]->get_nu());
+  storage->quasiStatic(us, xs);
+  SolverFDDP ddp(storage);
+  ddp.solve(xs, us, 200);
+  xs = ddp.get_xs();
+  us = ddp.get_us();
+
+  std::ofstream json(options.output.c_str());
+  json << "{\n  \"benchmark\": \"bench-mpc-walk\",\n"
+       << "  \"timestamp\": " << std::time(NULL) << ",\n"
+       << "  \"hardware_concurrency\": " << hw << ",\n"
+       << "  \"storage_nodes\": " << T << ",\n"
+       << "  \"warmup\": " << options.warmup << ",\n"
+       << "  \"ticks\": " << options.ticks << ",\n"
+       << "  \"runs\": " << options.runs << ",\n"
+       << "  \"unit\": \"ms\",\n  \"configurations\": [";
+
+  std::cout << "Tmpc\tmaxiter\tthreads\tp50 (ms)\tp99 (ms)\tmax (ms)\t"
+               "single p50\tdouble p50"
+            << std::endl;
+  bool first = true;
+  for (const int Tmpc : options.tmpc) {
+    if (Tmpc < 1 || Tmpc > T) {
+      std::cerr << "Skipping Tmpc=" << Tmpc << ": the storage has " << T
+                << " nodes" << std::endl;
+      continue;
+    }
+    for (const int maxiter : options.maxiter) {
+      for (const int nthreads : options.nthreads) {
+        boost::shared_ptr<MPCWalk> mpc =
+            buildMPC(*base, Tmpc, maxiter, nthreads, xs, us);
+
+        std::vector<double> all, single, dbl, runMedians;
+        all.reserve(options.ticks * options.runs);
+        int t = 1;
+        Eigen::VectorXd x = mpc->problem->get_x0();
+        for (int i = 0; i < options.warmup; ++i, ++t) {
+          mpc->calc(x, t);
+          x = mpc->solver->get_xs()[1];
+        }
+        for (int run = 0; run < options.runs; ++run) {
+          std::vector<double> ticks;
+          ticks.reserve(options.ticks);
+          for (int i = 0; i < options.ticks; ++i, ++t) {
+            const Clock::time_point start = Clock::now();
+            mpc->calc(x, t);
+            const double duration =
+                std::chrono::duration<double>(Clock::now() - start).count();
+            x = mpc->solver->get_xs()[1];
+            ticks.push_back(duration);
+            all.push_back(duration);
+            // calc(x, t) appends node t + Tmpc: the horizon solved at tick t
+            // starts at node t + 1.
+            if (isSingleSupport(*mpc, mpc->scheduledNode(t + 1))) {
+              single.push_back(duration);
+            } else {
+              dbl.push_back(duration);
+            }
+          }
+          runMedians.push_back(computeStats(ticks).p50);
+        }
+
+        const Stats sAll = computeStats(all);
+        const Stats sSingle = computeStats(single);
+        const Stats sDouble = computeStats(dbl);
+        std::cout << Tmpc << "\t" << maxiter << "\t" << nthreads << "\t"
+                  << sAll.p50 << "\t\t" << sAll.p99 << "\t\t" << sAll.max
+                  << "\t\t" << sSingle.p50 << "\t\t" << sDouble.p50
+                  << std::endl;
 
-  Eigen::VectorXd x = mpc->problem->get_x0();
-  for (int t = 1; t <= 100; t++) {
-    mpc->calc(x, t);
-    x = mpc->solver->get_xs()[1];
+        json << (first ? "\n" : ",\n") << "    {\"Tmpc\": " << Tmpc
+             << ", \"maxiter\": " << maxiter << ", \"nthreads\": " << nthreads
+             << ",\n     \"ticks\": ";
+        writeStats(json, sAll);
+        json << ",\n     \"single_support\": ";
+        writeStats(json, sSingle);
+        json << ",\n     \"double_support\": ";
+        writeStats(json, sDouble);
+        json << ",\n     \"run_p50\": [";
+        for (std::size_t r = 0; r < runMedians.size(); ++r)
+          json << (r > 0 ? ", " : "") << runMedians[r];
+        json << "]}";
+        first = false;
+      }
+    }
   }
+  json << "\n  ]\n}\n";
+  std::cout << "Results written to " << options.output << std::endl;
 }
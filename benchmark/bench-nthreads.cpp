@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <sobec/fwd.hpp>
+#include <sobec/mpc-walk.hpp>
+#include <sobec/py2cpp.hpp>
+#include <thread>
+
+// Scaling of the evaluation of the walking horizon with the number of threads.
+// Usage: bench-nthreads [repetitions] [max threads]
+int main(int argc, char* argv[]) {
+  using namespace sobec;
+  using namespace crocoddyl;
+  typedef std::chrono::steady_clock Clock;
+
+  const int nrep = argc > 1 ? std::atoi(argv[1]) : 50;
+  const int nmax =
+      argc > 2 ? std::atoi(argv[2])
+               : std::max(1, static_cast<int>(
+                                 std::thread::hardware_concurrency()));
+
+  std::cout << "*** Benchmark start ***" << std::endl;
+  boost::shared_ptr<sobec::MPCWalk> mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/benchmark/mpc_description.py");
+  mpc->solver->setCallbacks(std::vector<boost::shared_ptr<CallbackAbstract> >());
+
+  // Full walking horizon.
+  boost::shared_ptr<ShootingProblem> problem = mpc->storage;
+  std::vector<Eigen::VectorXd> xs(problem->get_T() + 1, problem->get_x0());
+  std::vector<Eigen::VectorXd> us(problem->get_T());
+  for (std::size_t t = 0; t < problem->get_T(); ++t)
+    us[t] = Eigen::VectorXd::Zero(problem->get_runningModels()[t]->get_nu());
+  problem->quasiStatic(us, xs);
+
+  std::cout << "Horizon of " << problem->get_T() << " nodes, MPC of "
+            << mpc->Tmpc << " nodes, " << nrep << " repetitions" << std::endl;
+  std::cout << "nthreads\tcalc (ms)\tcalcDiff (ms)\tMPC tick (ms)\tspeedup"
+            << std::endl;
+
+  Eigen::VectorXd x = mpc->problem->get_x0();
+  double reference = 0.;
+  int t = 1;
+  for (int n = 1; n <= nmax; ++n) {
+    problem->set_nthreads(n);
+    mpc->problem->set_nthreads(n);
+
+    problem->calc(xs, us);
+    problem->calcDiff(xs, us);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < nrep; ++i) problem->calc(xs, us);
+    const double calc =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count() /
+        nrep;
+    start = Clock::now();
+    for (int i = 0; i < nrep; ++i) problem->calcDiff(xs, us);
+    const double calcDiff =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count() /
+        nrep;
+
+    start = Clock::now();
+    for (int i = 0; i < nrep; ++i, ++t) {
+      mpc->calc(x, t);
+      x = mpc->solver->get_xs()[1];
+    }
+    const double tick =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count() /
+        nrep;
+
+    if (n == 1) reference = calc + calcDiff;
+    std::cout << n << "\t\t" << calc << "\t\t" << calcDiff << "\t\t" << tick
+              << "\t\t" << reference / (calc + calcDiff) << std::endl;
+  }
+}
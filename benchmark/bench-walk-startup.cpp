@@ -0,0 +1,89 @@
+#include <cassert>
+#include <chrono>
+#include <example-robot-data/path.hpp>
+#include <iostream>
+#include <limits>
+#include <pinocchio/parsers/srdf.hpp>
+#include <pinocchio/parsers/urdf.hpp>
+#include <sobec/fwd.hpp>
+#include <sobec/mpc-walk.hpp>
+#include <sobec/py2cpp.hpp>
+#include <sobec/walk/ocp.hpp>
+
+// Same model as example_robot_data.load("talos_legs"): the joints of the legs
+// and the frames attached to them are copied from the full Talos model.
+pinocchio::Model loadTalosLegs() {
+  const pinocchio::JointIndex legMaxId = 14;
+
+  pinocchio::Model m1;
+  pinocchio::urdf::buildModel(
+      EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/robots/talos_reduced.urdf",
+      pinocchio::JointModelFreeFlyer(), m1);
+  pinocchio::srdf::loadReferenceConfigurations(
+      m1, EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/srdf/talos.srdf", false);
+
+  pinocchio::Model m2;
+  m2.name = "talos";
+  for (pinocchio::JointIndex j = 1; j < legMaxId; ++j) {
+    const pinocchio::JointModel& joint = m1.joints[j];
+    const pinocchio::JointIndex jid = m2.addJoint(
+        m1.parents[j], joint, m1.jointPlacements[j], m1.names[j],
+        m1.effortLimit.segment(joint.idx_v(), joint.nv()),
+        m1.velocityLimit.segment(joint.idx_v(), joint.nv()),
+        m1.lowerPositionLimit.segment(joint.idx_q(), joint.nq()),
+        m1.upperPositionLimit.segment(joint.idx_q(), joint.nq()));
+    assert(jid == j);
+    m2.appendBodyToJoint(jid, m1.inertias[j], pinocchio::SE3::Identity());
+  }
+  m2.upperPositionLimit.head<7>().setConstant(1);
+  m2.lowerPositionLimit.head<7>().setConstant(-1);
+  m2.effortLimit.head<6>().setConstant(std::numeric_limits<double>::infinity());
+
+  for (const pinocchio::Frame& f : m1.frames) {
+    if (f.parent < legMaxId) m2.addFrame(f);
+  }
+  m2.referenceConfigurations["half_sitting"] =
+      m1.referenceConfigurations["half_sitting"].head(m2.nq);
+  return m2;
+}
+
+// Compare the time to get an initialized MPC from the native builder and from
+// the embedded python interpreter (benchmark/mpc_description.py).
+int main() {
+  using namespace sobec;
+  typedef std::chrono::steady_clock Clock;
+
+  std::cout << "*** Benchmark start ***" << std::endl;
+
+  Clock::time_point start = Clock::now();
+  walk::RobotWrapper robot(loadTalosLegs(), "sole_link");
+  walk::WalkParams params(robot.name);
+  const double tmodel =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  boost::shared_ptr<MPCWalk> mpc = walk::buildMPCWalk(robot, params);
+  const double tcpp =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  boost::shared_ptr<MPCWalk> mpcpy =
+      initMPCWalk(PROJECT_SOURCE_DIR "/benchmark/mpc_description.py");
+  const double tpy =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::cout << "Native builder: " << tcpp << " s (model " << tmodel << " s)"
+            << std::endl;
+  std::cout << "Python path:    " << tpy << " s" << std::endl;
+
+  // Both MPC should run the same problem.
+  Eigen::VectorXd x = mpc->problem->get_x0();
+  Eigen::VectorXd xpy = mpcpy->problem->get_x0();
+  std::cout << "Initial state difference: " << (x - xpy).norm() << std::endl;
+  for (int t = 1; t <= 10; t++) {
+    mpc->calc(x, t);
+    x = mpc->solver->get_xs()[1];
+    mpcpy->calc(xpy, t);
+    xpy = mpcpy->solver->get_xs()[1];
+  }
+  std::cout << "State difference after 10 ticks: " << (x - xpy).norm()
+            << std::endl;
+}
@@ -135,6 +135,11 @@ class DifferentialActionModelContactFwdDynamicsTpl
       const boost::shared_ptr<DifferentialActionDataAbstract>& data,
       const Eigen::Ref<const VectorXs>& x, const Eigen::Ref<const VectorXs>& u);
 
+  /**
+   * @brief Indicates whether the contact force derivatives are computed
+   */
+  bool get_enable_force() const;
+
   // /**
   //  * @brief @copydoc Base::quasiStatic()
   //  */
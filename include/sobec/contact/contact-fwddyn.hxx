@@ -118,6 +118,12 @@ void DifferentialActionModelContactFwdDynamicsTpl<Scalar>::calcDiff(
   this->get_costs()->calcDiff(d->costs, x, u);
 }
 
+template <typename Scalar>
+bool DifferentialActionModelContactFwdDynamicsTpl<Scalar>::get_enable_force()
+    const {
+  return enable_force_;
+}
+
 // template <typename Scalar>
 // void DifferentialActionModelContactFwdDynamicsTpl<Scalar>::quasiStatic(
 //     const boost::shared_ptr<DifferentialActionDataAbstract>& data,
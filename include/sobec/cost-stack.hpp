@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_COST_STACK_HPP_
+#define SOBEC_COST_STACK_HPP_
+
+#include <crocoddyl/core/costs/cost-sum.hpp>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sobec {
+
+/// @brief What compileCostStack did to a cost sum.
+struct CostStackReport {
+  /// @brief Costs deactivated because of their zero weight.
+  std::vector<std::string> deactivated;
+  /// @brief Active costs whose residuals read the same pinocchio quantity
+  /// (e.g. "placement of frame 23", "com velocity"), for the quantities read
+  /// by at least two of them.
+  std::map<std::string, std::vector<std::string> > sharedQuantities;
+};
+
+/**
+ * @brief Finalize the costs of a node: the costs with a zero weight are
+ * deactivated, so that calc and calcDiff skip their residuals.
+ *
+ * The costs stay in the sum under their name, so that the handles on their
+ * residuals keep working: use setCostWeight to give them a weight again.
+ */
+CostStackReport compileCostStack(crocoddyl::CostModelSum &costs);
+
+/// @brief Set the weight of a cost, which is active if and only if the weight
+/// is not zero.
+void setCostWeight(crocoddyl::CostModelSum &costs, const std::string &name,
+                   const double weight);
+
+std::ostream &operator<<(std::ostream &os, const CostStackReport &report);
+
+}  // namespace sobec
+
+#endif  // SOBEC_COST_STACK_HPP_
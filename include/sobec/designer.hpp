@@ -2,6 +2,7 @@
 #define SOBEC_DESIGNER
 
 #include <Eigen/Dense>
+#include <cstdint>
 #include <pinocchio/algorithm/model.hpp>
 #include <pinocchio/spatial/se3.hpp>
 #include <string>
@@ -21,6 +22,11 @@ struct RobotDesignerSettings {
 
   std::string leftFootName = "";
   std::string rightFootName = "";
+
+  /// @brief Binary file caching the models built from the description, or
+  /// empty to always build them. The cache is rebuilt when the content of
+  /// the URDF, of the SRDF or the list of controlled joints changes.
+  std::string cachePath = "";
 };
 
 class RobotDesigner {
@@ -42,14 +48,31 @@ class RobotDesigner {
   Eigen::Vector3d LF_position_;
   Eigen::Vector3d RF_position_;
 
+  // Joints supporting the feet, in increasing order.
+  std::vector<pinocchio::JointIndex> feetChain_;
+  bool loadedFromCache_ = false;
+
+  // Parse the description and build the reduced model.
+  void buildModels();
+  // Models cached in settings_.cachePath, if they were built from the
+  // description whose hash is given.
+  bool loadCache(const std::uint64_t hash);
+  void saveCache(const std::uint64_t hash);
+
  public:
   RobotDesigner();
   RobotDesigner(const RobotDesignerSettings &settings);
   void initialize(const RobotDesignerSettings &settings);
   bool initialized_ = false;
 
-  void updateReducedModel(Eigen::VectorXd q);
-  void updateCompleteModel(Eigen::VectorXd q);
+  void updateReducedModel(const Eigen::VectorXd &q);
+  void updateCompleteModel(const Eigen::VectorXd &q);
+  /// @brief Same as updateReducedModel, for the placements of the feet and
+  /// the CoM only: the other frames of the reduced data are not updated. The
+  /// CoM is accumulated in the same pass as the joint placements; without
+  /// it, only the joints supporting the feet are visited.
+  void updateReducedKinematics(const Eigen::Ref<const Eigen::VectorXd> &x,
+                               const bool withCoM = true);
 
   pinocchio::SE3 get_LF_frame();
   pinocchio::SE3 get_RF_frame();
@@ -74,6 +97,9 @@ class RobotDesigner {
   std::vector<unsigned long> get_controlledJointsIDs() {
     return controlled_joints_id_;
   }
+  /// @brief True if the models were loaded from settings.cachePath by the
+  /// last initialize, rather than built from the description.
+  bool get_loadedFromCache() const { return loadedFromCache_; }
 
   Eigen::Vector3d get_LF_position() { return LF_position_; }
   Eigen::Vector3d get_RF_position() { return RF_position_; }
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_DOUBLE_BUFFER_HPP_
+#define SOBEC_DOUBLE_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+namespace sobec {
+
+/**
+ * @brief Lock-free double buffer with one writer and any number of readers.
+ *
+ * The writer fills the slot that is not published, then publishes it.
+ * Readers copy the published slot. Each slot is protected by a sequence
+ * counter (seqlock): a read that overlapped a write of the same slot (only
+ * possible if the writer published twice during the read) is retried.
+ * Neither side blocks, and neither side allocates as long as copying T does
+ * not allocate (e.g. Eigen objects with preallocated sizes).
+ */
+template <typename T>
+class DoubleBuffer {
+ public:
+  DoubleBuffer() : published_(-1), writing_(0) {
+    seq_[0].store(0);
+    seq_[1].store(0);
+  }
+
+  /// @brief Set both slots to a prototype value, to preallocate them.
+  /// Not thread safe: call it before the writer and readers start.
+  void initialize(const T& prototype) {
+    slots_[0] = prototype;
+    slots_[1] = prototype;
+    seq_[0].store(0);
+    seq_[1].store(0);
+    published_.store(-1);
+  }
+
+  /// @brief Writer side: return the slot to fill, to be followed by publish().
+  T& beginWrite() {
+    writing_ = (published_.load(std::memory_order_relaxed) == 0) ? 1 : 0;
+    seq_[writing_].fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slots_[writing_];
+  }
+
+  /// @brief Writer side: make the slot filled since beginWrite() visible.
+  void publish() {
+    seq_[writing_].fetch_add(1, std::memory_order_release);
+    published_.store(writing_, std::memory_order_release);
+  }
+
+  /// @brief Reader side: copy the last published value.
+  /// @return false if nothing has been published yet.
+  bool read(T& out) const {
+    while (true) {
+      const int slot = published_.load(std::memory_order_acquire);
+      if (slot < 0) return false;
+      const std::size_t before = seq_[slot].load(std::memory_order_acquire);
+      if (before & 1) continue;
+      out = slots_[slot];
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_[slot].load(std::memory_order_relaxed) == before) return true;
+    }
+  }
+
+  /// @brief True once a value has been published.
+  bool hasValue() const {
+    return published_.load(std::memory_order_acquire) >= 0;
+  }
+
+ private:
+  DoubleBuffer(const DoubleBuffer&);
+  DoubleBuffer& operator=(const DoubleBuffer&);
+
+  T slots_[2];
+  std::atomic<std::size_t> seq_[2];
+  std::atomic<int> published_;
+  int writing_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_DOUBLE_BUFFER_HPP_
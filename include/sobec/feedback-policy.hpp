@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022 LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_FEEDBACK_POLICY_HPP_
+#define SOBEC_FEEDBACK_POLICY_HPP_
+
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+#include <crocoddyl/core/solvers/ddp.hpp>
+#include <crocoddyl/core/state-base.hpp>
+
+namespace sobec {
+
+/**
+ * @brief Feedback policy of the first node of a DDP solution, to be
+ * evaluated by a control loop running faster than the MPC.
+ *
+ * The first node is split in nsubsteps sub-steps. At sub-step k, with
+ * a = k / nsubsteps, the state reference xref is interpolated between xs[0]
+ * and xs[1] on the state manifold, the feed-forward and the gains are
+ * interpolated linearly between the ones of the two first nodes, and
+ * u = uff - K * diff(xref, x).
+ *
+ * update() copies the solution into buffers allocated by initialize(): once
+ * initialized, neither update() nor calc() allocate.
+ */
+class FeedbackPolicy {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  FeedbackPolicy();
+
+  void initialize(boost::shared_ptr<crocoddyl::StateAbstract> state,
+                  const std::size_t nu, const int nsubsteps);
+
+  /// @brief Copy the two first nodes of the solution, after each MPC tick.
+  void update(const crocoddyl::SolverDDP& solver);
+
+  /// @brief Control at sub-step k (clamped to [0, nsubsteps]) of the first
+  /// node, for the measured state x.
+  void calc(const int k, const Eigen::Ref<const Eigen::VectorXd>& x,
+            Eigen::Ref<Eigen::VectorXd> u);
+  /// @brief Same as above, the result is stored in an internal buffer.
+  const Eigen::VectorXd& calc(const int k,
+                              const Eigen::Ref<const Eigen::VectorXd>& x);
+
+  int get_nsubsteps() const { return nsubsteps_; }
+  const Eigen::VectorXd& get_xs0() const { return xs0_; }
+  const Eigen::VectorXd& get_us0() const { return us0_; }
+  const Eigen::MatrixXd& get_K0() const { return K0_; }
+  /// @brief Interpolated state reference of the last call to calc.
+  const Eigen::VectorXd& get_xref() const { return xref_; }
+
+ protected:
+  boost::shared_ptr<crocoddyl::StateAbstract> state_;
+  int nsubsteps_;
+  Eigen::VectorXd xs0_;
+  Eigen::VectorXd us0_;
+  Eigen::VectorXd us1_;
+  Eigen::MatrixXd K0_;
+  Eigen::MatrixXd K1_;
+  /// @brief diff(xs[0], xs[1]), computed once by update().
+  Eigen::VectorXd dx01_;
+
+  // Buffers of calc.
+  Eigen::VectorXd xref_;
+  Eigen::VectorXd dx_;
+  Eigen::MatrixXd K_;
+  Eigen::VectorXd u_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_FEEDBACK_POLICY_HPP_
@@ -2,6 +2,7 @@
 #define SOBEC_HORIZON_MANAGER
 
 #include <Eigen/Dense>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,56 @@ struct HorizonManagerSettings {
  public:
   std::string leftFootName = "left_sole_link";
   std::string rightFootName = "right_sole_link";
+  // Threads used to evaluate the nodes, the crocoddyl default is kept if < 1.
+  int nthreads = 0;
+  // Costs resolved into the handles of each node (a node may lack some).
+  std::string placementLFName = "placement_LF";
+  std::string placementRFName = "placement_RF";
+  std::string comVelocityName = "comVelocity";
+  std::string actuationName = "actuationTask";
+  std::string wrenchLFName = "wrench_LF";
+  std::string wrenchRFName = "wrench_RF";
+};
+
+// Row-major buffers with one row per node, as numpy arrays are laid out.
+// Poses are stored as (x, y, z, qx, qy, qz, qw), the quaternion being
+// normalized when it is read.
+typedef Eigen::Matrix<double, Eigen::Dynamic, 7, Eigen::RowMajor> HorizonPoses;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>
+    HorizonVectors3;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 6, Eigen::RowMajor>
+    HorizonWrenches;
+
+/// @brief Typed handles on the costs and contacts of one node, resolved once
+/// from their names. A handle is null if the node has no such cost.
+struct NodeHandles {
+  ResidualModelFramePlacementPtr placementLF;
+  ResidualModelFramePlacementPtr placementRF;
+  boost::shared_ptr<ResidualModelCoMVelocity> comVelocity;
+  boost::shared_ptr<crocoddyl::ResidualModelControl> actuation;
+  ResidualModelContactWrenchConePtr wrenchConeLF;
+  ResidualModelContactWrenchConePtr wrenchConeRF;
+  ActivationModelQuadRefPtr wrenchActivationLF;
+  ActivationModelQuadRefPtr wrenchActivationRF;
+  Contact contacts;
+  // Buffers for the activation references of the wrench cones, sized when
+  // the handles are resolved.
+  Eigen::VectorXd wrenchReferenceLF;
+  Eigen::VectorXd wrenchReferenceRF;
+};
+
+/// @brief State of the nodes of a horizon, shared by the copies of a
+/// HorizonManager along with its solver, so that the handles follow the nodes
+/// whichever copy recedes the horizon.
+struct HorizonNodes {
+  // Handles of the running nodes, in a ring that recedes with the horizon:
+  // node time is handles[(head + time) % handles.size()].
+  std::vector<NodeHandles> handles;
+  unsigned long head = 0;
+  // Handles of the models the horizon receded with, resolved once per model.
+  std::map<AMA, NodeHandles> modelHandles;
+  // Datas of the pooled models, recycled by the pool-backed recede.
+  std::map<AMA, std::vector<ADA> > dataPool;
 };
 
 class HorizonManager {
@@ -22,10 +73,21 @@ class HorizonManager {
   DDP ddp_;
 
   // prealocated memory:
-  boost::shared_ptr<crocoddyl::CostModelResidual> cone_;
   std::vector<Eigen::VectorXd> warm_xs_;
   std::vector<Eigen::VectorXd> warm_us_;
-  Eigen::VectorXd new_ref_;
+  // Horizon length the solver workspace was allocated for.
+  unsigned long allocated_size_ = 0;
+
+  boost::shared_ptr<HorizonNodes> nodes_;
+  NodeHandles &nodeHandles(const unsigned long &time) {
+    return nodes_->handles[(nodes_->head + time) % nodes_->handles.size()];
+  }
+  const NodeHandles &modelHandles(const AMA &model);
+
+  ADA acquireData(const AMA &model);
+  void releaseData(const AMA &model, const ADA &data);
+  void append(const AMA &new_model, const ADA &new_data,
+              const NodeHandles &new_handles);
 
  public:
   HorizonManager();
@@ -50,6 +112,42 @@ class HorizonManager {
   Contact contacts(const unsigned long &time);
   boost::shared_ptr<crocoddyl::StateMultibody> state(const unsigned long &time);
 
+  /// @brief Resolve the named costs and contacts of all the nodes into
+  /// handles. Done by initialize; to be called again if the nodes are changed
+  /// other than through recede, or if the models given to recede are.
+  void registerHandles();
+  NodeHandles resolveHandles(const AMA &model) const;
+  const NodeHandles &handles(const unsigned long &time) const {
+    return nodes_->handles[(nodes_->head + time) % nodes_->handles.size()];
+  }
+
+  // Setters through the handles, without any lookup.
+  void setActuationReference(const unsigned long &time,
+                             const Eigen::VectorXd &reference);
+  void setPoseReferenceLF(const unsigned long &time,
+                          const pinocchio::SE3 &ref_placement);
+  void setPoseReferenceRF(const unsigned long &time,
+                          const pinocchio::SE3 &ref_placement);
+  void setVelocityRefCOM(const unsigned long &time,
+                         const eVector3 &ref_velocity);
+  void setForceReferenceLF(const unsigned long &time,
+                           const eVector6 &reference);
+  void setForceReferenceRF(const unsigned long &time,
+                           const eVector6 &reference);
+
+  // Bulk setters: row t of the buffer is the reference of node t, for the
+  // first rows() nodes of the horizon.
+  void setPoseReferencesLF(const Eigen::Ref<const HorizonPoses> &poses);
+  void setPoseReferencesRF(const Eigen::Ref<const HorizonPoses> &poses);
+  void setVelocityRefsCOM(const Eigen::Ref<const HorizonVectors3> &velocities);
+  void setForceReferencesLF(const Eigen::Ref<const HorizonWrenches> &wrenches);
+  void setForceReferencesRF(const Eigen::Ref<const HorizonWrenches> &wrenches);
+
+  /// @brief Set the weight of a cost of node time, which is active if and
+  /// only if the weight is not zero (see compileCostStack).
+  void setCostWeight(const unsigned long &time, const std::string &nameCost,
+                     const double weight);
+
   void setActuationReference(const unsigned long &time,
                              const std::string &nameCostActuation,
                              const Eigen::VectorXd &reference);
@@ -94,18 +192,41 @@ class HorizonManager {
                         const std::string &nameContactLF,
                         const std::string &nameContactRF);
 
+  /// @brief The handles of new_model are resolved at its first recede only.
   void recede(const AMA &new_model, const ADA &new_data);
+  /// @brief Same, with the handles of new_model (e.g. those of a cycle).
+  void recede(const AMA &new_model, const ADA &new_data,
+              const NodeHandles &new_handles);
+  /// @brief Pool-backed recede: the data of new_model is taken from the pool,
+  /// and the data of the leaving node is given back to it. A model that was
+  /// not given to reserveData is pooled at its first recede (with a warning),
+  /// so that its datas are recycled from then on.
+  void recede(const AMA &new_model, const NodeHandles &new_handles);
   void recede(const AMA &new_model);
   void recede();
+  /// @brief Add the models (e.g. those of a gait cycle) to the pool, with one
+  /// data per occurrence in models, so that receding with them does not
+  /// allocate.
+  void reserveData(const std::vector<AMA> &models);
 
   unsigned long size();
 
+  /// @brief Solve from the previous solution shifted by one node. The solver
+  /// workspace and the warm start buffers are kept across the calls, and only
+  /// reallocated when the horizon length changes.
   void solve(const Eigen::VectorXd &measured_x, const std::size_t &ddpIteration,
              const bool &is_feasible = false);
   Eigen::VectorXd currentTorques(const Eigen::VectorXd &measured_x);
 
   DDP get_ddp() { return ddp_; }
-  void set_ddp(const DDP &ddp) { ddp_ = ddp; }
+  void set_ddp(const DDP &ddp) {
+    ddp_ = ddp;
+    nodes_ = boost::make_shared<HorizonNodes>();
+    if (settings_.nthreads > 0)
+      ddp_->get_problem()->set_nthreads(settings_.nthreads);
+    allocated_size_ = size();
+    registerHandles();
+  }
 };
 }  // namespace sobec
 #endif  // SOBEC_HORIZON_MANAGER
@@ -69,6 +69,13 @@ class IntegratedActionModelLPFTpl : public ActionModelAbstractTpl<_Scalar> {
       const;
   const Scalar& get_dt() const;
   const Scalar& get_fc() const;
+  bool get_with_cost_residual() const;
+  bool get_tau_plus_integration() const;
+  int get_filter() const;
+  bool get_is_terminal() const;
+  const Scalar& get_control_reg_weight() const;
+  const VectorXs& get_control_reg_reference() const;
+  const Scalar& get_control_lim_weight() const;
 
   void set_dt(const Scalar& dt);
   void set_fc(const Scalar& fc);
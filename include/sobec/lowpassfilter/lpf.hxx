@@ -463,6 +463,44 @@ const Scalar& IntegratedActionModelLPFTpl<Scalar>::get_fc() const {
   return fc_;
 }
 
+template <typename Scalar>
+bool IntegratedActionModelLPFTpl<Scalar>::get_with_cost_residual() const {
+  return with_cost_residual_;
+}
+
+template <typename Scalar>
+bool IntegratedActionModelLPFTpl<Scalar>::get_tau_plus_integration() const {
+  return tau_plus_integration_;
+}
+
+template <typename Scalar>
+int IntegratedActionModelLPFTpl<Scalar>::get_filter() const {
+  return filter_;
+}
+
+template <typename Scalar>
+bool IntegratedActionModelLPFTpl<Scalar>::get_is_terminal() const {
+  return is_terminal_;
+}
+
+template <typename Scalar>
+const Scalar& IntegratedActionModelLPFTpl<Scalar>::get_control_reg_weight()
+    const {
+  return wreg_;
+}
+
+template <typename Scalar>
+const typename MathBaseTpl<Scalar>::VectorXs&
+IntegratedActionModelLPFTpl<Scalar>::get_control_reg_reference() const {
+  return wref_;
+}
+
+template <typename Scalar>
+const Scalar& IntegratedActionModelLPFTpl<Scalar>::get_control_lim_weight()
+    const {
+  return wlim_;
+}
+
 template <typename Scalar>
 void IntegratedActionModelLPFTpl<Scalar>::set_dt(const Scalar& dt) {
   if (dt < 0.) {
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "sobec/cost-stack.hpp"
 #include "sobec/designer.hpp"
 #include "sobec/fwd.hpp"
 
@@ -45,7 +46,28 @@ struct ModelMakerSettings {
 
   double th_stop = 1e-6;  // threshold for stopping criterion
   double th_grad = 1e-9;  // threshold for zero gradient.
+
+  // Threads building the nodes in formulateHorizon, the hardware concurrency
+  // if < 1.
+  int nthreads = 1;
+};
+/**
+ * @brief Parts of the nodes which hold no reference, so that they are never
+ * modified once built, and are shared by all the nodes made from the same
+ * settings. Each node only owns its contacts and the costs with a reference.
+ */
+struct NodePrototype {
+  boost::shared_ptr<crocoddyl::ResidualModelContactWrenchCone>
+      residual_LF_Wrench, residual_RF_Wrench;
+  // Reference of the wrench cone activations, indexed by Support.
+  Eigen::VectorXd refCost_LF[3], refCost_RF[3];
+  boost::shared_ptr<crocoddyl::ActivationModelQuadFlatLog> activationTracking;
+  boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad> activationPosture;
+  boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad>
+      activationActuation;
+  boost::shared_ptr<crocoddyl::CostModelAbstract> jointLimits;
 };
+
 class ModelMaker {
  private:
   ModelMakerSettings settings_;
@@ -55,6 +77,15 @@ class ModelMaker {
   boost::shared_ptr<crocoddyl::ActuationModelFloatingBase> actuation_;
   Eigen::VectorXd x0_;
 
+  // Rebuilt from the settings by formulateStepTracker and formulateHorizon,
+  // so that the settings may be changed between two formulations.
+  boost::shared_ptr<const NodePrototype> prototype_;
+  void updatePrototype();
+  const NodePrototype &prototype();
+  AMA formulateStepTrackerNode(const Support &support,
+                               CostStackReport &report);
+  std::vector<CostStackReport> costStackReports_;
+
  public:
   ModelMaker();
   ModelMaker(const ModelMakerSettings &settings, const RobotDesigner &design);
@@ -66,9 +97,16 @@ class ModelMaker {
   // AMA formulate_flat_walker(const Support &support = Support::DOUBLE);
   AMA formulate_stair_climber(const Support &support = Support::DOUBLE);
 
+  /// @brief One node per support, built by settings.nthreads threads. The
+  /// nodes are in the order of the supports whatever the thread count.
   std::vector<AMA> formulateHorizon(const std::vector<Support> &supports);
   std::vector<AMA> formulateHorizon(const int &T);
   ModelMakerSettings &get_settings() { return settings_; }
+  /// @brief What compileCostStack did to each node of the last formulation
+  /// (formulateStepTracker or formulateHorizon), in the order of the nodes.
+  const std::vector<CostStackReport> &get_costStackReports() const {
+    return costStackReports_;
+  }
 
   // formulation parts:
   void defineFeetContact(Contact &contactCollector,
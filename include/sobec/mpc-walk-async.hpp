@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022 LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_MPC_WALK_ASYNC_HPP_
+#define SOBEC_MPC_WALK_ASYNC_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "sobec/double-buffer.hpp"
+#include "sobec/mpc-walk.hpp"
+
+namespace sobec {
+
+/**
+ * @brief First node of an MPC solution, as published by MPCWalkAsync.
+ *
+ * The control to apply to a measured state x is us0 - K0 * diff(xs0, x).
+ */
+struct MPCWalkPolicySnapshot {
+  typedef std::chrono::steady_clock Clock;
+
+  Eigen::VectorXd xs0;
+  Eigen::VectorXd us0;
+  Eigen::MatrixXd K0;
+  /// @brief MPC tick the policy was computed for.
+  int t;
+  /// @brief Time at which the state used by the solver was posted.
+  Clock::time_point timestamp;
+  /// @brief Duration of the solve, in seconds.
+  double solveDuration;
+};
+
+/**
+ * @brief Statistics of an MPCWalkAsync run. Ages are in seconds, measured
+ * when the control thread reads a snapshot with getPolicy().
+ */
+struct MPCWalkAsyncStatistics {
+  /// @brief Number of states posted with setState().
+  std::size_t requests;
+  /// @brief Number of solves completed by the worker.
+  std::size_t solves;
+  /// @brief Number of posted states overwritten before the worker took them.
+  std::size_t missed;
+  /// @brief Number of solves that threw an exception.
+  std::size_t failed;
+  double lastAge;
+  double meanAge;
+  double maxAge;
+};
+
+/**
+ * @brief Run MPCWalk::calc in a dedicated worker thread.
+ *
+ * The control thread posts the measured state with setState() and reads the
+ * latest policy with getPolicy(). Both calls are lock-free, do not wait for
+ * the solver and do not allocate. The worker always solves from the most
+ * recent posted state; a state overwritten before the worker took it is
+ * counted as a missed solve.
+ *
+ * While running, the worker owns the MPCWalk object: do not touch it (nor
+ * its problem or solver) from another thread until stop() returns. The
+ * solver callbacks are called from the worker thread.
+ */
+class MPCWalkAsync {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  explicit MPCWalkAsync(boost::shared_ptr<MPCWalk> mpc);
+  virtual ~MPCWalkAsync();
+
+  /// @brief Start the worker. MPCWalk::initialize must have been called.
+  void start();
+  /// @brief Stop the worker, waiting for the on-going solve to finish.
+  void stop();
+  bool isRunning() const { return running_.load(); }
+
+  /// @brief Post the measured state for MPC tick t (control thread).
+  void setState(const Eigen::Ref<const Eigen::VectorXd>& x, const int t);
+  /// @brief Copy the last published policy (control thread).
+  /// @return false if no solve has been completed yet.
+  bool getPolicy(MPCWalkPolicySnapshot& policy);
+
+  /// @brief Statistics, to be read from the control thread.
+  MPCWalkAsyncStatistics get_statistics() const;
+  void resetStatistics();
+
+ public:
+  boost::shared_ptr<MPCWalk> mpc;
+
+ protected:
+  struct Request {
+    Eigen::VectorXd x;
+    int t;
+    std::size_t id;
+    Clock::time_point timestamp;
+  };
+
+  void run();
+
+  DoubleBuffer<Request> requests_;
+  DoubleBuffer<MPCWalkPolicySnapshot> policies_;
+
+  std::thread worker_;
+  std::atomic<bool> running_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+
+  /// @brief Id of the last posted request, only written by the control thread.
+  std::atomic<std::size_t> posted_;
+  /// @brief Id of the last request taken by the worker.
+  std::atomic<std::size_t> consumed_;
+  std::atomic<std::size_t> solves_;
+  std::atomic<std::size_t> missed_;
+  std::atomic<std::size_t> failed_;
+
+  // Snapshot ages, only accessed by the control thread.
+  std::size_t reads_;
+  double lastAge_;
+  double sumAge_;
+  double maxAge_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_MPC_WALK_ASYNC_HPP_
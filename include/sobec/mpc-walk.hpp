@@ -14,8 +14,11 @@
 #include <crocoddyl/multibody/fwd.hpp>
 //#include <crocoddyl/multibody/data/multibody.hpp>
 #include <crocoddyl/multibody/states/multibody.hpp>
+#include <map>
 
+#include "sobec/feedback-policy.hpp"
 #include "sobec/fwd.hpp"
+#include "sobec/tick-profiler.hpp"
 
 namespace sobec {
 using namespace crocoddyl;
@@ -43,10 +46,31 @@ class MPCWalk {
                   const std::vector<Eigen::VectorXd>& us);
 
   /// @brief calc the OCP solution. Init must be called first.
+  /// Once initialized, a call to calc does not allocate any memory, except
+  /// with compactStorage when the node entering the horizon has other
+  /// contacts or costs than the node leaving it.
   void calc(const Eigen::Ref<const VectorXd>& x, const int t);
 
   /////// INTERNALS
   void updateTerminalCost(const int t);
+  /// @brief Storage node used at node k of the MPC timeline: the start phase
+  /// is used once, then the gait cycle 2*(Tsingle+Tdouble) is repeated.
+  int scheduledNode(const int k) const;
+  /// @brief Keep in storage only the nodes returned by scheduledNode.
+  void compactStorageNodes();
+  /// @brief Create the datas of this MPC for the storage nodes it uses.
+  void createStorageDatas();
+  /// @brief Data for the node model entering the horizon, taken from the
+  /// node leaving it when possible (compactStorage on a uniform horizon).
+  boost::shared_ptr<ActionDataAbstract> recycleData(
+      const ActionPtr& model) const;
+  /// @brief Build the coarse version of the storage nodes.
+  void buildCoarseModels();
+  /// @brief Set the nodes of a non-uniform horizon starting after tick t.
+  void updateHorizonNodes(const int t);
+  /// @brief Shift the previous solution by one storage node, interpolating
+  /// the states that fall inside a coarse node.
+  void shiftWarmStart();
   void findTerminalStateResidualModel();
   void findStateModel();
 
@@ -67,9 +91,24 @@ class MPCWalk {
   void set_Tend(const int v) { Tend = v; }
   int get_Tend() { return Tend; }
 
+  /// @brief Duration of the horizon, in number of storage nodes.
+  int get_horizonTicks() const {
+    return coarseStride > 1 ? Tfine + (Tmpc - Tfine) * coarseStride : Tmpc;
+  }
+
   void set_vcomRef(const Eigen::Ref<const Vector3d>& v) { vcomRef = v; }
   const Vector3d& get_vcomRef() { return vcomRef; }
 
+  /// @brief True if the last call to calc was stopped by solver_deadline.
+  bool get_deadlineHit() const { return deadlineHit; }
+  /// @brief Number of iterations done in the last call to calc.
+  int get_iterations() const { return iterations; }
+  /// @brief Predicted duration of one solver iteration (s), estimated while
+  /// solver_deadline is set.
+  double get_iterationTime() const {
+    return profiledSolver ? profiledSolver->get_iterationTime() : 0.;
+  }
+
  public:
   /// @brief reference COM velocity
   Vector3d vcomRef;
@@ -87,12 +126,41 @@ class MPCWalk {
   int Tend;
   /// @brief timestep in problem shooting nodes
   double DT;
+  /// @brief Number of nodes of duration DT at the beginning of the horizon.
+  /// The Tmpc-Tfine last nodes are coarse nodes, integrated over
+  /// coarseStride*DT. Unused when coarseStride is 1 (uniform horizon).
+  int Tfine;
+  /// @brief Duration of the coarse nodes, in number of storage nodes.
+  /// Coarse nodes are only supported for Euler integrated models.
+  int coarseStride;
   /// @brief stop threshold to configure the solver
   double solver_th_stop;
   /// @brief solver param reg_min
   double solver_reg_min;
   /// @brief Solver max number of iteration
   int solver_maxiter;
+  /// @brief Wall-clock budget of a call to calc, in seconds (0 to disable),
+  /// counted from the start of calc. The solver does not start an iteration
+  /// that is predicted to end after the deadline. At least one iteration is
+  /// always done, and a solve stopped by the deadline returns a feasible
+  /// solution.
+  double solver_deadline;
+  /// @brief Number of threads used to evaluate the shooting nodes (the
+  /// crocoddyl default is kept if < 1). Unless compactStorage is set, the
+  /// MPC holds one data per storage node, so Tmpc must not exceed the cycle
+  /// length 2*(Tsingle+Tdouble) for the nodes of the horizon to own distinct
+  /// datas.
+  int nthreads;
+  /// @brief If true, initialize() keeps a single instance of each node the
+  /// MPC can schedule (the start phase and one gait cycle) in storage, and
+  /// releases the other nodes of the OCP along with their datas. The datas
+  /// of the compact storage are placeholders, not to be used. On a uniform
+  /// horizon, the MPC then only holds the datas of its Tmpc nodes: the data
+  /// of the node leaving the horizon is recycled by the entering node when
+  /// they have the same contacts and costs, otherwise calc creates one.
+  bool compactStorage;
+  /// @brief Number of control sub-steps in one node, used by policy.
+  int policySubsteps;
 
   /// @brief name of the regularization cost that is modified by mpc update.
   std::string stateRegCostName;
@@ -112,16 +180,43 @@ class MPCWalk {
   /// @brief Keep a direct reference to the terminal state
   boost::shared_ptr<StateMultibody> state;
 
+  /// @brief Feedback policy of the first node, updated by each call to calc,
+  /// to be evaluated at each of the policySubsteps control sub-steps.
+  FeedbackPolicy policy;
+
+  /// @brief Latency histograms of the phases of calc (disabled by default,
+  /// set profiler.enabled to record them).
+  TickProfiler profiler;
+
  protected:
+  /// @brief Same object as solver, recording its phases in profiler.
+  boost::shared_ptr<SolverFDDPProfiled> profiledSolver;
   double reg;
+  bool deadlineHit;
+  int iterations;
+  /// @brief Warm-start buffers, allocated once in initialize().
+  std::vector<Eigen::VectorXd> xs_guess;
+  std::vector<Eigen::VectorXd> us_guess;
+  /// @brief Buffer for the terminal state reference.
+  VectorXd xref;
+  /// @brief Buffer for the interpolation of the warm start.
+  VectorXd dx_guess;
+  /// @brief Datas of the storage nodes used by this MPC (null for the nodes
+  /// that are never scheduled), distinct from the datas of storage. Empty
+  /// when the datas are recycled along the horizon.
+  std::vector<boost::shared_ptr<ActionDataAbstract> > storageDatas;
+  /// @brief Layout of the datas of each storage node, used to recycle them
+  /// along the horizon: nodes of the same layout can swap their datas.
+  std::map<const ActionModelAbstract*, std::size_t> dataLayouts;
+  boost::shared_ptr<ActionDataAbstract> terminalData;
+  /// @brief Start of each node in the horizon, in number of storage nodes.
+  std::vector<int> nodeOffsets;
+  /// @brief Coarse version of each storage node that can be scheduled, with
+  /// its own data.
+  ActionList coarseModels;
+  std::vector<boost::shared_ptr<ActionDataAbstract> > coarseDatas;
 };
 
 }  // namespace sobec
 
-/* --- Details -------------------------------------------------------------- */
-/* --- Details -------------------------------------------------------------- */
-/* --- Details -------------------------------------------------------------- */
-
-#include "sobec/mpc-walk.hxx"
-
 #endif  // SOBEC_MPC_WALK_HPP_
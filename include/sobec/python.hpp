@@ -24,6 +24,7 @@ void exposeDAMContactFwdDyn();
 void exposeResidualContactForce();
 void exposeWBC();
 void exposeMPCWalk();
+void exposeTrace();
 
 }  // namespace python
 }  // namespace sobec
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_REFERENCE_RING_HPP_
+#define SOBEC_REFERENCE_RING_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace sobec {
+
+/**
+ * @brief References of the nodes of a receding horizon, with the nodes whose
+ * reference must be written again in the costs (dirty nodes).
+ *
+ * The references are stored in a ring that recedes with the horizon: node t
+ * is at slot (head + t) % size. Receding is O(1), the new last node takes the
+ * reference of the previous last one and is dirty, since its costs come from
+ * a new model. Setting a reference makes its node dirty, and flush() visits
+ * the dirty nodes only. Nothing allocates after initialize().
+ */
+template <typename T>
+class ReferenceRing {
+ public:
+  ReferenceRing() : head_(0) {}
+
+  /// @brief Set all the nodes to value, all of them being dirty.
+  void initialize(const std::size_t size, const T& value) {
+    values_.assign(size, value);
+    isDirty_.assign(size, false);
+    dirty_.clear();
+    dirty_.reserve(size);
+    head_ = 0;
+    markAllDirty();
+  }
+
+  /// @brief Change the number of nodes, e.g. for a new horizon. The first
+  /// nodes keep their reference, the new ones take the reference of the last
+  /// node (value if there is none), and all the nodes are dirty.
+  void resize(const std::size_t size, const T& value) {
+    std::vector<T> values = toVector();
+    const T last = values.empty() ? value : values.back();
+    values.resize(size, last);
+    initialize(size, last);
+    values_.swap(values);
+  }
+
+  std::size_t size() const { return values_.size(); }
+
+  const T& operator[](const std::size_t time) const {
+    return values_[slot(time)];
+  }
+
+  void set(const std::size_t time, const T& value) {
+    values_[slot(time)] = value;
+    markDirty(slot(time));
+  }
+
+  /// @brief Set the references of the first values.size() nodes.
+  void set(const std::vector<T>& values) {
+    for (std::size_t time = 0; time < values.size() && time < size(); time++)
+      set(time, values[time]);
+  }
+
+  /// @brief The references in the order of the nodes.
+  std::vector<T> toVector() const {
+    std::vector<T> values;
+    values.reserve(size());
+    for (std::size_t time = 0; time < size(); time++)
+      values.push_back((*this)[time]);
+    return values;
+  }
+
+  /// @brief Node t takes the reference of node t + 1.
+  void recede() {
+    if (values_.empty()) return;
+    const std::size_t last = slot(size() - 1);
+    // The slot of the leaving node becomes the last node.
+    values_[head_] = values_[last];
+    markDirty(head_);
+    head_ = (head_ + 1) % size();
+  }
+
+  void markAllDirty() {
+    for (std::size_t s = 0; s < size(); s++) markDirty(s);
+  }
+
+  std::size_t nbDirty() const { return dirty_.size(); }
+
+  /// @brief Call f(time, reference) for each dirty node, which becomes clean.
+  template <typename F>
+  void flush(F f) {
+    for (const std::size_t s : dirty_) {
+      f((s + size() - head_) % size(), values_[s]);
+      isDirty_[s] = false;
+    }
+    dirty_.clear();
+  }
+
+ private:
+  std::size_t slot(const std::size_t time) const {
+    return (head_ + time) % size();
+  }
+
+  void markDirty(const std::size_t s) {
+    if (isDirty_[s]) return;
+    isDirty_[s] = true;
+    dirty_.push_back(s);
+  }
+
+  std::vector<T> values_;
+  std::vector<bool> isDirty_;
+  std::vector<std::size_t> dirty_;
+  std::size_t head_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_REFERENCE_RING_HPP_
@@ -150,7 +150,7 @@ class ResidualModelCoMVelocityTpl : public ResidualModelAbstractTpl<_Scalar> {
 
  private:
   Vector3s vref_;  //!< Reference CoM velocity
-  typename StateMultibody::PinocchioModel
+  boost::shared_ptr<typename StateMultibody::PinocchioModel>
       pin_model_;  //!< Pinocchio model used for internal computations
 };
 
@@ -20,14 +20,14 @@ ResidualModelCoMVelocityTpl<Scalar>::ResidualModelCoMVelocityTpl(
     const std::size_t nu)
     : Base(state, 3, nu, true, true, false),
       vref_(vref),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelCoMVelocityTpl<Scalar>::ResidualModelCoMVelocityTpl(
     boost::shared_ptr<StateMultibody> state, const Vector3s& vref)
     : Base(state, 3, true, true, false),
       vref_(vref),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelCoMVelocityTpl<Scalar>::~ResidualModelCoMVelocityTpl() {}
@@ -43,7 +43,7 @@ void ResidualModelCoMVelocityTpl<Scalar>::calc(
   const Eigen::VectorBlock<const Eigen::Ref<const VectorXs>, Eigen::Dynamic> v =
       x.tail(state_->get_nv());
 
-  pinocchio::centerOfMass(pin_model_, *d->pinocchio, q, v);
+  pinocchio::centerOfMass(*pin_model_, *d->pinocchio, q, v);
   data->r = d->pinocchio->vcom[0] - vref_;
 }
 
@@ -59,7 +59,7 @@ void ResidualModelCoMVelocityTpl<Scalar>::calcDiff(
 
   const std::size_t nv = state_->get_nv();
 
-  pinocchio::getCenterOfMassVelocityDerivatives(pin_model_, *d->pinocchio,
+  pinocchio::getCenterOfMassVelocityDerivatives(*pin_model_, *d->pinocchio,
                                                 d->dvcom_dq);
   data->Rx.leftCols(nv) = d->dvcom_dq;
   data->Rx.rightCols(nv) = d->pinocchio->Jcom;
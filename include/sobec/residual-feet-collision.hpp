@@ -111,7 +111,7 @@ class ResidualModelFeetCollisionTpl : public ResidualModelAbstractTpl<_Scalar> {
  private:
   pinocchio::FrameIndex frame_id1;
   pinocchio::FrameIndex frame_id2;
-  typename StateMultibody::PinocchioModel
+  boost::shared_ptr<typename StateMultibody::PinocchioModel>
       pin_model_;  //!< Pinocchio model used for internal computations
 };
 
@@ -22,7 +22,7 @@ ResidualModelFeetCollisionTpl<Scalar>::ResidualModelFeetCollisionTpl(
     : Base(state, 1, nu, true, false, false),
       frame_id1(frame_id1),
       frame_id2(frame_id2),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelFeetCollisionTpl<Scalar>::ResidualModelFeetCollisionTpl(
@@ -32,7 +32,7 @@ ResidualModelFeetCollisionTpl<Scalar>::ResidualModelFeetCollisionTpl(
     : Base(state, 1, true, false, false),
       frame_id1(frame_id1),
       frame_id2(frame_id2),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelFeetCollisionTpl<Scalar>::~ResidualModelFeetCollisionTpl() {}
@@ -46,8 +46,8 @@ void ResidualModelFeetCollisionTpl<Scalar>::calc(
 
   Data* d = static_cast<Data*>(data.get());
 
-  pinocchio::updateFramePlacement(pin_model_, *d->pinocchio, frame_id1);
-  pinocchio::updateFramePlacement(pin_model_, *d->pinocchio, frame_id2);
+  pinocchio::updateFramePlacement(*pin_model_, *d->pinocchio, frame_id1);
+  pinocchio::updateFramePlacement(*pin_model_, *d->pinocchio, frame_id2);
 
   const typename MathBase::Vector3s& p1 =
       d->pinocchio->oMf[frame_id1].translation();
@@ -68,9 +68,9 @@ void ResidualModelFeetCollisionTpl<Scalar>::calcDiff(
   // Eigen::Ref<const VectorXs>, Eigen::Dynamic> v = x.tail(state_->get_nv());
 
   const std::size_t nv = state_->get_nv();
-  pinocchio::getFrameJacobian(pin_model_, *d->pinocchio, frame_id1,
+  pinocchio::getFrameJacobian(*pin_model_, *d->pinocchio, frame_id1,
                               pinocchio::LOCAL_WORLD_ALIGNED, d->J1);
-  pinocchio::getFrameJacobian(pin_model_, *d->pinocchio, frame_id2,
+  pinocchio::getFrameJacobian(*pin_model_, *d->pinocchio, frame_id2,
                               pinocchio::LOCAL_WORLD_ALIGNED, d->J2);
 
   d->dJ = d->J1.template topRows<2>() - d->J2.template topRows<2>();
@@ -120,7 +120,7 @@ class ResidualModelFlyHighTpl : public ResidualModelAbstractTpl<_Scalar> {
  private:
   pinocchio::FrameIndex frame_id;
   Scalar slope;  // multiplication in front of the altitude in the cost
-  typename StateMultibody::PinocchioModel
+  boost::shared_ptr<typename StateMultibody::PinocchioModel>
       pin_model_;  //!< Pinocchio model used for internal computations
 };
 
@@ -22,7 +22,7 @@ ResidualModelFlyHighTpl<Scalar>::ResidualModelFlyHighTpl(
     : Base(state, 2, nu, true, true, false),
       frame_id(frame_id),
       slope(slope),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelFlyHighTpl<Scalar>::ResidualModelFlyHighTpl(
@@ -31,7 +31,7 @@ ResidualModelFlyHighTpl<Scalar>::ResidualModelFlyHighTpl(
     : Base(state, 2, true, true, false),
       frame_id(frame_id),
       slope(slope),
-      pin_model_(*state->get_pinocchio()) {}
+      pin_model_(state->get_pinocchio()) {}
 
 template <typename Scalar>
 ResidualModelFlyHighTpl<Scalar>::~ResidualModelFlyHighTpl() {}
@@ -45,8 +45,8 @@ void ResidualModelFlyHighTpl<Scalar>::calc(
 
   Data* d = static_cast<Data*>(data.get());
 
-  pinocchio::updateFramePlacement(pin_model_, *d->pinocchio, frame_id);
-  data->r = pinocchio::getFrameVelocity(pin_model_, *d->pinocchio, frame_id,
+  pinocchio::updateFramePlacement(*pin_model_, *d->pinocchio, frame_id);
+  data->r = pinocchio::getFrameVelocity(*pin_model_, *d->pinocchio, frame_id,
                                         pinocchio::LOCAL_WORLD_ALIGNED)
                 .linear()
                 .head(2);
@@ -72,10 +72,10 @@ void ResidualModelFlyHighTpl<Scalar>::calcDiff(
    * Then r' = v'/e - r/2 z' = R l_v'/e - l_v x Jr/e - r/2 z'
    */
 
-  pinocchio::getFrameVelocityDerivatives(pin_model_, *d->pinocchio, frame_id,
+  pinocchio::getFrameVelocityDerivatives(*pin_model_, *d->pinocchio, frame_id,
                                          pinocchio::LOCAL, d->l_dnu_dq,
                                          d->l_dnu_dv);
-  const Vector3s& v = pinocchio::getFrameVelocity(pin_model_, *d->pinocchio,
+  const Vector3s& v = pinocchio::getFrameVelocity(*pin_model_, *d->pinocchio,
                                                   frame_id, pinocchio::LOCAL)
                           .linear();
   const Matrix3s& R = d->pinocchio->oMf[frame_id].rotation();
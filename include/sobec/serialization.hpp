@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_SERIALIZATION_HPP_
+#define SOBEC_SERIALIZATION_HPP_
+
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <iosfwd>
+#include <pinocchio/multibody/model.hpp>
+#include <string>
+#include <vector>
+
+namespace sobec {
+
+/**
+ * @brief Shooting problem restored from a binary snapshot, with the
+ * trajectories (typically the warm start of the MPC) saved along with it.
+ */
+struct ShootingProblemSnapshot {
+  boost::shared_ptr<crocoddyl::ShootingProblem> problem;
+  std::vector<Eigen::VectorXd> xs;
+  std::vector<Eigen::VectorXd> us;
+};
+
+/**
+ * @brief Save a fully built shooting problem in a compact binary format.
+ *
+ * The snapshot stores the parameters of each node (integrator, contacts,
+ * costs, activations and residuals) but not the pinocchio model, which must
+ * be provided again at load. Nodes sharing the same action model are stored
+ * once. Numbers are stored in the byte order of the host: a snapshot is a
+ * cache to speed up the controller startup, not an exchange format.
+ *
+ * Supported models are the ones used by the walking OCP: Euler and LPF
+ * integrators of the contact forward dynamics (crocoddyl or sobec), with a
+ * floating-base actuation, 6D/3D/1D contacts and residual costs. Any other
+ * model raises an exception. In particular, ResidualModelVelCollision is not
+ * supported since the snapshot does not store its collision geometries.
+ */
+void saveShootingProblem(std::ostream &os,
+                         const crocoddyl::ShootingProblem &problem,
+                         const std::vector<Eigen::VectorXd> &xs,
+                         const std::vector<Eigen::VectorXd> &us);
+void saveShootingProblem(const std::string &filename,
+                         const crocoddyl::ShootingProblem &problem,
+                         const std::vector<Eigen::VectorXd> &xs,
+                         const std::vector<Eigen::VectorXd> &us);
+
+/**
+ * @brief Rebuild a shooting problem from a snapshot held in memory.
+ *
+ * @param[in] model  Pinocchio model the problem was built with. It is shared
+ * by all the nodes of the restored problem.
+ */
+ShootingProblemSnapshot loadShootingProblem(
+    const char *buffer, const std::size_t size,
+    boost::shared_ptr<pinocchio::Model> model);
+
+/// @brief Rebuild a shooting problem from a snapshot file, mapped in memory.
+ShootingProblemSnapshot loadShootingProblem(
+    const std::string &filename, boost::shared_ptr<pinocchio::Model> model);
+
+}  // namespace sobec
+
+#endif  // SOBEC_SERIALIZATION_HPP_
@@ -0,0 +1,452 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_TICK_PROFILER_HPP_
+#define SOBEC_TICK_PROFILER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <crocoddyl/core/solvers/fddp.hpp>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace sobec {
+
+/**
+ * @brief Histogram of durations with logarithmic buckets (HDR-style).
+ *
+ * Durations are counted in nanoseconds, in buckets whose width is 1/32 of
+ * their magnitude: percentiles are known within 3%, from 1ns to 1000s.
+ * Recording is a few integer operations and never allocates.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() { reset(); }
+
+  void reset() {
+    counts_.fill(0);
+    count_ = 0;
+    sum_ = 0.;
+    min_ = 0;
+    max_ = 0;
+  }
+
+  /// @brief Record a duration, in seconds.
+  void record(const double seconds) {
+    const double ns = std::max(0., seconds * 1e9);
+    const uint64_t v = ns < double(kMaxValue) ? uint64_t(ns) : kMaxValue;
+    ++counts_[bucket(v)];
+    if (count_ == 0 || v < min_) min_ = v;
+    if (v > max_) max_ = v;
+    ++count_;
+    sum_ += seconds;
+  }
+
+  std::size_t get_count() const { return count_; }
+  double get_min() const { return double(min_) * 1e-9; }
+  double get_max() const { return double(max_) * 1e-9; }
+  double get_mean() const { return count_ > 0 ? sum_ / double(count_) : 0.; }
+
+  /// @brief Duration (s) below which p percent of the records are.
+  double getPercentile(const double p) const {
+    if (count_ == 0) return 0.;
+    const double rank = std::ceil(std::min(std::max(p, 0.), 100.) / 100. *
+                                  double(count_));
+    const std::size_t target = std::max<std::size_t>(1, std::size_t(rank));
+    std::size_t cumulated = 0;
+    for (std::size_t i = 0; i < kNbBuckets; ++i) {
+      cumulated += counts_[i];
+      if (cumulated >= target) {
+        return double(std::min(std::max(upperBound(i), min_), max_)) * 1e-9;
+      }
+    }
+    return get_max();
+  }
+
+ private:
+  // Values below 2*kSub are counted exactly, then each power of two is
+  // split in kSub buckets.
+  static const int kSubBits = 5;
+  static const uint64_t kSub = uint64_t(1) << kSubBits;
+  static const int kMaxExponent = 35;
+  static const std::size_t kNbBuckets = (kMaxExponent + 2) * kSub;
+  static const uint64_t kMaxValue =
+      (uint64_t(2) << (kMaxExponent + kSubBits)) - 1;
+
+  static std::size_t bucket(const uint64_t v) {
+    if (v < 2 * kSub) return std::size_t(v);
+    int msb = 0;
+    while ((v >> (msb + 1)) != 0) ++msb;
+    const int e = msb - kSubBits;
+    return std::size_t(e) * kSub + std::size_t(v >> e);
+  }
+
+  static uint64_t upperBound(const std::size_t i) {
+    if (i < 2 * kSub) return uint64_t(i);
+    const int e = int(i / kSub) - 1;
+    const uint64_t sub = uint64_t(i) - uint64_t(e) * kSub;
+    return ((sub + 1) << e) - 1;
+  }
+
+  std::array<uint64_t, kNbBuckets> counts_;
+  std::size_t count_;
+  double sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+/**
+ * @brief Latency histograms of the phases of an MPC tick.
+ *
+ * Disabled by default: the instrumented code then only tests the enabled
+ * flag. When enabled, each phase is timed with a monotonic clock.
+ */
+class TickProfiler {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  enum Phase {
+    /// @brief Update of the nodes of the horizon (circularAppend).
+    RECEDE = 0,
+    /// @brief Shift of the previous solution into the warm start.
+    WARM_START,
+    /// @brief Derivatives of the problem, and at the first iteration its
+    /// evaluation (both are done by SolverFDDP::calcDiff).
+    CALC_DIFF,
+    BACKWARD_PASS,
+    /// @brief One rollout of the line search, evaluating the problem.
+    FORWARD_PASS,
+    /// @brief All the trials of the line search of one iteration.
+    LINE_SEARCH,
+    /// @brief Solver call(s) of one tick.
+    SOLVE,
+    /// @brief Whole tick.
+    TICK,
+    NB_PHASES
+  };
+
+  TickProfiler() : enabled(false) {}
+
+  static const char* getPhaseName(const Phase phase) {
+    static const char* names[NB_PHASES] = {
+        "recede",      "warmStart",  "calcDiff", "backwardPass",
+        "forwardPass", "lineSearch", "solve",    "tick"};
+    return names[phase];
+  }
+
+  void record(const Phase phase, const double seconds) {
+    histograms_[phase].record(seconds);
+  }
+
+  const LatencyHistogram& get_histogram(const Phase phase) const {
+    return histograms_[phase];
+  }
+
+  void reset() {
+    for (LatencyHistogram& h : histograms_) h.reset();
+  }
+
+  /// @brief Print count, p50, p99 and max of each phase, in microseconds.
+  void print(std::ostream& os) const {
+    os << std::setw(14) << "phase" << std::setw(10) << "count"
+       << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10)
+       << "max" << std::endl;
+    for (int i = 0; i < NB_PHASES; ++i) {
+      const LatencyHistogram& h = histograms_[i];
+      os << std::setw(14) << getPhaseName(Phase(i)) << std::setw(10)
+         << h.get_count() << std::setw(10) << h.getPercentile(50) * 1e6
+         << std::setw(10) << h.getPercentile(99) * 1e6 << std::setw(10)
+         << h.get_max() * 1e6 << std::endl;
+    }
+  }
+
+  bool enabled;
+
+ private:
+  std::array<LatencyHistogram, NB_PHASES> histograms_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const TickProfiler& p) {
+  p.print(os);
+  return os;
+}
+
+/// @brief Time the enclosing scope as one occurrence of a phase.
+class ScopedTickPhase {
+ public:
+  ScopedTickPhase(TickProfiler& profiler, const TickProfiler::Phase phase)
+      : profiler_(profiler.enabled ? &profiler : NULL), phase_(phase) {
+    if (profiler_) start_ = TickProfiler::Clock::now();
+  }
+  ~ScopedTickPhase() {
+    if (profiler_) {
+      profiler_->record(phase_, std::chrono::duration<double>(
+                                    TickProfiler::Clock::now() - start_)
+                                    .count());
+    }
+  }
+
+ private:
+  TickProfiler* profiler_;
+  TickProfiler::Phase phase_;
+  TickProfiler::Clock::time_point start_;
+};
+
+/**
+ * @brief FDDP solver recording the duration of its internal phases in a
+ * TickProfiler, and optionally stopping its solves at a wall-clock deadline.
+ * Without profiling nor deadline, it behaves exactly as SolverFDDP.
+ */
+class SolverFDDPProfiled : public crocoddyl::SolverFDDP {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  SolverFDDPProfiled(boost::shared_ptr<crocoddyl::ShootingProblem> problem,
+                     TickProfiler& profiler)
+      : crocoddyl::SolverFDDP(problem),
+        profiler_(profiler),
+        lineSearchTime_(0.),
+        hasDeadline_(false),
+        deadlineHit_(false),
+        maxiter_(0),
+        iterations_(0),
+        iterationTime_(0.),
+        bestCost_(0.),
+        hasBest_(false) {}
+  virtual ~SolverFDDPProfiled() {}
+
+  /// @brief To be called before solve: reset the iteration counter and set
+  /// the deadline of the solve. The solve is stopped after the iteration
+  /// that predicts the next one to end after the deadline, so at least one
+  /// iteration is done.
+  void prepareSolve(const bool hasDeadline,
+                    const TickProfiler::Clock::time_point deadline =
+                        TickProfiler::Clock::time_point()) {
+    hasDeadline_ = hasDeadline;
+    deadline_ = deadline;
+    deadlineHit_ = false;
+    iterations_ = 0;
+    iterationStart_ = TickProfiler::Clock::now();
+  }
+
+  /// @brief Same as SolverFDDP::solve, the loop also ending at the deadline
+  /// set by prepareSolve. A solve cut by the deadline returns the feasible
+  /// iterate of lowest cost. The iterates stay feasible once one is, so if
+  /// the last one is not, the controls are rolled out from x0 to make it
+  /// feasible. The feedback gains are those of the last iteration.
+  virtual bool solve(
+      const std::vector<Eigen::VectorXd>& init_xs = crocoddyl::DEFAULT_VECTOR,
+      const std::vector<Eigen::VectorXd>& init_us = crocoddyl::DEFAULT_VECTOR,
+      const std::size_t maxiter = 100, const bool is_feasible = false,
+      const double reginit = 1e-9) {
+    if (!hasDeadline_) {
+      return crocoddyl::SolverFDDP::solve(init_xs, init_us, maxiter,
+                                          is_feasible, reginit);
+    }
+    if (problem_->is_updated()) resizeData();
+    allocateBest();
+    hasBest_ = false;
+    maxiter_ = maxiter;
+    // Needed in case init_xs[0] is not x0.
+    xs_try_[0] = problem_->get_x0();
+    setCandidate(init_xs, init_us, is_feasible);
+    if (std::isnan(reginit)) {
+      xreg_ = reg_min_;
+      ureg_ = reg_min_;
+    } else {
+      xreg_ = reginit;
+      ureg_ = reginit;
+    }
+    was_feasible_ = false;
+
+    // The loop of SolverFDDP::solve, ending when the deadline is hit.
+    bool recalcDiff = true;
+    for (iter_ = 0; iter_ < maxiter && !deadlineHit_; ++iter_) {
+      while (true) {
+        try {
+          computeDirection(recalcDiff);
+        } catch (std::exception&) {
+          recalcDiff = false;
+          increaseRegularization();
+          if (xreg_ == reg_max_) return false;
+          continue;
+        }
+        break;
+      }
+      updateExpectedImprovement();
+
+      for (std::vector<double>::const_iterator it = alphas_.begin();
+           it != alphas_.end(); ++it) {
+        steplength_ = *it;
+        try {
+          dV_ = tryStep(steplength_);
+        } catch (std::exception&) {
+          continue;
+        }
+        expectedImprovement();
+        dVexp_ = steplength_ * (d_[0] + 0.5 * steplength_ * d_[1]);
+        const bool accepted =
+            dVexp_ >= 0
+                ? std::abs(d_[0]) < th_grad_ || dV_ > th_acceptstep_ * dVexp_
+                : dV_ > th_acceptnegstep_ * dVexp_;
+        if (accepted) {
+          was_feasible_ = is_feasible_;
+          setCandidate(xs_try_, us_try_, was_feasible_ || steplength_ == 1);
+          cost_ = cost_try_;
+          recalcDiff = true;
+          break;
+        }
+      }
+
+      if (steplength_ > th_stepdec_) decreaseRegularization();
+      if (steplength_ <= th_stepinc_) {
+        increaseRegularization();
+        if (xreg_ == reg_max_) return false;
+      }
+      if (is_feasible_ && (!hasBest_ || cost_ < bestCost_)) keepBest();
+      stoppingCriteria();
+
+      const std::size_t n_callbacks = callbacks_.size();
+      for (std::size_t c = 0; c < n_callbacks; ++c) (*callbacks_[c])(*this);
+
+      if (was_feasible_ && stop_ < th_stop_) return true;
+    }
+    if (deadlineHit_) restoreBest();
+    return false;
+  }
+
+  /// @brief Called by solve at the end of each iteration, just before testing
+  /// the convergence.
+  virtual double stoppingCriteria() {
+    const double stop = crocoddyl::SolverFDDP::stoppingCriteria();
+    ++iterations_;
+    if (!hasDeadline_) return stop;
+
+    // Be pessimistic: a slow iteration is immediately taken into account,
+    // while a fast one only slowly decreases the estimate.
+    const double alpha = 0.2;
+    const TickProfiler::Clock::time_point now = TickProfiler::Clock::now();
+    const double duration =
+        std::chrono::duration<double>(now - iterationStart_).count();
+    iterationStart_ = now;
+    if (iterationTime_ <= 0. || duration > iterationTime_) {
+      iterationTime_ = duration;
+    } else {
+      iterationTime_ = (1 - alpha) * iterationTime_ + alpha * duration;
+    }
+
+    const bool converged = was_feasible_ && stop < th_stop_;
+    if (!converged && iter_ + 1 < maxiter_ &&
+        now + std::chrono::duration_cast<TickProfiler::Clock::duration>(
+                  std::chrono::duration<double>(iterationTime_)) >
+            deadline_) {
+      // The loop of solve ends once this iteration is over.
+      deadlineHit_ = true;
+    }
+    return stop;
+  }
+
+  virtual double calcDiff() {
+    flushLineSearch();
+    ScopedTickPhase phase(profiler_, TickProfiler::CALC_DIFF);
+    return crocoddyl::SolverFDDP::calcDiff();
+  }
+
+  virtual void backwardPass() {
+    flushLineSearch();
+    ScopedTickPhase phase(profiler_, TickProfiler::BACKWARD_PASS);
+    crocoddyl::SolverFDDP::backwardPass();
+  }
+
+  virtual void forwardPass(const double stepLength) {
+    ScopedTickPhase phase(profiler_, TickProfiler::FORWARD_PASS);
+    crocoddyl::SolverFDDP::forwardPass(stepLength);
+  }
+
+  virtual double tryStep(const double stepLength = 1) {
+    if (!profiler_.enabled) return crocoddyl::SolverFDDP::tryStep(stepLength);
+    const TickProfiler::Clock::time_point start = TickProfiler::Clock::now();
+    const double dV = crocoddyl::SolverFDDP::tryStep(stepLength);
+    lineSearchTime_ += std::chrono::duration<double>(
+                           TickProfiler::Clock::now() - start)
+                           .count();
+    return dV;
+  }
+
+  /// @brief True if the last solve was stopped by the deadline.
+  bool get_deadlineHit() const { return deadlineHit_; }
+  /// @brief Number of iterations completed since prepareSolve.
+  std::size_t get_nbIterations() const { return iterations_; }
+  /// @brief Running estimate of the duration of one iteration, in seconds,
+  /// updated by the solves with a deadline.
+  double get_iterationTime() const { return iterationTime_; }
+
+  /// @brief Record the line search of the last iteration. To be called
+  /// after solve; the previous iterations are recorded by calcDiff.
+  void flushLineSearch() {
+    if (lineSearchTime_ > 0.) {
+      profiler_.record(TickProfiler::LINE_SEARCH, lineSearchTime_);
+      lineSearchTime_ = 0.;
+    }
+  }
+
+ private:
+  // The buffers are sized once per horizon length, so that keeping and
+  // restoring an iterate does not allocate.
+  void allocateBest() {
+    if (bestXs_.size() == xs_.size() && bestUs_.size() == us_.size()) return;
+    bestXs_ = xs_;
+    bestUs_ = us_;
+  }
+
+  void keepBest() {
+    for (std::size_t t = 0; t < xs_.size(); ++t) bestXs_[t] = xs_[t];
+    for (std::size_t t = 0; t < us_.size(); ++t) bestUs_[t] = us_[t];
+    bestCost_ = cost_;
+    hasBest_ = true;
+  }
+
+  // Make the solution the feasible iterate of lowest cost.
+  void restoreBest() {
+    if (is_feasible_) {
+      // The iterates are feasible since the kept one.
+      if (!hasBest_ || cost_ <= bestCost_) return;
+    } else {
+      // No iterate was feasible: roll the controls out from x0.
+      problem_->rollout(us_, bestXs_);
+      for (std::size_t t = 0; t < us_.size(); ++t) bestUs_[t] = us_[t];
+      bestCost_ = problem_->get_terminalData()->cost;
+      for (std::size_t t = 0; t < us_.size(); ++t)
+        bestCost_ += problem_->get_runningDatas()[t]->cost;
+    }
+    setCandidate(bestXs_, bestUs_, true);
+    cost_ = bestCost_;
+  }
+
+  std::vector<Eigen::VectorXd> bestXs_;
+  std::vector<Eigen::VectorXd> bestUs_;
+  double bestCost_;
+  bool hasBest_;
+  TickProfiler& profiler_;
+  double lineSearchTime_;
+  bool hasDeadline_;
+  bool deadlineHit_;
+  TickProfiler::Clock::time_point deadline_;
+  TickProfiler::Clock::time_point iterationStart_;
+  std::size_t maxiter_;
+  std::size_t iterations_;
+  double iterationTime_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_TICK_PROFILER_HPP_
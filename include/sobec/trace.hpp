@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_TRACE_HPP_
+#define SOBEC_TRACE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Compile-time trace level: the sites above it expand to nothing, their
+// arguments are not even evaluated. 0 disables all the traces.
+#define SOBEC_TRACE_LEVEL_WARNING 1
+#define SOBEC_TRACE_LEVEL_INFO 2
+#define SOBEC_TRACE_LEVEL_DEBUG 3
+
+#ifndef SOBEC_TRACE_LEVEL
+#ifdef NDEBUG
+#define SOBEC_TRACE_LEVEL SOBEC_TRACE_LEVEL_INFO
+#else
+#define SOBEC_TRACE_LEVEL SOBEC_TRACE_LEVEL_DEBUG
+#endif
+#endif
+
+#if SOBEC_TRACE_LEVEL >= SOBEC_TRACE_LEVEL_WARNING
+#define SOBEC_TRACE_WARNING(...) \
+  ::sobec::trace::emit(::sobec::trace::WARNING, __VA_ARGS__)
+#else
+#define SOBEC_TRACE_WARNING(...) ((void)0)
+#endif
+
+#if SOBEC_TRACE_LEVEL >= SOBEC_TRACE_LEVEL_INFO
+#define SOBEC_TRACE_INFO(...) \
+  ::sobec::trace::emit(::sobec::trace::INFO, __VA_ARGS__)
+#else
+#define SOBEC_TRACE_INFO(...) ((void)0)
+#endif
+
+// Hot path sites (per node, per tick).
+#if SOBEC_TRACE_LEVEL >= SOBEC_TRACE_LEVEL_DEBUG
+#define SOBEC_TRACE_DEBUG(...) \
+  ::sobec::trace::emit(::sobec::trace::DEBUG, __VA_ARGS__)
+#else
+#define SOBEC_TRACE_DEBUG(...) ((void)0)
+#endif
+
+namespace sobec {
+namespace trace {
+
+enum Level { WARNING = SOBEC_TRACE_LEVEL_WARNING, INFO, DEBUG };
+
+/// @brief Fixed-size binary event. The message must be a string literal, the
+/// label is copied (and truncated).
+struct Event {
+  static const std::size_t kMaxValues = 4;
+  static const std::size_t kLabelSize = 24;
+
+  std::uint64_t time;  // ns since start()
+  const char* message;
+  double values[kMaxValues];
+  char label[kLabelSize];
+  std::uint8_t nvalues;
+  std::uint8_t level;
+};
+
+/// @brief Lock-free ring of events with one producer (the thread owning it)
+/// and one consumer (the drainer). Events are dropped, and counted, when the
+/// ring is full.
+class EventRing {
+ public:
+  static const std::size_t kCapacity = 1024;  // power of 2
+
+  EventRing() : head_(0), tail_(0), dropped_(0) {}
+
+  bool push(const Event& event) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == kCapacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    events_[head & (kCapacity - 1)] = event;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(Event& event) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    event = events_[tail & (kCapacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::uint64_t takeDropped() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  Event events_[kCapacity];
+  std::atomic<std::size_t> head_;
+  std::atomic<std::size_t> tail_;
+  std::atomic<std::uint64_t> dropped_;
+};
+
+/// @brief Text attached to an event, e.g. a joint or frame name.
+struct Label {
+  explicit Label(const char* str) : text(str) {}
+  explicit Label(const std::string& str) : text(str.c_str()) {}
+  const char* text;
+};
+
+/// @brief Start draining the events of all the threads in a background
+/// thread, to the file at path, or to the console if path is empty. Events
+/// are only recorded between start() and stop().
+void start(const std::string& path = "");
+/// @brief Stop the drainer, after writing the pending events.
+void stop();
+
+namespace detail {
+extern std::atomic<bool> enabled;
+/// @brief Ring of the calling thread, created (once) at its first event.
+EventRing& threadRing();
+std::uint64_t now();
+
+inline void put(Event& event, const Label& label) {
+  std::size_t i = 0;
+  for (; i + 1 < Event::kLabelSize && label.text[i] != '\0'; ++i)
+    event.label[i] = label.text[i];
+  event.label[i] = '\0';
+}
+
+inline void put(Event& event, const double value) {
+  if (event.nvalues < Event::kMaxValues) event.values[event.nvalues++] = value;
+}
+}  // namespace detail
+
+/// @brief Record an event made of a message, and of up to 4 values and a
+/// Label. Does nothing when the trace is not started.
+template <typename... Values>
+inline void emit(const Level level, const char* message,
+                 const Values&... values) {
+  if (!detail::enabled.load(std::memory_order_relaxed)) return;
+  Event event;
+  event.time = detail::now();
+  event.message = message;
+  event.level = static_cast<std::uint8_t>(level);
+  event.nvalues = 0;
+  event.label[0] = '\0';
+  const int expand[] = {0, (detail::put(event, values), 0)...};
+  (void)expand;
+  detail::threadRing().push(event);
+}
+
+}  // namespace trace
+}  // namespace sobec
+
+#endif  // SOBEC_TRACE_HPP_
@@ -0,0 +1,71 @@
+#ifndef SOBEC_WALK_OCP
+#define SOBEC_WALK_OCP
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include "sobec/fwd.hpp"
+#include "sobec/walk/params.hpp"
+#include "sobec/walk/robot_wrapper.hpp"
+
+namespace sobec {
+namespace walk {
+
+/**
+ * Native counterpart of sobec.walk.ocp and sobec.walk.weight_share: build
+ * the walking OCP, with the same cost stack as buildRunningModels, without
+ * going through the python interpreter.
+ */
+
+/// @brief For each node, which of the robot contacts are active.
+typedef std::vector<std::vector<bool> > ContactPattern;
+
+/// @brief Contact pattern of two steps, as used by the MPC:
+/// start, (double, left single, double, right single) and end phases.
+ContactPattern buildWalkContactPattern(const WalkParams &params);
+
+/// @brief Share of the weight supported by each contact at each node,
+/// with linear transitions of <duration> nodes at each contact change.
+Eigen::MatrixXd weightShareSmoothProfile(const ContactPattern &contactPattern,
+                                         const int duration);
+
+/// @brief Smooth reference contact forces, supporting the robot weight.
+/// The foot normal is supposed to be vertical.
+std::vector<std::vector<eVector6> > computeReferenceForces(
+    const ContactPattern &contactPattern, const double robotweight,
+    const int maxTransitionDuration = 50);
+
+std::vector<AMA> buildRunningModels(const RobotWrapper &robot,
+                                    const ContactPattern &contactPattern,
+                                    const WalkParams &params);
+
+AMA buildTerminalModel(const RobotWrapper &robot,
+                       const ContactPattern &contactPattern,
+                       const WalkParams &params);
+
+DDP buildSolver(const RobotWrapper &robot, const ContactPattern &contactPattern,
+                const WalkParams &params);
+
+/// @brief Quasistatic initial guess at the robot reference state.
+void buildInitialGuess(const crocoddyl::ShootingProblem &problem,
+                       std::vector<Eigen::VectorXd> &xs,
+                       std::vector<Eigen::VectorXd> &us);
+
+/// @brief Apply the timings and solver parameters to the MPC.
+void configureMPCWalk(MPCWalk &mpc, const WalkParams &params);
+
+/**
+ * @brief Build the MPC for walking, as done by benchmark/mpc_description.py:
+ * solve the OCP of two steps from a quasistatic guess, then initialize the
+ * MPC with the first Tmpc nodes of the solution.
+ *
+ * @param[in] maxiter  Number of iterations of the initial OCP solve.
+ */
+boost::shared_ptr<MPCWalk> buildMPCWalk(const RobotWrapper &robot,
+                                        const WalkParams &params,
+                                        const std::size_t maxiter = 200);
+
+}  // namespace walk
+}  // namespace sobec
+
+#endif  // SOBEC_WALK_OCP
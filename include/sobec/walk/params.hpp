@@ -0,0 +1,111 @@
+#ifndef SOBEC_WALK_PARAMS
+#define SOBEC_WALK_PARAMS
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "sobec/fwd.hpp"
+
+namespace sobec {
+namespace walk {
+
+/**
+ * @brief Weights and timings of the walking OCP, C++ counterpart of
+ * sobec.walk.params.WalkParams.
+ *
+ * Weights are multiplied to the residual squared. Importance terms are
+ * multiplied during the activation (hence are not squared). The IO
+ * parameters of the python class (guessFile, saveFile, showPreview) have no
+ * counterpart here.
+ */
+struct WalkParams {
+ public:
+  /// @brief Set the state and control importances from the robot name
+  /// (RobotWrapper::name), e.g. "talos_12" or "talos_14".
+  explicit WalkParams(const std::string &robotName);
+
+  // ### WEIGHTS
+  double refTorqueWeight = 0;
+  double refStateWeight = 1e-1;
+  double flatBaseWeight = 0;  // 20
+  eVector6 forceImportance = (eVector6() << 1, 1, 0.1, 10, 10, 2).finished();
+  double coneAxisWeight = 2e-4;
+  double comWeight = 0;  // 20
+  eVector3 vcomImportance = eVector3(0., 0, 1);
+  double vcomWeight = 1;
+  double acomWeight = 0;  // 16*DT
+  double copWeight = 2;
+  double verticalFootVelWeight = 20;
+  double footVelWeight = 0;  // 20
+  double footAccWeight = 0;  // 2
+  double flyWeight = 200;
+  double groundColWeight = 200;
+  double conePenaltyWeight = 0;
+  double feetCollisionWeight = 1000;
+
+  double lowbandwidthweight = 0;   // 2e-1
+  double minTorqueDiffWeight = 0;  // 2e-2
+
+  double refForceWeight = 10;
+  double contiForceWeight = 0;
+
+  double impactAltitudeWeight = 20000;
+  double impactVelocityWeight = 10000;
+  double impactRotationWeight = 200;
+  double refMainJointsAtImpactWeight = 0;  // 2e2 # For avoinding crossing legs
+
+  double stateTerminalWeight = 20;  // 2000
+  double terminalNoVelocityWeight = 2000;
+  double terminalXTargetWeight = 0;  // ##DDP## 2000
+
+  // ## Other terms related to the cost functions
+  bool enforceMinimalFootDistance = false;
+
+  double refFootFlyingAltitude = 7e-2;
+  double flyHighSlope = 3 / refFootFlyingAltitude;
+  double footMinimalDistance = 0.2;  // (.17 is the max value wrt initial config)
+  bool soleCollision = true;
+  bool towCollision = false;
+  bool heelCollision = false;
+  std::vector<std::string> mainJointIds = {
+      "leg_left_1_joint",  "leg_left_2_joint",  "leg_left_4_joint",
+      "leg_right_1_joint", "leg_right_2_joint", "leg_right_4_joint"};
+  eVector3 vcomRef = eVector3(0.05, 0, 0);
+
+  double footSize = 0.05;
+
+  // ## Contact parameters for the kkt dynamics
+  double kktDamping = 0;  // 1e-6
+  eVector2 baumgartGains = eVector2(0, 100);
+
+  // ## Parameters related to the solver
+  double solver_th_stop = 1e-3;
+  int solver_maxiter = 2;
+  double solver_reg_min = 1e-6;
+
+  // ## Parameter related to the time lines
+  double DT = 0.010;
+  int Tstart = int(0.3 / DT);
+  int Tsingle = int(0.8 / DT);  // 60
+  // I prefer an even number for Tdouble
+  int Tdouble = 2 * int(std::nearbyint(0.11 / DT / 2 - 0.75)) + 1;  // 11
+  int Tend = int(0.3 / DT);
+  int Tmpc = int(1.6 / DT);  // 120
+
+  // ## Parameters related to the control environment
+  // max magnitude of the multiplicative joint torque noise, expressed as a
+  // percentage (i.e. 1=100%)
+  double torque_noise = 0.0;
+
+  // ## Robot-dependant importances
+  Eigen::VectorXd stateImportance;
+  Eigen::VectorXd stateTerminalImportance;
+  Eigen::VectorXd controlImportance;
+};
+
+}  // namespace walk
+}  // namespace sobec
+
+#endif  // SOBEC_WALK_PARAMS
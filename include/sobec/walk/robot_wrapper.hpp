@@ -0,0 +1,52 @@
+#ifndef SOBEC_WALK_ROBOT_WRAPPER
+#define SOBEC_WALK_ROBOT_WRAPPER
+
+#include <Eigen/Dense>
+#include <map>
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/spatial/se3.hpp>
+#include <string>
+#include <vector>
+
+#include "sobec/fwd.hpp"
+
+namespace sobec {
+namespace walk {
+
+/**
+ * @brief Add a child frame to all frames listed by their id.
+ * The child placement is given wrt to the parent by <displacement>.
+ * The new name is the parent name suffixed by <subname>.
+ */
+void addChildrenFrames(pinocchio::Model &model,
+                       const std::vector<pinocchio::FrameIndex> &parentFrameIds,
+                       const std::string &subname,
+                       const pinocchio::SE3 &displacement);
+
+/**
+ * @brief Robot description used by the walking OCP, C++ counterpart of
+ * sobec.walk.robot_wrapper.RobotWrapper.
+ *
+ * The model is copied, then tow and heel frames are added to all the frames
+ * whose name contains contactKey.
+ */
+class RobotWrapper {
+ public:
+  RobotWrapper(const pinocchio::Model &model, const std::string &contactKey,
+               const std::string &refPosture = "half_sitting");
+
+  boost::shared_ptr<pinocchio::Model> model;
+  std::string name;
+  std::vector<pinocchio::FrameIndex> contactIds;
+  std::map<pinocchio::FrameIndex, pinocchio::FrameIndex> towIds;
+  std::map<pinocchio::FrameIndex, pinocchio::FrameIndex> heelIds;
+  Eigen::VectorXd x0;
+  pinocchio::FrameIndex baseId;
+  double gravForce;
+  eVector3 com0;
+};
+
+}  // namespace walk
+}  // namespace sobec
+
+#endif  // SOBEC_WALK_ROBOT_WRAPPER
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_WBC_ASYNC_HPP_
+#define SOBEC_WBC_ASYNC_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sobec/double-buffer.hpp"
+#include "sobec/wbc.hpp"
+
+namespace sobec {
+
+/**
+ * @brief First nodes of a WBC solution, as published by WBCAsync.
+ *
+ * The control at node n for a measured state x follows the crocoddyl
+ * convention us[n] - K[n] (x - xs[n]), as HorizonManager::currentTorques.
+ */
+struct WBCPolicySnapshot {
+  std::vector<Eigen::VectorXd> xs;
+  std::vector<Eigen::VectorXd> us;
+  std::vector<Eigen::MatrixXd> K;
+  /// @brief Control iteration of the state the DDP was solved from.
+  int iteration;
+  /// @brief Duration of the DDP part, in seconds.
+  double solveDuration;
+};
+
+/**
+ * @brief Multi-rate WBC: the DDP runs in a worker thread while the control
+ * thread keeps computing the torques at each iteration.
+ *
+ * At the iterations where WBC::timeToSolveDDP is true, iterate() posts the
+ * measured state to the worker, which runs WBC::solveDDP on it and publishes
+ * the first policyNodes nodes of the solution. At each iteration, iterate()
+ * computes the torques from the last published solution, using the node of
+ * the current iteration: a solution of iteration i0 is used at node
+ * (iteration - i0) / Nc, so that a solve completed late is applied at the
+ * right time. The control thread neither waits nor allocates.
+ *
+ * While running, the worker owns the WBC object: do not touch it (nor its
+ * horizon) from another thread until stop() returns.
+ */
+class WBCAsync {
+ public:
+  explicit WBCAsync(boost::shared_ptr<WBC> wbc, const int policyNodes = 10);
+  virtual ~WBCAsync();
+
+  /// @brief Start the worker. The WBC must be initialized and its horizon
+  /// solved once, since this solution is used until the first solve.
+  void start();
+  /// @brief Stop the worker, waiting for the on-going solve to finish.
+  void stop();
+  bool isRunning() const { return running_.load(); }
+
+  /// @brief Same as WBC::iterate, the DDP being solved by the worker.
+  const Eigen::VectorXd &iterate(const int iteration,
+                                 const Eigen::VectorXd &q_current,
+                                 const Eigen::VectorXd &v_current,
+                                 const bool is_feasible = false);
+
+  /// @brief Torques from the last published solution for the reduced state x.
+  const Eigen::VectorXd &currentTorques(const int iteration,
+                                        const Eigen::VectorXd &x);
+
+  std::size_t get_solves() const { return solves_.load(); }
+  /// @brief Number of posted states overwritten before the worker took them.
+  std::size_t get_missed() const { return missed_.load(); }
+  /// @brief Age, in control iterations, of the solution used by the last
+  /// call to currentTorques.
+  int get_policyAge() const { return policyAge_; }
+
+ public:
+  boost::shared_ptr<WBC> wbc;
+
+ protected:
+  struct Request {
+    Eigen::VectorXd x;
+    int iteration;
+    bool is_feasible;
+    std::size_t id;
+  };
+
+  void run();
+
+  int policyNodes_;
+  int Nc_;
+  boost::shared_ptr<crocoddyl::StateMultibody> state_;
+
+  DoubleBuffer<Request> requests_;
+  DoubleBuffer<WBCPolicySnapshot> policies_;
+
+  std::thread worker_;
+  std::atomic<bool> running_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+
+  std::atomic<std::size_t> posted_;
+  std::atomic<std::size_t> consumed_;
+  std::atomic<std::size_t> solves_;
+  std::atomic<std::size_t> missed_;
+
+  // Control thread only.
+  WBCPolicySnapshot policy_;
+  std::size_t policySolves_;
+  int policyAge_;
+  Eigen::VectorXd x_;
+  Eigen::VectorXd dx_;
+  Eigen::VectorXd u_;
+};
+
+}  // namespace sobec
+
+#endif  // SOBEC_WBC_ASYNC_HPP_
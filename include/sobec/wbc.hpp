@@ -10,6 +10,7 @@
 #include "sobec/designer.hpp"
 #include "sobec/horizon_manager.hpp"
 #include "sobec/model_factory.hpp"
+#include "sobec/reference-ring.hpp"
 
 namespace sobec {
 
@@ -63,14 +64,27 @@ class WBC {
   // INTERNAL UPDATING functions
   void updateStepTrackerReferences();
   void updateNonThinkingReferences();
-  // References for costs:
-  std::vector<pinocchio::SE3> ref_LF_poses_, ref_RF_poses_;
-  std::vector<eVector3> ref_com_vel_;
+  // References for costs, receding with the horizon. Only the nodes whose
+  // reference changed, and the appended nodes, are written in the costs.
+  ReferenceRing<pinocchio::SE3> ref_LF_poses_, ref_RF_poses_;
+  ReferenceRing<eVector3> ref_com_vel_;
 
   // Memory preallocations:
   std::vector<unsigned long> controlled_joints_id_;
   Eigen::VectorXd x_internal_;
 
+  // Gather map from the complete model to the reduced one, built at
+  // initialization as runs of consecutive indices, so that shapeState and
+  // scatterTorques are made of a few block copies.
+  struct IndexRun {
+    Eigen::Index reduced;
+    Eigen::Index complete;
+    Eigen::Index size;
+  };
+  std::vector<IndexRun> q_runs_, v_runs_, tau_runs_;
+  Eigen::Index nq_complete_, nv_complete_, nq_reduced_, nv_reduced_;
+  void buildGatherMaps();
+
  public:
   WBC();
   WBC(const WBCSettings &settings, const RobotDesigner &design,
@@ -83,7 +97,21 @@ class WBC {
                   const std::string &actuationCostName);
   bool initialized_ = false;
 
-  Eigen::VectorXd shapeState(Eigen::VectorXd q, Eigen::VectorXd v);
+  /// @brief Reduced state from the posture and velocity of the complete or
+  /// of the reduced model.
+  const Eigen::VectorXd &shapeState(const Eigen::VectorXd &q,
+                                    const Eigen::VectorXd &v);
+  /// @brief Same as above, written in x (of size nq + nv of the reduced
+  /// model). Does not allocate.
+  void shapeState(const Eigen::Ref<const Eigen::VectorXd> &q,
+                  const Eigen::Ref<const Eigen::VectorXd> &v,
+                  Eigen::Ref<Eigen::VectorXd> x);
+
+  /// @brief Write the torques u of the reduced model in the torques tau of
+  /// the actuated joints of the complete model (of size nv - 6). The
+  /// entries of the joints not controlled are left unchanged.
+  void scatterTorques(const Eigen::Ref<const Eigen::VectorXd> &u,
+                      Eigen::Ref<Eigen::VectorXd> tau);
 
   void generateWalkigCycle(ModelMaker &mm);
 
@@ -100,10 +128,16 @@ class WBC {
                           const Eigen::VectorXd &v_current,
                           const bool &is_feasible);
 
+  /// @brief DDP part of iterate: recede, update the references and solve
+  /// from the reduced state x.
+  void solveDDP(const Eigen::VectorXd &x, const bool &is_feasible);
+
   void recedeWithCycle();
   void recedeWithCycle(HorizonManager &cycle);
 
   // getters and setters
+  const WBCSettings &get_settings() { return settings_; }
+
   Eigen::VectorXd get_x0() { return x0_; }
   void set_x0(Eigen::VectorXd x0) { x0_ = x0; }
 
@@ -118,7 +152,9 @@ class WBC {
   }
 
   HorizonManager get_horizon() { return horizon_; }
-  void set_horizon(HorizonManager horizon) { horizon_ = horizon; }
+  /// @brief The references follow the size of the new horizon, and are all
+  /// written in its costs at the next DDP tick.
+  void set_horizon(HorizonManager horizon);
 
   RobotDesigner get_designer() { return designer_; }
   void set_designer(RobotDesigner designer) { designer_ = designer; }
@@ -141,39 +177,43 @@ class WBC {
 
   // REFERENCE SETTERS AND GETTERS
 
-  const std::vector<pinocchio::SE3> &getPoseRef_LF() { return ref_LF_poses_; }
+  std::vector<pinocchio::SE3> getPoseRef_LF() {
+    return ref_LF_poses_.toVector();
+  }
   const pinocchio::SE3 &getPoseRef_LF(const unsigned long &time) {
     return ref_LF_poses_[time];
   }
   void setPoseRef_LF(const std::vector<pinocchio::SE3> &ref_LF_poses) {
-    ref_LF_poses_ = ref_LF_poses;
+    ref_LF_poses_.set(ref_LF_poses);
   }
   void setPoseRef_LF(const pinocchio::SE3 &ref_LF_pose,
                      const unsigned long &time) {
-    ref_LF_poses_[time] = ref_LF_pose;
+    ref_LF_poses_.set(time, ref_LF_pose);
   }
 
-  const std::vector<pinocchio::SE3> &getPoseRef_RF() { return ref_RF_poses_; }
+  std::vector<pinocchio::SE3> getPoseRef_RF() {
+    return ref_RF_poses_.toVector();
+  }
   const pinocchio::SE3 &getPoseRef_RF(const unsigned long &time) {
     return ref_RF_poses_[time];
   }
   void setPoseRef_RF(const std::vector<pinocchio::SE3> &ref_RF_poses) {
-    ref_RF_poses_ = ref_RF_poses;
+    ref_RF_poses_.set(ref_RF_poses);
   }
   void setPoseRef_RF(const pinocchio::SE3 &ref_RF_pose,
                      const unsigned long &time) {
-    ref_RF_poses_[time] = ref_RF_pose;
+    ref_RF_poses_.set(time, ref_RF_pose);
   }
 
-  const std::vector<eVector3> &getVelRef_COM() { return ref_com_vel_; }
+  std::vector<eVector3> getVelRef_COM() { return ref_com_vel_.toVector(); }
   const eVector3 &getVelRef_COM(const unsigned long &time) {
     return ref_com_vel_[time];
   }
   void setVelRef_COM(const std::vector<eVector3> &ref_com_vel) {
-    ref_com_vel_ = ref_com_vel;
+    ref_com_vel_.set(ref_com_vel);
   }
   void setVelRef_COM(const eVector3 &ref_com_vel, const unsigned long &time) {
-    ref_com_vel_[time] = ref_com_vel;
+    ref_com_vel_.set(time, ref_com_vel);
   }
 
   void switchToWalk() { now_ = WALKING; }
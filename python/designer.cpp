@@ -39,6 +39,8 @@ void initialize(sobec::RobotDesigner &self, bp::dict settings) {
       bp::extract<std::string>(settings["robotDescription"]);
   py_list_to_std_vector(settings["controlledJointsNames"],
                         conf.controlledJointsNames);
+  if (settings.has_key("cachePath"))
+    conf.cachePath = bp::extract<std::string>(settings["cachePath"]);
 
   self.initialize(conf);
 }
@@ -51,6 +53,7 @@ bp::dict get_settings(RobotDesigner &self) {
   settings["leftFootName"] = conf.leftFootName;
   settings["rightFootName"] = conf.rightFootName;
   settings["robotDescription"] = conf.robotDescription;
+  settings["cachePath"] = conf.cachePath;
 
   return settings;
 }
@@ -72,6 +75,11 @@ void exposeDesigner() {
       .def("initialize", &initialize)
       .def("updateReducedModel", &RobotDesigner::updateReducedModel)
       .def("updateCompleteModel", &RobotDesigner::updateCompleteModel)
+      .def("updateReducedKinematics", &RobotDesigner::updateReducedKinematics,
+           (bp::arg("self"), bp::arg("x"), bp::arg("withCoM") = true))
+      .def("get_LF_position", &RobotDesigner::get_LF_position)
+      .def("get_RF_position", &RobotDesigner::get_RF_position)
+      .def("get_com_position", &RobotDesigner::get_com_position)
       .def("get_LF_frame", &RobotDesigner::get_LF_frame)
       .def("get_RF_frame", &RobotDesigner::get_RF_frame)
       .def("getRobotMass", &RobotDesigner::getRobotMass)
@@ -89,7 +97,8 @@ void exposeDesigner() {
       .def("get_LF_id", &RobotDesigner::get_LF_id)
       .def("get_RF_id", &RobotDesigner::get_RF_id)
       .def("get_settings", &get_settings)
-      .def("get_controlledJointsIDs", &RobotDesigner::get_controlledJointsIDs);
+      .def("get_controlledJointsIDs", &RobotDesigner::get_controlledJointsIDs)
+      .def("get_loadedFromCache", &RobotDesigner::get_loadedFromCache);
 
   return;
 }
@@ -31,12 +31,37 @@ void initialize(HorizonManager &self, const bp::dict &settings,
   HorizonManagerSettings conf;
   conf.leftFootName = bp::extract<std::string>(settings["leftFootName"]);
   conf.rightFootName = bp::extract<std::string>(settings["rightFootName"]);
+  if (settings.has_key("nthreads"))
+    conf.nthreads = bp::extract<int>(settings["nthreads"]);
+  // Names of the costs resolved into the handles, the defaults match the
+  // ModelMaker.
+  if (settings.has_key("placementLFName"))
+    conf.placementLFName =
+        bp::extract<std::string>(settings["placementLFName"]);
+  if (settings.has_key("placementRFName"))
+    conf.placementRFName =
+        bp::extract<std::string>(settings["placementRFName"]);
+  if (settings.has_key("comVelocityName"))
+    conf.comVelocityName =
+        bp::extract<std::string>(settings["comVelocityName"]);
+  if (settings.has_key("actuationName"))
+    conf.actuationName = bp::extract<std::string>(settings["actuationName"]);
+  if (settings.has_key("wrenchLFName"))
+    conf.wrenchLFName = bp::extract<std::string>(settings["wrenchLFName"]);
+  if (settings.has_key("wrenchRFName"))
+    conf.wrenchRFName = bp::extract<std::string>(settings["wrenchRFName"]);
 
   std::vector<AMA> horizonModels;
   py_list_to_std_vector(runningModels, horizonModels);
   self.initialize(conf, x0, horizonModels, terminalModel);
 }
 
+void reserveData(HorizonManager &self, const bp::list models) {
+  std::vector<AMA> cycleModels;
+  py_list_to_std_vector(models, cycleModels);
+  self.reserveData(cycleModels);
+}
+
 bp::dict get_contacts(HorizonManager &self, const unsigned long time) {
   bp::dict contacts;
   for (std::string frame : self.contacts(time)->get_active_set())
@@ -49,7 +74,58 @@ bp::dict get_contacts(HorizonManager &self, const unsigned long time) {
   return contacts;
 }
 
+// Releases the GIL for the scope of a call that touches no python object.
+class ScopedReleaseGIL {
+ public:
+  ScopedReleaseGIL() : state_(PyEval_SaveThread()) {}
+  ~ScopedReleaseGIL() { PyEval_RestoreThread(state_); }
+
+ private:
+  PyThreadState *state_;
+};
+
+// The buffers are mapped on the numpy arrays when they are C-contiguous
+// float64 arrays, and copied otherwise.
+void setPoseReferencesLF(HorizonManager &self,
+                         const Eigen::Ref<const HorizonPoses> &poses) {
+  ScopedReleaseGIL release;
+  self.setPoseReferencesLF(poses);
+}
+
+void setPoseReferencesRF(HorizonManager &self,
+                         const Eigen::Ref<const HorizonPoses> &poses) {
+  ScopedReleaseGIL release;
+  self.setPoseReferencesRF(poses);
+}
+
+void setVelocityRefsCOM(HorizonManager &self,
+                        const Eigen::Ref<const HorizonVectors3> &velocities) {
+  ScopedReleaseGIL release;
+  self.setVelocityRefsCOM(velocities);
+}
+
+void setForceReferencesLF(HorizonManager &self,
+                          const Eigen::Ref<const HorizonWrenches> &wrenches) {
+  ScopedReleaseGIL release;
+  self.setForceReferencesLF(wrenches);
+}
+
+void setForceReferencesRF(HorizonManager &self,
+                          const Eigen::Ref<const HorizonWrenches> &wrenches) {
+  ScopedReleaseGIL release;
+  self.setForceReferencesRF(wrenches);
+}
+
 void exposeHorizonManager() {
+  eigenpy::enableEigenPySpecific<HorizonPoses>();
+  eigenpy::enableEigenPySpecific<HorizonVectors3>();
+  eigenpy::enableEigenPySpecific<HorizonWrenches>();
+
+  bp::class_<NodeHandles>(
+      "NodeHandles",
+      "Handles on the costs and contacts of one node, see resolveHandles.",
+      bp::no_init);
+
   bp::class_<HorizonManager>("HorizonManager", bp::init<>())
       .def("initialize", &initialize,
            bp::args("self", "settings", "x0", "runningModels", "terminalModel"))
@@ -61,10 +137,25 @@ void exposeHorizonManager() {
       .def("state", &HorizonManager::state, bp::args("self", "time"))
       .def("ada", &HorizonManager::ada, bp::args("self", "time"))
       .def("iad", &HorizonManager::iad, bp::args("self", "time"))
-      .def("setPoseReferenceLF", &HorizonManager::setPoseReferenceLF,
-           bp::args("self", "time", "pose", "costName"))
-      .def("setPoseReferenceRF", &HorizonManager::setPoseReferenceRF,
-           bp::args("self", "time", "pose", "costName"))
+      .def<void (HorizonManager::*)(const unsigned long &, const std::string &,
+                                    const pinocchio::SE3 &)>(
+          "setPoseReferenceLF", &HorizonManager::setPoseReferenceLF,
+          bp::args("self", "time", "costName", "pose"))
+      .def<void (HorizonManager::*)(const unsigned long &,
+                                    const pinocchio::SE3 &)>(
+          "setPoseReferenceLF", &HorizonManager::setPoseReferenceLF,
+          bp::args("self", "time", "pose"))
+      .def<void (HorizonManager::*)(const unsigned long &, const std::string &,
+                                    const pinocchio::SE3 &)>(
+          "setPoseReferenceRF", &HorizonManager::setPoseReferenceRF,
+          bp::args("self", "time", "costName", "pose"))
+      .def<void (HorizonManager::*)(const unsigned long &,
+                                    const pinocchio::SE3 &)>(
+          "setPoseReferenceRF", &HorizonManager::setPoseReferenceRF,
+          bp::args("self", "time", "pose"))
+      .def<void (HorizonManager::*)(const unsigned long &, const eVector3 &)>(
+          "setVelocityRefCOM", &HorizonManager::setVelocityRefCOM,
+          bp::args("self", "time", "ref_velocity"))
       .def("activateContactLF", &HorizonManager::activateContactLF,
            bp::args("self", "time", "contactName"))
       .def("activateContactRF", &HorizonManager::activateContactRF,
@@ -73,10 +164,20 @@ void exposeHorizonManager() {
            bp::args("self", "time", "contactName"))
       .def("removeContactRF", &HorizonManager::removeContactRF,
            bp::args("self", "time", "contactName"))
-      .def("setForceReferenceLF", &HorizonManager::setForceReferenceLF,
-           bp::args("self", "time", "costName", "ref_wrench"))
-      .def("setForceReferenceRF", &HorizonManager::setForceReferenceRF,
-           bp::args("self", "time", "costName", "ref_wrench"))
+      .def<void (HorizonManager::*)(const unsigned long &, const std::string &,
+                                    const eVector6 &)>(
+          "setForceReferenceLF", &HorizonManager::setForceReferenceLF,
+          bp::args("self", "time", "costName", "ref_wrench"))
+      .def<void (HorizonManager::*)(const unsigned long &, const eVector6 &)>(
+          "setForceReferenceLF", &HorizonManager::setForceReferenceLF,
+          bp::args("self", "time", "ref_wrench"))
+      .def<void (HorizonManager::*)(const unsigned long &, const std::string &,
+                                    const eVector6 &)>(
+          "setForceReferenceRF", &HorizonManager::setForceReferenceRF,
+          bp::args("self", "time", "costName", "ref_wrench"))
+      .def<void (HorizonManager::*)(const unsigned long &, const eVector6 &)>(
+          "setForceReferenceRF", &HorizonManager::setForceReferenceRF,
+          bp::args("self", "time", "ref_wrench"))
       .def("setSwingingLF", &HorizonManager::setSwingingLF,
            bp::args("self", "time", "contactNameLF", "contactNameRF",
                     "forceCostName"))
@@ -87,10 +188,17 @@ void exposeHorizonManager() {
            bp::args("self", "time", "contactNameLF", "contactNameRF"))
       .def<void (HorizonManager::*)(const AMA &, const ADA &)>(
           "recede", &HorizonManager::recede, bp::args("self", "IAM", "IAD"))
+      .def<void (HorizonManager::*)(const AMA &, const ADA &,
+                                    const NodeHandles &)>(
+          "recede", &HorizonManager::recede,
+          bp::args("self", "IAM", "IAD", "handles"))
       .def<void (HorizonManager::*)(const AMA &)>(
           "recede", &HorizonManager::recede, bp::args("self", "IAM"))
       .def<void (HorizonManager::*)()>("recede", &HorizonManager::recede,
                                        bp::args("self"))
+      .def("reserveData", &reserveData, bp::args("self", "models"),
+           "Pool one data per occurrence of the models, recycled by "
+           "recede(IAM).")
       .add_property("ddp", &HorizonManager::get_ddp, &HorizonManager::set_ddp)
       .def("currentTorques", &HorizonManager::currentTorques, bp::args("x0"))
       .def("solve", &HorizonManager::solve,
@@ -105,8 +213,42 @@ void exposeHorizonManager() {
           "setBalancingTorque", &HorizonManager::setBalancingTorque,
           bp::args("self", "time", "x"))
       .def("size", &HorizonManager::size, (bp::arg("self")))
-      .def("setActuationReference", &HorizonManager::setActuationReference,
-           bp::args("self", "time", "actuationCostName"))
+      .def("setCostWeight", &HorizonManager::setCostWeight,
+           bp::args("self", "time", "costName", "weight"),
+           "Set the weight of a cost, which is active if and only if the "
+           "weight is not zero.")
+      .def<void (HorizonManager::*)(const unsigned long &, const std::string &,
+                                    const Eigen::VectorXd &)>(
+          "setActuationReference", &HorizonManager::setActuationReference,
+          bp::args("self", "time", "actuationCostName", "reference"))
+      .def<void (HorizonManager::*)(const unsigned long &,
+                                    const Eigen::VectorXd &)>(
+          "setActuationReference", &HorizonManager::setActuationReference,
+          bp::args("self", "time", "reference"))
+      .def("setPoseReferencesLF", &setPoseReferencesLF,
+           bp::args("self", "poses"),
+           "Set the left foot pose of the first nodes from a (n, 7) array of "
+           "[x, y, z, qx, qy, qz, qw], row t being node t.")
+      .def("setPoseReferencesRF", &setPoseReferencesRF,
+           bp::args("self", "poses"),
+           "Set the right foot pose of the first nodes from a (n, 7) array of "
+           "[x, y, z, qx, qy, qz, qw], row t being node t.")
+      .def("setVelocityRefsCOM", &setVelocityRefsCOM,
+           bp::args("self", "velocities"),
+           "Set the CoM velocity of the first nodes from a (n, 3) array.")
+      .def("setForceReferencesLF", &setForceReferencesLF,
+           bp::args("self", "wrenches"),
+           "Set the left foot wrench of the first nodes from a (n, 6) array.")
+      .def("setForceReferencesRF", &setForceReferencesRF,
+           bp::args("self", "wrenches"),
+           "Set the right foot wrench of the first nodes from a (n, 6) array.")
+      .def("resolveHandles", &HorizonManager::resolveHandles,
+           bp::args("self", "model"),
+           "Resolve the named costs of a model, to recede with it.")
+      .def("registerHandles", &HorizonManager::registerHandles,
+           bp::args("self"),
+           "Resolve the named costs of each node, used by the setters "
+           "without cost name.")
       .def("get_contacts", &get_contacts, bp::args("self", "time"));
   return;
 }
@@ -21,4 +21,5 @@ BOOST_PYTHON_MODULE(sobec_pywrap) {
   sobec::python::exposeResidualContactForce();
   sobec::python::exposeWBC();
   sobec::python::exposeMPCWalk();
+  sobec::python::exposeTrace();
 }
@@ -6,6 +6,7 @@
 #include <crocoddyl/core/activation-base.hpp>
 #include <eigenpy/eigenpy.hpp>
 #include <sobec/model_factory.hpp>
+#include <sstream>
 
 namespace sobec {
 namespace python {
@@ -58,6 +59,8 @@ void initialize(ModelMaker &self, const bp::dict &settings,
       bp::extract<Eigen::VectorXd>(settings["controlWeights"]);
   conf.th_grad = bp::extract<double>(settings["th_grad"]);
   conf.th_stop = bp::extract<double>(settings["th_stop"]);
+  if (settings.has_key("nthreads"))
+    conf.nthreads = bp::extract<int>(settings["nthreads"]);
 
   self.initialize(conf, designer);
 }
@@ -87,6 +90,7 @@ bp::dict get_settings(ModelMaker &self) {
   settings["controlWeights"] = conf.controlWeights;
   settings["th_grad"] = conf.th_grad;
   settings["th_stop"] = conf.th_stop;
+  settings["nthreads"] = conf.nthreads;
   return settings;
 }
 
@@ -161,17 +165,49 @@ void defineCoMVelocity(ModelMaker &self,
   costCollector = *costs;
 }
 
+bp::list get_costStackReports(const ModelMaker &self) {
+  return std_vector_to_py_list(self.get_costStackReports());
+}
+
+bp::list get_deactivated(const CostStackReport &report) {
+  return std_vector_to_py_list(report.deactivated);
+}
+
+bp::dict get_sharedQuantities(const CostStackReport &report) {
+  bp::dict quantities;
+  for (const auto &shared : report.sharedQuantities)
+    quantities[shared.first] = std_vector_to_py_list(shared.second);
+  return quantities;
+}
+
+std::string printCostStackReport(const CostStackReport &report) {
+  std::ostringstream os;
+  os << report;
+  return os.str();
+}
+
 void exposeModelFactory() {
   bp::enum_<Support>("Support")
       .value("LEFT", Support::LEFT)
       .value("RIGHT", Support::RIGHT)
       .value("DOUBLE", Support::DOUBLE);
 
+  bp::class_<CostStackReport>(
+      "CostStackReport", "What compileCostStack did to the costs of a node.",
+      bp::no_init)
+      .add_property("deactivated", &get_deactivated,
+                    "Costs deactivated because of their zero weight.")
+      .add_property("sharedQuantities", &get_sharedQuantities,
+                    "Active costs reading the same pinocchio quantity, by "
+                    "quantity.")
+      .def("__str__", &printCostStackReport);
+
   bp::class_<ModelMaker>("ModelMaker", bp::init<>())
       .def("initialize", &initialize, bp::args("self", "settings", "design"))
       // .def("formulateHorizon", &formulateHorizon, bp::args("self",
       // "supports"))
       .def("get_settings", &get_settings, bp::args("self"))
+      .def("get_costStackReports", &get_costStackReports, bp::args("self"))
       .def("defineFeetContact", &defineFeetContact,
            (bp::arg("self"), bp::arg("contactCollector"),
             bp::arg("supports") = Support::DOUBLE))
@@ -24,6 +24,7 @@
 #include <crocoddyl/core/solvers/fddp.hpp>
 #include <eigenpy/eigenpy.hpp>
 #include <pinocchio/multibody/fwd.hpp>  // Must be included first!
+#include <sstream>
 
 #include "sobec/fwd.hpp"
 
@@ -33,7 +34,71 @@ namespace python {
 using namespace crocoddyl;
 namespace bp = boost::python;
 
+namespace {
+
+std::string printTickProfiler(const TickProfiler& profiler) {
+  std::ostringstream os;
+  profiler.print(os);
+  return os.str();
+}
+
+}  // namespace
+
 void exposeMPCWalk() {
+  bp::enum_<TickProfiler::Phase>("TickPhase")
+      .value("RECEDE", TickProfiler::RECEDE)
+      .value("WARM_START", TickProfiler::WARM_START)
+      .value("CALC_DIFF", TickProfiler::CALC_DIFF)
+      .value("BACKWARD_PASS", TickProfiler::BACKWARD_PASS)
+      .value("FORWARD_PASS", TickProfiler::FORWARD_PASS)
+      .value("LINE_SEARCH", TickProfiler::LINE_SEARCH)
+      .value("SOLVE", TickProfiler::SOLVE)
+      .value("TICK", TickProfiler::TICK);
+
+  bp::class_<LatencyHistogram>(
+      "LatencyHistogram",
+      "Histogram of durations (s) with logarithmic buckets, 3% resolution.",
+      bp::init<>(bp::args("self")))
+      .def("record", &LatencyHistogram::record, bp::args("self", "seconds"))
+      .def("reset", &LatencyHistogram::reset, bp::args("self"))
+      .def("percentile", &LatencyHistogram::getPercentile,
+           bp::args("self", "p"),
+           "Duration below which p percent of the records are.")
+      .add_property("count", &LatencyHistogram::get_count)
+      .add_property("min", &LatencyHistogram::get_min)
+      .add_property("max", &LatencyHistogram::get_max)
+      .add_property("mean", &LatencyHistogram::get_mean);
+
+  bp::class_<TickProfiler, boost::noncopyable>(
+      "TickProfiler", "Latency histograms of the phases of an MPC tick.",
+      bp::no_init)
+      .def_readwrite("enabled", &TickProfiler::enabled)
+      .def("histogram", &TickProfiler::get_histogram, bp::args("self", "phase"),
+           bp::return_internal_reference<>())
+      .def("reset", &TickProfiler::reset, bp::args("self"))
+      .def("__str__", &printTickProfiler);
+
+  bp::class_<FeedbackPolicy, boost::noncopyable>(
+      "FeedbackPolicy",
+      "Feedback policy of the first node of the MPC, interpolated over the "
+      "control sub-steps.",
+      bp::no_init)
+      .def<const Eigen::VectorXd& (FeedbackPolicy::*)(
+          const int, const Eigen::Ref<const Eigen::VectorXd>&)>(
+          "calc", &FeedbackPolicy::calc, bp::args("self", "k", "x"),
+          bp::return_value_policy<bp::copy_const_reference>(),
+          "Control at sub-step k of the first node for the measured state x.")
+      .add_property("nsubsteps", &FeedbackPolicy::get_nsubsteps)
+      .add_property("xs0",
+                    bp::make_function(&FeedbackPolicy::get_xs0,
+                                      bp::return_internal_reference<>()))
+      .add_property("us0",
+                    bp::make_function(&FeedbackPolicy::get_us0,
+                                      bp::return_internal_reference<>()))
+      .add_property("K0",
+                    bp::make_function(&FeedbackPolicy::get_K0,
+                                      bp::return_internal_reference<>()));
+
   bp::register_ptr_to_python<boost::shared_ptr<MPCWalk> >();
 
   bp::class_<MPCWalk>("MPCWalk",
@@ -53,6 +118,15 @@ void exposeMPCWalk() {
                     "duration of the single-support phase")
       .add_property("Tend", &MPCWalk::get_Tend, &MPCWalk::set_Tend,
                     "duration of end the phase")
+      .add_property("Tfine", bp::make_getter(&MPCWalk::Tfine),
+                    bp::make_setter(&MPCWalk::Tfine),
+                    "number of nodes of duration DT at the beginning of the "
+                    "horizon, when coarseStride > 1")
+      .add_property("coarseStride", bp::make_getter(&MPCWalk::coarseStride),
+                    bp::make_setter(&MPCWalk::coarseStride),
+                    "duration of the nodes after Tfine, in number of DT")
+      .add_property("horizonTicks", &MPCWalk::get_horizonTicks,
+                    "duration of the horizon, in number of DT")
       .add_property(
           "vcomRef",
           bp::make_getter(&MPCWalk::vcomRef, bp::return_internal_reference<>()),
@@ -68,6 +142,37 @@ void exposeMPCWalk() {
       .add_property("solver_maxiter", bp::make_getter(&MPCWalk::solver_maxiter),
                     bp::make_setter(&MPCWalk::solver_maxiter),
                     "maxiter param to configure the solver.")
+      .add_property(
+          "solver_deadline", bp::make_getter(&MPCWalk::solver_deadline),
+          bp::make_setter(&MPCWalk::solver_deadline),
+          "Wall-clock budget of calc in seconds (0 to disable the deadline).")
+      .add_property("nthreads", bp::make_getter(&MPCWalk::nthreads),
+                    bp::make_setter(&MPCWalk::nthreads),
+                    "Number of threads used to evaluate the shooting nodes "
+                    "(to be set before initialize).")
+      .add_property(
+          "compactStorage", bp::make_getter(&MPCWalk::compactStorage),
+          bp::make_setter(&MPCWalk::compactStorage),
+          "Keep in storage only the nodes of the start phase and of one gait "
+          "cycle (to be set before initialize).")
+      .add_property("policySubsteps", bp::make_getter(&MPCWalk::policySubsteps),
+                    bp::make_setter(&MPCWalk::policySubsteps),
+                    "Number of control sub-steps in one node, used by policy "
+                    "(to be set before initialize).")
+      .add_property(
+          "policy",
+          bp::make_getter(&MPCWalk::policy, bp::return_internal_reference<>()),
+          "Feedback policy of the first node, updated by calc.")
+      .add_property("profiler",
+                    bp::make_getter(&MPCWalk::profiler,
+                                    bp::return_internal_reference<>()),
+                    "Latency histograms of the phases of calc.")
+      .add_property("deadlineHit", &MPCWalk::get_deadlineHit,
+                    "True if the last calc was stopped by the deadline.")
+      .add_property("iterations", &MPCWalk::get_iterations,
+                    "Number of solver iterations done in the last calc.")
+      .add_property("iterationTime", &MPCWalk::get_iterationTime,
+                    "Predicted duration of one solver iteration (s).")
       .add_property("DT", bp::make_getter(&MPCWalk::DT),
                     bp::make_setter(&MPCWalk::DT),
                     "time step duration of the shooting nodes.")
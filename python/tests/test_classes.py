@@ -6,9 +6,12 @@ Created on Sat Jun 11 14:44:53 2022
 """
 
 
+import os
+import tempfile
 import unittest
 
 # import numpy as np
+import pinocchio
 
 from pyRobotWrapper import PinTalos
 from pyOCP_horizon import ReceidingHorizon
@@ -134,6 +137,7 @@ class ClasesTestCase(unittest.TestCase):
         )
 
         self.design = design
+        self.design_conf = design_conf
         self.py_design = py_design
         self.horizon = horizon
         self.py_horizon = py_horizon
@@ -199,6 +203,26 @@ class ClasesTestCase(unittest.TestCase):
             ).all()
         )
 
+    def test_reduced_kinematics(self):
+        q = self.design.get_q0().copy()
+        q[7:] += 0.1 * np.random.rand(q.size - 7)
+        self.design.updateReducedModel(q)
+        LF, RF = self.design.get_LF_frame(), self.design.get_RF_frame()
+        com = self.design.get_com_position()
+
+        self.design.updateReducedModel(self.design.get_q0())
+        self.design.updateReducedKinematics(q, withCoM=False)
+        self.assertTrue(
+            np.allclose(LF.homogeneous, self.design.get_LF_frame().homogeneous)
+        )
+        self.assertTrue(
+            np.allclose(RF.homogeneous, self.design.get_RF_frame().homogeneous)
+        )
+
+        self.design.updateReducedKinematics(q)
+        self.assertTrue(np.allclose(com, self.design.get_com_position()))
+        self.assertTrue(np.allclose(LF.translation, self.design.get_LF_position()))
+
     def test_OCP(self):
 
         self.assertEqual(self.horizon.iam(0).dt, self.py_horizon.IAM(0).dt)
@@ -226,6 +250,323 @@ class ClasesTestCase(unittest.TestCase):
 
     #        self.assertTrue(self.horizon.ddp.solve())
 
+    def test_designer_cache(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            conf = dict(self.design_conf, cachePath=os.path.join(tmp, "talos.bin"))
+            built = RobotDesigner()
+            built.initialize(conf)
+            self.assertTrue(os.path.exists(conf["cachePath"]))
+            # The temporary file is renamed into the cache.
+            self.assertEqual(os.listdir(tmp), ["talos.bin"])
+            cached = RobotDesigner()
+            cached.initialize(conf)
+            self.assertFalse(built.get_loadedFromCache())
+            self.assertTrue(cached.get_loadedFromCache())
+
+            # Other controlled joints invalidate the cache, which is rebuilt
+            # for them.
+            joints = conf["controlledJointsNames"][:-1]
+            otherConf = dict(conf, controlledJointsNames=joints)
+            other = RobotDesigner()
+            other.initialize(otherConf)
+            self.assertFalse(other.get_loadedFromCache())
+            self.assertEqual(other.get_rModel().nq, self.design.get_rModel().nq - 1)
+            other.initialize(otherConf)
+            self.assertTrue(other.get_loadedFromCache())
+            self.assertEqual(other.get_rModel().nq, self.design.get_rModel().nq - 1)
+            built.initialize(conf)
+            self.assertFalse(built.get_loadedFromCache())
+
+        for design in [built, cached]:
+            self.assertEqual(design.get_rModel().nq, self.design.get_rModel().nq)
+            self.assertEqual(
+                design.get_rModelComplete().nv, self.design.get_rModelComplete().nv
+            )
+            self.assertTrue((design.get_x0() == self.design.get_x0()).all())
+            self.assertTrue(
+                (design.get_q0Complete() == self.design.get_q0Complete()).all()
+            )
+            self.assertEqual(
+                design.get_controlledJointsIDs().tolist(),
+                self.design.get_controlledJointsIDs().tolist(),
+            )
+            self.assertEqual(design.get_LF_id(), self.design.get_LF_id())
+
+    def test_formulate_threads(self):
+        def formulate(nthreads, supports):
+            conf = self.formuler.get_settings()
+            conf["nthreads"] = nthreads
+            maker = ModelMaker()
+            maker.initialize(conf, self.design)
+            return maker.formulateHorizon(supports)
+
+        def asArray(reference):
+            if isinstance(reference, pinocchio.SE3):
+                return reference.homogeneous
+            if hasattr(reference, "A"):
+                return reference.A
+            return np.array(reference)
+
+        def describe(model):
+            """Contact set, and weight and references of each cost."""
+            costs = {}
+            for item in model.differential.costs.costs:
+                cost = item.data().cost
+                references = [
+                    asArray(getattr(obj, attr))
+                    for obj, attr in [
+                        (cost.residual, "reference"),
+                        (cost.activation, "weights"),
+                        (cost.activation, "reference"),
+                    ]
+                    if hasattr(obj, attr)
+                ]
+                costs[item.key()] = (item.data().weight, references)
+            return sorted(model.differential.contacts.active_set), costs
+
+        # The nodes built in parallel are the same as the serial ones.
+        supports = [Support.LEFT, Support.DOUBLE, Support.RIGHT] * 5
+        models = formulate(4, supports)
+        serialModels = formulate(1, supports)
+        self.assertEqual(len(models), len(supports))
+        for model, serialModel, support in zip(models, serialModels, supports):
+            contacts, costs = describe(model)
+            serialContacts, serialCosts = describe(serialModel)
+            self.assertEqual(len(contacts), 2 if support == Support.DOUBLE else 1)
+            self.assertEqual(contacts, serialContacts)
+            self.assertEqual(sorted(costs), sorted(serialCosts))
+            for name, (weight, references) in costs.items():
+                serialWeight, serialReferences = serialCosts[name]
+                self.assertEqual(weight, serialWeight, name)
+                self.assertEqual(len(references), len(serialReferences), name)
+                for reference, serialReference in zip(references, serialReferences):
+                    self.assertTrue(np.array_equal(reference, serialReference), name)
+
+    def test_wrench_references(self):
+        # Roll the right ankle, so that the cones of the feet differ.
+        design = RobotDesigner()
+        design.initialize(self.design_conf)
+        model = design.get_rModel()
+        q = design.get_q0().copy()
+        q[model.joints[model.getJointId("leg_right_6_joint")].idx_q] += 0.3
+        design.updateReducedModel(q)
+        maker = ModelMaker()
+        maker.initialize(self.formuler.get_settings(), design)
+
+        Mg = -design.getRobotMass() * maker.get_settings()["gravity"][2]
+        supports = [Support.LEFT, Support.RIGHT, Support.DOUBLE]
+        models = maker.formulateHorizon(supports)
+        feet = {"wrench_LF": Support.LEFT, "wrench_RF": Support.RIGHT}
+        for node, support in zip(models, supports):
+            costs = node.differential.costs.costs
+            for name, foot in feet.items():
+                wrench = np.zeros(6)
+                if support == Support.DOUBLE:
+                    wrench[2] = Mg / 2
+                elif support == foot:
+                    wrench[2] = Mg
+                # Each activation reference is computed with the cone of its
+                # foot, as HorizonManager::setForceReferenceLF/RF do.
+                cost = costs[name].cost
+                self.assertTrue(
+                    np.allclose(
+                        cost.activation.reference, cost.residual.reference.A @ wrench
+                    ),
+                    (support, name),
+                )
+
+        coneLF = models[2].differential.costs.costs["wrench_LF"].cost.residual
+        coneRF = models[2].differential.costs.costs["wrench_RF"].cost.residual
+        wrench = np.array([0, 0, Mg / 2, 0, 0, 0])
+        self.assertFalse(
+            np.allclose(coneLF.reference.A @ wrench, coneRF.reference.A @ wrench)
+        )
+
+    def test_zero_weight_costs(self):
+        # wVCoM is 0 in the configuration: the cost is kept, but inactive.
+        costs = self.horizon.costs(0).costs
+        self.assertEqual(costs["comVelocity"].weight, 0)
+        self.assertFalse(costs["comVelocity"].active)
+        self.assertTrue(costs["placement_LF"].active)
+
+        self.horizon.setCostWeight(0, "comVelocity", 1.0)
+        self.assertTrue(self.horizon.costs(0).costs["comVelocity"].active)
+        self.horizon.setVelocityRefCOM(0, np.array([0.1, 0, 0]))
+        self.horizon.setCostWeight(0, "comVelocity", 0.0)
+        self.assertFalse(self.horizon.costs(0).costs["comVelocity"].active)
+
+    def test_cost_stack_reports(self):
+        supports = [Support.LEFT, Support.DOUBLE, Support.RIGHT]
+        models = self.formuler.formulateHorizon(supports)
+        reports = self.formuler.get_costStackReports()
+        self.assertEqual(len(reports), len(supports))
+        for model, report in zip(models, reports):
+            costs = model.differential.costs.costs
+            # wVCoM is 0 in the configuration.
+            zeroWeights = [item.key() for item in costs if item.data().weight == 0]
+            self.assertIn("comVelocity", report.deactivated)
+            self.assertEqual(sorted(report.deactivated), sorted(zeroWeights))
+            self.assertIn("comVelocity", str(report))
+            for quantity, names in report.sharedQuantities.items():
+                self.assertGreater(len(names), 1, quantity)
+                for name in names:
+                    self.assertTrue(costs[name].active, name)
+
+        # formulateStepTracker reports its single node.
+        self.formuler.formulateStepTracker(Support.DOUBLE)
+        reports = self.formuler.get_costStackReports()
+        self.assertEqual(len(reports), 1)
+        self.assertIn("comVelocity", reports[0].deactivated)
+
+    def test_recede_pool(self):
+        horizon = self.horizon
+        T = horizon.size()
+        model = horizon.ama(0)
+        horizon.reserveData([model])
+        for t in range(T):
+            horizon.recede(model)
+            self.assertTrue(horizon.ama(T - 1) is model)
+
+        # Each node of the pooled model has its own data: the tags written in
+        # the datas are all kept.
+        for t in range(T):
+            horizon.ada(t).cost = t + 1.0
+        self.assertEqual([horizon.ada(t).cost for t in range(T)], list(range(1, T + 1)))
+
+        # The data leaving the horizon is the one of the entering node, and no
+        # other data is created: the tags only move along the horizon.
+        for t in range(T):
+            leaving = horizon.ada(0).cost
+            horizon.recede(model)
+            self.assertEqual(horizon.ada(T - 1).cost, leaving)
+        tags = sorted(horizon.ada(t).cost for t in range(T))
+        self.assertEqual(tags, list(range(1, T + 1)))
+
+        self.assertEqual(T, self.py_horizon.ddp.problem.T)
+        ddp = horizon.ddp
+        ddp.problem.calc(ddp.xs, ddp.us)
+
+    def test_handles(self):
+        horizon = self.horizon
+        T = horizon.size()
+        pose = pinocchio.SE3.Random()
+        wrench = np.random.rand(6)
+        velocity = np.random.rand(3)
+
+        def placement(costs, name="placement_LF"):
+            return costs.costs[name].cost.residual.reference
+
+        def checkNode(costs):
+            # References set through the handles are those of the node costs.
+            self.assertTrue(placement(costs).isApprox(pose))
+            comVelocity = costs.costs["comVelocity"].cost.residual.reference
+            self.assertTrue(np.allclose(comVelocity, velocity))
+            wrenchCost = costs.costs["wrench_LF"].cost
+            self.assertTrue(
+                np.allclose(
+                    wrenchCost.activation.reference,
+                    wrenchCost.residual.reference.A @ wrench,
+                )
+            )
+
+        def setNode(time):
+            horizon.setPoseReferenceLF(time, pose)
+            horizon.setVelocityRefCOM(time, velocity)
+            horizon.setForceReferenceLF(time, wrench)
+
+        setNode(0)
+        checkNode(horizon.costs(0))
+
+        # After recede(), the handles follow the nodes: the last node is the
+        # previous first one, the first node the previous second one.
+        first = horizon.costs(0)
+        horizon.recede()
+        pose = pinocchio.SE3.Random()
+        setNode(T - 1)
+        checkNode(first)
+        checkNode(horizon.costs(T - 1))
+        setNode(0)
+        checkNode(horizon.costs(0))
+
+        # recede(model, data) resolves the handles of the new model.
+        model = self.formuler.formulateHorizon([Support.DOUBLE])[0]
+        horizon.recede(model, model.createData())
+        pose = pinocchio.SE3.Random()
+        setNode(T - 1)
+        checkNode(model.differential.costs)
+
+        # recede(model, data, handles) uses the given handles.
+        other = self.formuler.formulateHorizon([Support.DOUBLE])[0]
+        horizon.recede(other, other.createData(), horizon.resolveHandles(other))
+        pose = pinocchio.SE3.Random()
+        setNode(T - 1)
+        checkNode(other.differential.costs)
+        self.assertFalse(placement(model.differential.costs).isApprox(pose))
+
+    def test_handle_names(self):
+        # The cost names of the handles are read from the settings.
+        H_conf = dict(
+            leftFootName=self.design_conf["leftFootName"],
+            rightFootName=self.design_conf["rightFootName"],
+            placementLFName="placement_RF",
+        )
+        models = self.formuler.formulateHorizon([Support.DOUBLE] * 3)
+        horizon = HorizonManager()
+        horizon.initialize(H_conf, self.design.get_x0(), models, models[-1])
+        pose = pinocchio.SE3.Random()
+        horizon.setPoseReferenceLF(1, pose)
+        costs = horizon.costs(1).costs
+        self.assertTrue(costs["placement_RF"].cost.residual.reference.isApprox(pose))
+        self.assertFalse(costs["placement_LF"].cost.residual.reference.isApprox(pose))
+
+    def test_bulk_setters(self):
+        horizon = self.horizon
+        # The first node is not the first slot of the handles any more.
+        for _ in range(3):
+            horizon.recede()
+        n = horizon.size() - 1
+
+        poses = [pinocchio.SE3.Random() for _ in range(n)]
+        velocities = np.random.rand(n, 6)[:, ::2]
+        wrenches = np.random.rand(6, n).T
+        self.assertFalse(velocities.flags["C_CONTIGUOUS"])
+        self.assertFalse(wrenches.flags["C_CONTIGUOUS"])
+
+        def references(t):
+            costs = horizon.costs(t).costs
+            return (
+                costs["placement_LF"].cost.residual.reference.copy(),
+                costs["comVelocity"].cost.residual.reference.copy(),
+                costs["wrench_LF"].cost.activation.reference.copy(),
+            )
+
+        for t in range(n):
+            horizon.setPoseReferenceLF(t, poses[t])
+            horizon.setVelocityRefCOM(t, velocities[t])
+            horizon.setForceReferenceLF(t, wrenches[t])
+        expected = [references(t) for t in range(n)]
+        for t in range(n):
+            horizon.setPoseReferenceLF(t, pinocchio.SE3.Identity())
+            horizon.setVelocityRefCOM(t, np.zeros(3))
+            horizon.setForceReferenceLF(t, np.zeros(6))
+
+        # Non-contiguous rows, with quaternions that are not normalized.
+        xyzquat = np.zeros((n, 14))
+        xyzquat[:, ::2] = [pinocchio.SE3ToXYZQUAT(pose) for pose in poses]
+        xyzquat[:, 6:14:2] *= 2.0
+        self.assertFalse(xyzquat[:, ::2].flags["C_CONTIGUOUS"])
+        horizon.setPoseReferencesLF(xyzquat[:, ::2])
+        horizon.setVelocityRefsCOM(velocities)
+        horizon.setForceReferencesLF(wrenches)
+
+        for t in range(n):
+            pose, velocity, wrench = references(t)
+            self.assertTrue(pose.isApprox(expected[t][0]))
+            rotation = pose.rotation
+            self.assertTrue(np.allclose(rotation @ rotation.T, np.eye(3)))
+            self.assertTrue(np.allclose(velocity, expected[t][1]))
+            self.assertTrue(np.allclose(wrench, expected[t][2]))
+
     def test_MPC(self):
 
         nq = self.design.get_rModelComplete().nq
@@ -236,6 +577,14 @@ class ClasesTestCase(unittest.TestCase):
             (self.mpc.shapeState(q, v) == self.py_mpc.shapeState(q, v)).all()
         )
 
+        # The torques scattered in the complete model are gathered back.
+        nq_r = self.design.get_rModel().nq
+        nu = self.design.get_rModel().nv - 6
+        u = np.random.rand(nu)
+        tau = self.mpc.scatterTorques(u, np.zeros(nv - 6))
+        x = self.mpc.shapeState(q, np.concatenate([np.zeros(6), tau]))
+        self.assertTrue((x[nq_r + 6 :] == u).all())
+
         self.mpc.generateFullCycle(self.formuler)
         self.assertTrue(isinstance(self.mpc.walkingCycle, HorizonManager))
         self.assertEqual(self.mpc.walkingCycle.ddp.problem.T, 2 * self.Tstep)
@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#include "sobec/trace.hpp"
+
+#include <boost/python.hpp>
+
+namespace sobec {
+namespace python {
+namespace bp = boost::python;
+
+void exposeTrace() {
+  bp::def("startTrace", &trace::start, (bp::arg("path") = ""),
+          "Start writing the trace events to the file at path, or to the "
+          "console if path is empty.");
+  bp::def("stopTrace", &trace::stop,
+          "Stop the trace, after writing the pending events.");
+}
+
+}  // namespace python
+}  // namespace sobec
@@ -33,6 +33,13 @@ void initialize(WBC &self, const bp::dict &settings,
   self.initialize(conf, designer, horizon, q0, v0, actuationCostName);
 }
 
+Eigen::VectorXd scatterTorques(WBC &self, const Eigen::VectorXd &u,
+                               const Eigen::VectorXd &tau) {
+  Eigen::VectorXd out = tau;
+  self.scatterTorques(u, out);
+  return out;
+}
+
 void exposeWBC() {
   bp::class_<WBC>("WBC", bp::init<>())
       .def("initialize", &initialize,
@@ -40,7 +47,13 @@ void exposeWBC() {
                     "actuationCostName"),
            "The posture required here is the full robot posture in the order "
            "of pinicchio")
-      .def("shapeState", &WBC::shapeState, bp::args("self", "q", "v"))
+      .def<const Eigen::VectorXd &(WBC::*)(const Eigen::VectorXd &,
+                                           const Eigen::VectorXd &)>(
+          "shapeState", &WBC::shapeState, bp::args("self", "q", "v"),
+          bp::return_value_policy<bp::copy_const_reference>())
+      .def("scatterTorques", &scatterTorques, bp::args("self", "u", "tau"),
+           "Copy of tau with the torques u of the reduced model written in "
+           "the controlled joints.")
       .def("generateWalkigCycle", &WBC::generateWalkigCycle,
            bp::args("self", "modelMaker"))
       .def("iterate", &WBC::iterate,
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "sobec/cost-stack.hpp"
+
+#include <crocoddyl/core/utils/exception.hpp>
+#include <ostream>
+#include <sstream>
+
+#include "sobec/fwd.hpp"
+
+namespace sobec {
+
+namespace {
+
+template <typename Derived>
+boost::shared_ptr<Derived> as(
+    const boost::shared_ptr<crocoddyl::ResidualModelAbstract> &residual) {
+  return boost::dynamic_pointer_cast<Derived>(residual);
+}
+
+std::string frameQuantity(const std::string &quantity,
+                          const pinocchio::FrameIndex id) {
+  std::ostringstream os;
+  os << quantity << " of frame " << id;
+  return os.str();
+}
+
+// Pinocchio quantity read by a residual, or an empty string if it reads none
+// (or an unknown one).
+std::string pinocchioQuantity(
+    const boost::shared_ptr<crocoddyl::ResidualModelAbstract> &residual) {
+  if (boost::shared_ptr<crocoddyl::ResidualModelFramePlacement> r =
+          as<crocoddyl::ResidualModelFramePlacement>(residual)) {
+    return frameQuantity("placement", r->get_id());
+  } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameTranslation> r =
+                 as<crocoddyl::ResidualModelFrameTranslation>(residual)) {
+    return frameQuantity("placement", r->get_id());
+  } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameRotation> r =
+                 as<crocoddyl::ResidualModelFrameRotation>(residual)) {
+    return frameQuantity("placement", r->get_id());
+  } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameVelocity> r =
+                 as<crocoddyl::ResidualModelFrameVelocity>(residual)) {
+    return frameQuantity("velocity", r->get_id());
+  } else if (as<crocoddyl::ResidualModelCoMPosition>(residual)) {
+    return "com position";
+  } else if (as<ResidualModelCoMVelocity>(residual)) {
+    return "com velocity";
+  } else if (boost::shared_ptr<crocoddyl::ResidualModelContactWrenchCone> r =
+                 as<crocoddyl::ResidualModelContactWrenchCone>(residual)) {
+    return frameQuantity("contact force", r->get_id());
+  } else if (boost::shared_ptr<crocoddyl::ResidualModelContactForce> r =
+                 as<crocoddyl::ResidualModelContactForce>(residual)) {
+    return frameQuantity("contact force", r->get_id());
+  }
+  return "";
+}
+
+}  // namespace
+
+CostStackReport compileCostStack(crocoddyl::CostModelSum &costs) {
+  CostStackReport report;
+  std::map<std::string, std::vector<std::string> > readers;
+  for (const auto &item : costs.get_costs()) {
+    if (item.second->weight == 0.) {
+      if (item.second->active) {
+        costs.changeCostStatus(item.first, false);
+        report.deactivated.push_back(item.first);
+      }
+      continue;
+    }
+    if (!item.second->active) continue;
+    const std::string quantity =
+        pinocchioQuantity(item.second->cost->get_residual());
+    if (!quantity.empty()) readers[quantity].push_back(item.first);
+  }
+  for (const auto &reader : readers) {
+    if (reader.second.size() > 1) report.sharedQuantities.insert(reader);
+  }
+  return report;
+}
+
+void setCostWeight(crocoddyl::CostModelSum &costs, const std::string &name,
+                   const double weight) {
+  const auto it = costs.get_costs().find(name);
+  if (it == costs.get_costs().end()) {
+    throw_pretty("Invalid argument: the cost " << name << " does not exist");
+  }
+  it->second->weight = weight;
+  costs.changeCostStatus(name, weight != 0.);
+}
+
+std::ostream &operator<<(std::ostream &os, const CostStackReport &report) {
+  os << "Deactivated:";
+  for (const std::string &name : report.deactivated) os << " " << name;
+  os << std::endl;
+  for (const auto &shared : report.sharedQuantities) {
+    os << shared.first << ":";
+    for (const std::string &name : shared.second) os << " " << name;
+    os << std::endl;
+  }
+  return os;
+}
+
+}  // namespace sobec
@@ -1,12 +1,84 @@
 #include "sobec/designer.hpp"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <pinocchio/algorithm/compute-all-terms.hpp>
 #include <pinocchio/algorithm/frames.hpp>
+#include <pinocchio/config.hpp>
 #include <pinocchio/parsers/srdf.hpp>
 #include <pinocchio/parsers/urdf.hpp>
+#include <pinocchio/serialization/eigen.hpp>
+#include <pinocchio/serialization/model.hpp>
+#include <set>
+#include <sstream>
+
+#include "sobec/trace.hpp"
 
 namespace sobec {
 
+namespace {
+
+const char kCacheMagic[8] = {'S', 'O', 'B', 'E', 'C', 'R', 'D', '\0'};
+const std::uint32_t kCacheVersion = 1;
+
+// 64-bit FNV-1a.
+const std::uint64_t kFnvOffset = 14695981039346656037ULL;
+const std::uint64_t kFnvPrime = 1099511628211ULL;
+
+void fnv1a(std::uint64_t &hash, const char *data, const std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= kFnvPrime;
+  }
+}
+
+// Hash the content of a file, or its path when it cannot be read (the build
+// will then report the error).
+void fnv1aFile(std::uint64_t &hash, const std::string &path) {
+  std::ifstream is(path.c_str(), std::ios::binary);
+  if (!is) {
+    fnv1a(hash, path.c_str(), path.size() + 1);
+    return;
+  }
+  const std::string content((std::istreambuf_iterator<char>(is)),
+                            std::istreambuf_iterator<char>());
+  fnv1a(hash, content.data(), content.size());
+}
+
+// Hash of everything the cached models are built from, including the version
+// of pinocchio that serialized them. The strings are hashed with their
+// terminating null, so that their boundaries count.
+std::uint64_t descriptionHash(const RobotDesignerSettings &settings) {
+  std::uint64_t hash = kFnvOffset;
+  const int pinocchioVersion[3] = {PINOCCHIO_MAJOR_VERSION,
+                                   PINOCCHIO_MINOR_VERSION,
+                                   PINOCCHIO_PATCH_VERSION};
+  fnv1a(hash, reinterpret_cast<const char *>(pinocchioVersion),
+        sizeof(pinocchioVersion));
+  if (settings.robotDescription.size() > 0) {
+    fnv1a(hash, settings.robotDescription.data(),
+          settings.robotDescription.size());
+  } else {
+    fnv1aFile(hash, settings.urdfPath);
+  }
+  fnv1a(hash, "", 1);
+  fnv1aFile(hash, settings.srdfPath);
+  fnv1a(hash, "", 1);
+  for (const std::string &name : settings.controlledJointsNames)
+    fnv1a(hash, name.c_str(), name.size() + 1);
+  return hash;
+}
+
+}  // namespace
+
 RobotDesigner::RobotDesigner() {}
 
 RobotDesigner::RobotDesigner(const RobotDesignerSettings &settings) {
@@ -15,48 +87,79 @@ RobotDesigner::RobotDesigner(const RobotDesignerSettings &settings) {
 
 void RobotDesigner::initialize(const RobotDesignerSettings &settings) {
   settings_ = settings;
+  if (settings_.robotDescription.empty() && settings_.urdfPath.empty()) {
+    throw std::invalid_argument(
+        "the urdf file, or robotDescription must be specified.");
+  }
+  if (settings_.controlledJointsNames.empty() ||
+      settings_.controlledJointsNames[0] != "root_joint") {
+    throw std::invalid_argument(
+        "the joint at index 0 must be called 'root_joint' ");
+  }
+
+  const bool useCache = !settings_.cachePath.empty();
+  const std::uint64_t hash = useCache ? descriptionHash(settings_) : 0;
+  loadedFromCache_ = useCache && loadCache(hash);
+  if (!loadedFromCache_) {
+    buildModels();
+    if (useCache) saveCache(hash);
+  }
+  rDataComplete_ = pinocchio::Data(rModelComplete_);
+  rData_ = pinocchio::Data(rModel_);
+
+  v0Complete_ = Eigen::VectorXd::Zero(rModelComplete_.nv);
+  v0_ = Eigen::VectorXd::Zero(rModel_.nv);
+  x0_.resize(rModel_.nq + rModel_.nv);
+  x0_ << q0_, v0_;
+
+  leftFootId_ = rModel_.getFrameId(settings_.leftFootName);
+  rightFootId_ = rModel_.getFrameId(settings_.rightFootName);
+
+  const std::vector<pinocchio::JointIndex> &LF_support =
+      rModel_.supports[rModel_.frames[leftFootId_].parent];
+  const std::vector<pinocchio::JointIndex> &RF_support =
+      rModel_.supports[rModel_.frames[rightFootId_].parent];
+  feetChain_.clear();
+  std::set_union(LF_support.begin() + 1, LF_support.end(),
+                 RF_support.begin() + 1, RF_support.end(),
+                 std::back_inserter(feetChain_));
+
+  updateReducedModel(q0_);
+  initialized_ = true;
+}
 
+void RobotDesigner::buildModels() {
   // COMPLETE MODEL //
+  rModelComplete_ = pinocchio::Model();
   if (settings_.robotDescription.size() > 0) {
     pinocchio::urdf::buildModelFromXML(settings_.robotDescription,
                                        pinocchio::JointModelFreeFlyer(),
                                        rModelComplete_);
-    std::cout << "### Build pinocchio model from rosparam robot_description."
-              << std::endl;
-  } else if (settings_.urdfPath.size() > 0) {
+    SOBEC_TRACE_INFO("Build pinocchio model from rosparam robot_description");
+  } else {
     pinocchio::urdf::buildModel(
         settings_.urdfPath, pinocchio::JointModelFreeFlyer(), rModelComplete_);
-    std::cout << "### Build pinocchio model from urdf file." << std::endl;
-  } else {
-    throw std::invalid_argument(
-        "the urdf file, or robotDescription must be specified.");
+    SOBEC_TRACE_INFO("Build pinocchio model from urdf file");
   }
-  rDataComplete_ = pinocchio::Data(rModelComplete_);
 
   pinocchio::srdf::loadReferenceConfigurations(rModelComplete_,
                                                settings_.srdfPath, false);
   pinocchio::srdf::loadRotorParameters(rModelComplete_, settings_.srdfPath,
                                        false);
   q0Complete_ = rModelComplete_.referenceConfigurations["half_sitting"];
-  v0Complete_ = Eigen::VectorXd::Zero(rModelComplete_.nv);
 
   // REDUCED MODEL //
-
-  if (settings_.controlledJointsNames[0] != "root_joint") {
-    throw std::invalid_argument(
-        "the joint at index 0 must be called 'root_joint' ");
-  }
+  const std::set<std::string> controlled(
+      settings_.controlledJointsNames.begin(),
+      settings_.controlledJointsNames.end());
 
   // Check if listed joints belong to model
-  for (std::vector<std::string>::const_iterator it =
-           settings_.controlledJointsNames.begin();
-       it != settings_.controlledJointsNames.end(); ++it) {
-    const std::string &joint_name = *it;
-    std::cout << joint_name << std::endl;
-    std::cout << rModelComplete_.getJointId(joint_name) << std::endl;
+  for (const std::string &joint_name : settings_.controlledJointsNames) {
+    SOBEC_TRACE_INFO("Controlled joint", trace::Label(joint_name),
+                     rModelComplete_.getJointId(joint_name));
     if (not(rModelComplete_.existJointName(joint_name))) {
-      std::cout << "joint: " << joint_name << " does not belong to the model"
-                << std::endl;
+      SOBEC_TRACE_WARNING("Joint does not belong to the model",
+                          trace::Label(joint_name));
     }
   }
 
@@ -65,44 +168,88 @@ void RobotDesigner::initialize(const RobotDesignerSettings &settings) {
   for (std::vector<std::string>::const_iterator it =
            rModelComplete_.names.begin() + 1;
        it != rModelComplete_.names.end(); ++it) {
-    const std::string &joint_name = *it;
-    if (std::find(settings_.controlledJointsNames.begin(),
-                  settings_.controlledJointsNames.end(),
-                  joint_name) == settings_.controlledJointsNames.end()) {
-      locked_joints_id.push_back(rModelComplete_.getJointId(joint_name));
+    if (controlled.count(*it) == 0) {
+      locked_joints_id.push_back(rModelComplete_.getJointId(*it));
     }
   }
 
   rModel_ = pinocchio::buildReducedModel(rModelComplete_, locked_joints_id,
                                          q0Complete_);
-  rData_ = pinocchio::Data(rModel_);
 
   pinocchio::srdf::loadReferenceConfigurations(rModel_, settings_.srdfPath,
                                                false);
   pinocchio::srdf::loadRotorParameters(rModel_, settings_.srdfPath, false);
   q0_ = rModel_.referenceConfigurations["half_sitting"];
-  v0_ = Eigen::VectorXd::Zero(rModel_.nv);
-  x0_.resize(rModel_.nq + rModel_.nv);
-  x0_ << q0_, v0_;
+
   // Generating list of indices for controlled joints //
+  controlled_joints_id_.clear();
   for (std::vector<std::string>::const_iterator it = rModel_.names.begin() + 1;
        it != rModel_.names.end(); ++it) {
-    const std::string &joint_name = *it;
-    if (std::find(settings_.controlledJointsNames.begin(),
-                  settings_.controlledJointsNames.end(),
-                  joint_name) != settings_.controlledJointsNames.end()) {
-      controlled_joints_id_.push_back(rModelComplete_.getJointId(joint_name));
+    if (controlled.count(*it) > 0) {
+      controlled_joints_id_.push_back(rModelComplete_.getJointId(*it));
     }
   }
+}
 
-  leftFootId_ = rModel_.getFrameId(settings_.leftFootName);
-  rightFootId_ = rModel_.getFrameId(settings_.rightFootName);
+bool RobotDesigner::loadCache(const std::uint64_t hash) {
+  std::ifstream is(settings_.cachePath.c_str(), std::ios::binary);
+  if (!is) return false;
 
-  updateReducedModel(q0_);
-  initialized_ = true;
+  char magic[sizeof(kCacheMagic)];
+  std::uint32_t version = 0;
+  std::uint64_t fileHash = 0;
+  is.read(magic, sizeof(magic));
+  is.read(reinterpret_cast<char *>(&version), sizeof(version));
+  is.read(reinterpret_cast<char *>(&fileHash), sizeof(fileHash));
+  if (!is || std::memcmp(magic, kCacheMagic, sizeof(magic)) != 0 ||
+      version != kCacheVersion || fileHash != hash) {
+    SOBEC_TRACE_INFO("Model cache is outdated",
+                     trace::Label(settings_.cachePath));
+    return false;
+  }
+
+  try {
+    boost::archive::binary_iarchive ar(is);
+    ar >> rModelComplete_ >> rModel_ >> q0Complete_ >> q0_ >>
+        controlled_joints_id_;
+  } catch (const std::exception &e) {
+    SOBEC_TRACE_WARNING("Cannot read the model cache", trace::Label(e.what()));
+    return false;
+  }
+  SOBEC_TRACE_INFO("Models loaded from the cache",
+                   trace::Label(settings_.cachePath));
+  return true;
+}
+
+void RobotDesigner::saveCache(const std::uint64_t hash) {
+  // Write a temporary file of this process, then rename it, so that a
+  // concurrent start neither reads a partial cache nor writes the same file.
+  std::ostringstream tmpName;
+  tmpName << settings_.cachePath << "." << getpid() << ".tmp";
+  const std::string tmpPath = tmpName.str();
+  {
+    std::ofstream os(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!os) {
+      SOBEC_TRACE_WARNING("Cannot write the model cache",
+                          trace::Label(settings_.cachePath));
+      return;
+    }
+    os.write(kCacheMagic, sizeof(kCacheMagic));
+    os.write(reinterpret_cast<const char *>(&kCacheVersion),
+             sizeof(kCacheVersion));
+    os.write(reinterpret_cast<const char *>(&hash), sizeof(hash));
+    boost::archive::binary_oarchive ar(os);
+    ar << rModelComplete_ << rModel_ << q0Complete_ << q0_
+       << controlled_joints_id_;
+  }
+  if (std::rename(tmpPath.c_str(), settings_.cachePath.c_str()) != 0) {
+    SOBEC_TRACE_WARNING("Cannot write the model cache",
+                        trace::Label(settings_.cachePath));
+    std::remove(tmpPath.c_str());
+  }
 }
 
-void RobotDesigner::updateReducedModel(Eigen::VectorXd x) {
+void RobotDesigner::updateReducedModel(const Eigen::VectorXd &x) {
   /** x is the reduced posture, or contains the reduced posture in the first
    * elements */
   pinocchio::forwardKinematics(rModel_, rData_, x.head(rModel_.nq));
@@ -113,7 +260,7 @@ void RobotDesigner::updateReducedModel(Eigen::VectorXd x) {
   RF_position_ = rData_.oMf[rightFootId_].translation();
 }
 
-void RobotDesigner::updateCompleteModel(Eigen::VectorXd x) {
+void RobotDesigner::updateCompleteModel(const Eigen::VectorXd &x) {
   /** x is the complete posture, or contains the complete posture in the first
    * elements */
   pinocchio::forwardKinematics(rModelComplete_, rDataComplete_,
@@ -125,6 +272,43 @@ void RobotDesigner::updateCompleteModel(Eigen::VectorXd x) {
   RF_position_ = rData_.oMf[rightFootId_].translation();
 }
 
+void RobotDesigner::updateReducedKinematics(
+    const Eigen::Ref<const Eigen::VectorXd> &x, const bool withCoM) {
+  /** x is the reduced posture, or contains the reduced posture in the first
+   * elements */
+  const Eigen::Ref<const Eigen::VectorXd> q = x.head(rModel_.nq);
+  // Zero order of pinocchio::forwardKinematics, for the joint i.
+  auto updateJoint = [this, &q](const pinocchio::JointIndex i) {
+    rModel_.joints[i].calc(rData_.joints[i], q);
+    rData_.liMi[i] = rModel_.jointPlacements[i] * rData_.joints[i].M();
+    rData_.oMi[i] = rData_.oMi[rModel_.parents[i]] * rData_.liMi[i];
+  };
+
+  if (withCoM) {
+    // All the bodies contribute to the CoM.
+    Eigen::Vector3d com = Eigen::Vector3d::Zero();
+    double mass = 0;
+    for (pinocchio::JointIndex i = 1;
+         i < static_cast<pinocchio::JointIndex>(rModel_.njoints); ++i) {
+      updateJoint(i);
+      const pinocchio::Inertia &I = rModel_.inertias[i];
+      com += I.mass() * rData_.oMi[i].act(I.lever());
+      mass += I.mass();
+    }
+    com_position_ = com / mass;
+    rData_.com[0] = com_position_;
+  } else {
+    for (const pinocchio::JointIndex i : feetChain_) updateJoint(i);
+  }
+
+  LF_position_ =
+      pinocchio::updateFramePlacement(rModel_, rData_, leftFootId_)
+          .translation();
+  RF_position_ =
+      pinocchio::updateFramePlacement(rModel_, rData_, rightFootId_)
+          .translation();
+}
+
 pinocchio::SE3 RobotDesigner::get_LF_frame() { return rData_.oMf[leftFootId_]; }
 
 pinocchio::SE3 RobotDesigner::get_RF_frame() {
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <crocoddyl/core/utils/exception.hpp>
+
+#include "sobec/feedback-policy.hpp"
+
+namespace sobec {
+
+FeedbackPolicy::FeedbackPolicy() : nsubsteps_(1) {}
+
+void FeedbackPolicy::initialize(
+    boost::shared_ptr<crocoddyl::StateAbstract> state, const std::size_t nu,
+    const int nsubsteps) {
+  if (nsubsteps < 1) {
+    throw_pretty("Invalid argument: "
+                 << "nsubsteps should be at least 1");
+  }
+  state_ = state;
+  nsubsteps_ = nsubsteps;
+  const std::size_t ndx = state->get_ndx();
+  xs0_ = state->zero();
+  xref_ = state->zero();
+  us0_ = Eigen::VectorXd::Zero(nu);
+  us1_ = Eigen::VectorXd::Zero(nu);
+  u_ = Eigen::VectorXd::Zero(nu);
+  K0_ = Eigen::MatrixXd::Zero(nu, ndx);
+  K1_ = Eigen::MatrixXd::Zero(nu, ndx);
+  K_ = Eigen::MatrixXd::Zero(nu, ndx);
+  dx01_ = Eigen::VectorXd::Zero(ndx);
+  dx_ = Eigen::VectorXd::Zero(ndx);
+}
+
+void FeedbackPolicy::update(const crocoddyl::SolverDDP& solver) {
+  const std::vector<Eigen::VectorXd>& xs = solver.get_xs();
+  const std::vector<Eigen::VectorXd>& us = solver.get_us();
+  assert(us.size() > 0 && xs.size() == us.size() + 1);
+  // With a single node, the feed-forward and gains are constant.
+  const std::size_t n1 = us.size() > 1 ? 1 : 0;
+
+  xs0_ = xs[0];
+  us0_ = us[0];
+  us1_ = us[n1];
+  K0_ = solver.get_K()[0];
+  K1_ = solver.get_K()[n1];
+  state_->diff(xs[0], xs[1], dx01_);
+}
+
+void FeedbackPolicy::calc(const int k,
+                          const Eigen::Ref<const Eigen::VectorXd>& x,
+                          Eigen::Ref<Eigen::VectorXd> u) {
+  const double a =
+      static_cast<double>(std::min(std::max(k, 0), nsubsteps_)) / nsubsteps_;
+
+  // xref = xs[0] + a * (xs[1] - xs[0])
+  dx_.noalias() = a * dx01_;
+  state_->integrate(xs0_, dx_, xref_);
+  state_->diff(xref_, x, dx_);
+
+  K_.noalias() = (1 - a) * K0_ + a * K1_;
+  u.noalias() = (1 - a) * us0_ + a * us1_;
+  u.noalias() -= K_ * dx_;
+}
+
+const Eigen::VectorXd& FeedbackPolicy::calc(
+    const int k, const Eigen::Ref<const Eigen::VectorXd>& x) {
+  calc(k, x, u_);
+  return u_;
+}
+
+}  // namespace sobec
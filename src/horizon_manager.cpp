@@ -1,11 +1,104 @@
 #include "sobec/horizon_manager.hpp"
 
+#include <algorithm>
 #include <crocoddyl/core/integrator/euler.hpp>
 #include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
 #include <crocoddyl/multibody/fwd.hpp>
 
+#include "sobec/cost-stack.hpp"
+#include "sobec/trace.hpp"
+
 namespace sobec {
 
+namespace {
+
+template <typename Residual>
+boost::shared_ptr<Residual> findResidual(
+    const crocoddyl::CostModelSum::CostModelContainer &costs,
+    const std::string &name) {
+  crocoddyl::CostModelSum::CostModelContainer::const_iterator it =
+      costs.find(name);
+  if (it == costs.end()) return boost::shared_ptr<Residual>();
+  return boost::dynamic_pointer_cast<Residual>(
+      it->second->cost->get_residual());
+}
+
+template <typename Activation>
+boost::shared_ptr<Activation> findActivation(
+    const crocoddyl::CostModelSum::CostModelContainer &costs,
+    const std::string &name) {
+  crocoddyl::CostModelSum::CostModelContainer::const_iterator it =
+      costs.find(name);
+  if (it == costs.end()) return boost::shared_ptr<Activation>();
+  return boost::dynamic_pointer_cast<Activation>(
+      it->second->cost->get_activation());
+}
+
+template <typename T>
+const boost::shared_ptr<T> &checkHandle(const boost::shared_ptr<T> &handle,
+                                        const std::string &name) {
+  if (!handle) {
+    throw std::runtime_error("This node has no registered cost " + name);
+  }
+  return handle;
+}
+
+void checkRows(const Eigen::Index rows, const unsigned long size) {
+  if (rows < 0 || static_cast<unsigned long>(rows) > size) {
+    throw std::runtime_error("The buffer has more rows than the horizon has "
+                             "nodes (" +
+                             std::to_string(size) + ")");
+  }
+}
+
+void setPoseReferences(
+    const Eigen::Ref<const HorizonPoses> &poses,
+    const std::vector<NodeHandles> &handles, const unsigned long head,
+    ResidualModelFramePlacementPtr NodeHandles::*placement,
+    const std::string &name) {
+  pinocchio::SE3 pose;
+  for (Eigen::Index t = 0; t < poses.rows(); ++t) {
+    // The quaternion is normalized, so that the rotation stays orthonormal
+    // for inputs rounded or interpolated by the caller.
+    const Eigen::Quaterniond quat =
+        Eigen::Quaterniond(poses(t, 6), poses(t, 3), poses(t, 4), poses(t, 5))
+            .normalized();
+    pose.translation() = poses.row(t).head<3>().transpose();
+    pose.rotation() = quat.toRotationMatrix();
+    checkHandle(handles[(head + t) % handles.size()].*placement, name)
+        ->set_reference(pose);
+  }
+}
+
+// The activation reference of the cone is A * wrench, computed in the buffer
+// of the node.
+template <typename Wrench>
+void setForceReference(NodeHandles &h, const Eigen::MatrixBase<Wrench> &wrench,
+                       ResidualModelContactWrenchConePtr NodeHandles::*cone,
+                       ActivationModelQuadRefPtr NodeHandles::*activation,
+                       Eigen::VectorXd NodeHandles::*buffer,
+                       const std::string &name) {
+  (h.*buffer).noalias() =
+      checkHandle(h.*cone, name)->get_reference().get_A() * wrench;
+  checkHandle(h.*activation, name)->set_reference(h.*buffer);
+}
+
+void setForceReferences(const Eigen::Ref<const HorizonWrenches> &wrenches,
+                        std::vector<NodeHandles> &handles,
+                        const unsigned long head,
+                        ResidualModelContactWrenchConePtr NodeHandles::*cone,
+                        ActivationModelQuadRefPtr NodeHandles::*activation,
+                        Eigen::VectorXd NodeHandles::*buffer,
+                        const std::string &name) {
+  for (Eigen::Index t = 0; t < wrenches.rows(); ++t) {
+    setForceReference(handles[(head + t) % handles.size()],
+                      wrenches.row(t).transpose(), cone, activation, buffer,
+                      name);
+  }
+}
+
+}  // namespace
+
 HorizonManager::HorizonManager() {}
 
 HorizonManager::HorizonManager(const HorizonManagerSettings &settings,
@@ -23,12 +116,63 @@ void HorizonManager::initialize(const HorizonManagerSettings &settings,
   boost::shared_ptr<crocoddyl::ShootingProblem> shooting_problem =
       boost::make_shared<crocoddyl::ShootingProblem>(x0, runningModels,
                                                      terminalModel);
+  if (settings.nthreads > 0) shooting_problem->set_nthreads(settings.nthreads);
   ddp_ = boost::make_shared<crocoddyl::SolverFDDP>(shooting_problem);
-  new_ref_.resize(17);
+  nodes_ = boost::make_shared<HorizonNodes>();
+  allocated_size_ = size();
+  registerHandles();
 
   initialized_ = true;
 }
 
+void HorizonManager::registerHandles() {
+  nodes_->handles.resize(size());
+  nodes_->head = 0;
+  nodes_->modelHandles.clear();
+  for (unsigned long time = 0; time < size(); time++)
+    nodes_->handles[time] = resolveHandles(ama(time));
+}
+
+const NodeHandles &HorizonManager::modelHandles(const AMA &model) {
+  std::map<AMA, NodeHandles>::iterator it = nodes_->modelHandles.find(model);
+  if (it == nodes_->modelHandles.end())
+    it = nodes_->modelHandles.emplace(model, resolveHandles(model)).first;
+  return it->second;
+}
+
+NodeHandles HorizonManager::resolveHandles(const AMA &model) const {
+  const DAM dam = boost::static_pointer_cast<
+      crocoddyl::DifferentialActionModelContactFwdDynamics>(
+      boost::static_pointer_cast<crocoddyl::IntegratedActionModelEuler>(model)
+          ->get_differential());
+  const crocoddyl::CostModelSum::CostModelContainer &costs =
+      dam->get_costs()->get_costs();
+
+  NodeHandles h;
+  h.placementLF = findResidual<crocoddyl::ResidualModelFramePlacement>(
+      costs, settings_.placementLFName);
+  h.placementRF = findResidual<crocoddyl::ResidualModelFramePlacement>(
+      costs, settings_.placementRFName);
+  h.comVelocity =
+      findResidual<ResidualModelCoMVelocity>(costs, settings_.comVelocityName);
+  h.actuation = findResidual<crocoddyl::ResidualModelControl>(
+      costs, settings_.actuationName);
+  h.wrenchConeLF = findResidual<crocoddyl::ResidualModelContactWrenchCone>(
+      costs, settings_.wrenchLFName);
+  h.wrenchConeRF = findResidual<crocoddyl::ResidualModelContactWrenchCone>(
+      costs, settings_.wrenchRFName);
+  h.wrenchActivationLF =
+      findActivation<ActivationModelQuadRef>(costs, settings_.wrenchLFName);
+  h.wrenchActivationRF =
+      findActivation<ActivationModelQuadRef>(costs, settings_.wrenchRFName);
+  h.contacts = dam->get_contacts();
+  if (h.wrenchConeLF)
+    h.wrenchReferenceLF.setZero(h.wrenchConeLF->get_reference().get_A().rows());
+  if (h.wrenchConeRF)
+    h.wrenchReferenceRF.setZero(h.wrenchConeRF->get_reference().get_A().rows());
+  return h;
+}
+
 // OLD
 AMA HorizonManager::ama(const unsigned long &time) {
   return ddp_->get_problem()->get_runningModels()[time];
@@ -108,6 +252,12 @@ void HorizonManager::setBalancingTorque(const unsigned long &time,
   setBalancingTorque(time, nameCostActuation, x);
 }
 
+void HorizonManager::setCostWeight(const unsigned long &time,
+                                   const std::string &nameCost,
+                                   const double weight) {
+  sobec::setCostWeight(*costs(time), nameCost, weight);
+}
+
 void HorizonManager::setActuationReference(const unsigned long &time,
                                            const std::string &nameCostActuation,
                                            const Eigen::VectorXd &reference) {
@@ -119,9 +269,9 @@ void HorizonManager::setActuationReference(const unsigned long &time,
 void HorizonManager::setPoseReferenceLF(const unsigned long &time,
                                         const std::string &nameCostLF,
                                         const pinocchio::SE3 &ref_placement) {
-  std::cout << "Set left position to " << ref_placement.translation()[0] << ", "
-            << ref_placement.translation()[1] << ", "
-            << ref_placement.translation()[2] << std::endl;
+  SOBEC_TRACE_DEBUG("Set left position", time, ref_placement.translation()[0],
+                    ref_placement.translation()[1],
+                    ref_placement.translation()[2]);
   boost::static_pointer_cast<crocoddyl::ResidualModelFramePlacement>(
       costs(time)->get_costs().at(nameCostLF)->cost->get_residual())
       ->set_reference(ref_placement);
@@ -130,9 +280,10 @@ void HorizonManager::setPoseReferenceLF(const unsigned long &time,
 void HorizonManager::setPoseReferenceRF(const unsigned long &time,
                                         const std::string &nameCostRF,
                                         const pinocchio::SE3 &ref_placement) {
-  std::cout << "Set right position to " << ref_placement.translation()[0]
-            << ", " << ref_placement.translation()[1] << ", "
-            << ref_placement.translation()[2] << std::endl;
+  SOBEC_TRACE_DEBUG("Set right position", time,
+                    ref_placement.translation()[0],
+                    ref_placement.translation()[1],
+                    ref_placement.translation()[2]);
   boost::static_pointer_cast<crocoddyl::ResidualModelFramePlacement>(
       costs(time)->get_costs().at(nameCostRF)->cost->get_residual())
       ->set_reference(ref_placement);
@@ -149,33 +300,118 @@ void HorizonManager::setVelocityRefCOM(const unsigned long &time,
 void HorizonManager::setForceReferenceLF(const unsigned long &time,
                                          const std::string &nameCostLF,
                                          const eVector6 &reference) {
-  std::cout << "Set left ref Fz ref to " << reference[2] << std::endl;
-  cone_ = boost::static_pointer_cast<crocoddyl::CostModelResidual>(
-      costs(time)->get_costs().at(nameCostLF)->cost);
-  new_ref_ =
+  SOBEC_TRACE_DEBUG("Set left ref Fz", time, reference[2]);
+  // Locals only: the setters may be called for different nodes in parallel.
+  boost::shared_ptr<crocoddyl::CostModelResidual> cone =
+      boost::static_pointer_cast<crocoddyl::CostModelResidual>(
+          costs(time)->get_costs().at(nameCostLF)->cost);
+  const Eigen::VectorXd new_ref =
       boost::static_pointer_cast<crocoddyl::ResidualModelContactWrenchCone>(
-          cone_->get_residual())
+          cone->get_residual())
           ->get_reference()
           .get_A() *
       reference;
-  boost::static_pointer_cast<ActivationModelQuadRef>(cone_->get_activation())
-      ->set_reference(new_ref_);
+  boost::static_pointer_cast<ActivationModelQuadRef>(cone->get_activation())
+      ->set_reference(new_ref);
 }
 
 void HorizonManager::setForceReferenceRF(const unsigned long &time,
                                          const std::string &nameCostRF,
                                          const eVector6 &reference) {
-  std::cout << "Set right ref Fz to " << reference[2] << std::endl;
-  cone_ = boost::static_pointer_cast<crocoddyl::CostModelResidual>(
-      costs(time)->get_costs().at(nameCostRF)->cost);
-  new_ref_ =
+  SOBEC_TRACE_DEBUG("Set right ref Fz", time, reference[2]);
+  // Locals only: the setters may be called for different nodes in parallel.
+  boost::shared_ptr<crocoddyl::CostModelResidual> cone =
+      boost::static_pointer_cast<crocoddyl::CostModelResidual>(
+          costs(time)->get_costs().at(nameCostRF)->cost);
+  const Eigen::VectorXd new_ref =
       boost::static_pointer_cast<crocoddyl::ResidualModelContactWrenchCone>(
-          cone_->get_residual())
+          cone->get_residual())
           ->get_reference()
           .get_A() *
       reference;
-  boost::static_pointer_cast<ActivationModelQuadRef>(cone_->get_activation())
-      ->set_reference(new_ref_);
+  boost::static_pointer_cast<ActivationModelQuadRef>(cone->get_activation())
+      ->set_reference(new_ref);
+}
+
+void HorizonManager::setActuationReference(const unsigned long &time,
+                                           const Eigen::VectorXd &reference) {
+  checkHandle(handles(time).actuation, settings_.actuationName)
+      ->set_reference(reference);
+}
+
+void HorizonManager::setPoseReferenceLF(const unsigned long &time,
+                                        const pinocchio::SE3 &ref_placement) {
+  checkHandle(handles(time).placementLF, settings_.placementLFName)
+      ->set_reference(ref_placement);
+}
+
+void HorizonManager::setPoseReferenceRF(const unsigned long &time,
+                                        const pinocchio::SE3 &ref_placement) {
+  checkHandle(handles(time).placementRF, settings_.placementRFName)
+      ->set_reference(ref_placement);
+}
+
+void HorizonManager::setVelocityRefCOM(const unsigned long &time,
+                                       const eVector3 &ref_velocity) {
+  checkHandle(handles(time).comVelocity, settings_.comVelocityName)
+      ->set_reference(ref_velocity);
+}
+
+void HorizonManager::setForceReferenceLF(const unsigned long &time,
+                                         const eVector6 &reference) {
+  setForceReference(nodeHandles(time), reference, &NodeHandles::wrenchConeLF,
+                    &NodeHandles::wrenchActivationLF,
+                    &NodeHandles::wrenchReferenceLF, settings_.wrenchLFName);
+}
+
+void HorizonManager::setForceReferenceRF(const unsigned long &time,
+                                         const eVector6 &reference) {
+  setForceReference(nodeHandles(time), reference, &NodeHandles::wrenchConeRF,
+                    &NodeHandles::wrenchActivationRF,
+                    &NodeHandles::wrenchReferenceRF, settings_.wrenchRFName);
+}
+
+void HorizonManager::setPoseReferencesLF(
+    const Eigen::Ref<const HorizonPoses> &poses) {
+  checkRows(poses.rows(), size());
+  setPoseReferences(poses, nodes_->handles, nodes_->head,
+                    &NodeHandles::placementLF,
+                    settings_.placementLFName);
+}
+
+void HorizonManager::setPoseReferencesRF(
+    const Eigen::Ref<const HorizonPoses> &poses) {
+  checkRows(poses.rows(), size());
+  setPoseReferences(poses, nodes_->handles, nodes_->head,
+                    &NodeHandles::placementRF,
+                    settings_.placementRFName);
+}
+
+void HorizonManager::setVelocityRefsCOM(
+    const Eigen::Ref<const HorizonVectors3> &velocities) {
+  checkRows(velocities.rows(), size());
+  for (Eigen::Index t = 0; t < velocities.rows(); ++t) {
+    checkHandle(handles(t).comVelocity, settings_.comVelocityName)
+        ->set_reference(velocities.row(t).transpose());
+  }
+}
+
+void HorizonManager::setForceReferencesLF(
+    const Eigen::Ref<const HorizonWrenches> &wrenches) {
+  checkRows(wrenches.rows(), size());
+  setForceReferences(wrenches, nodes_->handles, nodes_->head,
+                     &NodeHandles::wrenchConeLF,
+                     &NodeHandles::wrenchActivationLF,
+                     &NodeHandles::wrenchReferenceLF, settings_.wrenchLFName);
+}
+
+void HorizonManager::setForceReferencesRF(
+    const Eigen::Ref<const HorizonWrenches> &wrenches) {
+  checkRows(wrenches.rows(), size());
+  setForceReferences(wrenches, nodes_->handles, nodes_->head,
+                     &NodeHandles::wrenchConeRF,
+                     &NodeHandles::wrenchActivationRF,
+                     &NodeHandles::wrenchReferenceRF, settings_.wrenchRFName);
 }
 
 void HorizonManager::setSwingingLF(const unsigned long &time,
@@ -204,15 +440,74 @@ void HorizonManager::setDoubleSupport(const unsigned long &time,
 }
 
 void HorizonManager::recede(const AMA &new_model, const ADA &new_data) {
-  ddp_->get_problem()->circularAppend(new_model, new_data);
+  recede(new_model, new_data, modelHandles(new_model));
+}
+
+void HorizonManager::recede(const AMA &new_model, const ADA &new_data,
+                            const NodeHandles &new_handles) {
+  append(new_model, new_data, new_handles);
+}
+
+void HorizonManager::recede(const AMA &new_model,
+                            const NodeHandles &new_handles) {
+  // The leaving data goes back first, so that it can be reused at once.
+  releaseData(ama(0), ada(0));
+  append(new_model, acquireData(new_model), new_handles);
 }
 
 void HorizonManager::recede(const AMA &new_model) {
-  ddp_->get_problem()->circularAppend(new_model, new_model->createData());
+  recede(new_model, modelHandles(new_model));
+}
+
+void HorizonManager::append(const AMA &new_model, const ADA &new_data,
+                            const NodeHandles &new_handles) {
+  ddp_->get_problem()->circularAppend(new_model, new_data);
+  // The first node leaves the ring, its slot becomes the last node. The nodes
+  // have the same wrench cones, so the copy of the buffers does not allocate.
+  nodes_->handles[nodes_->head] = new_handles;
+  nodes_->head = (nodes_->head + 1) % nodes_->handles.size();
+}
+
+void HorizonManager::reserveData(const std::vector<AMA> &models) {
+  for (const AMA &model : models) {
+    std::vector<ADA> &datas = nodes_->dataPool[model];
+    datas.push_back(model->createData());
+    // Room for all the datas of the model, including those in the horizon
+    // which come back to the pool when they leave it.
+    std::size_t inHorizon = 0;
+    for (unsigned long time = 0; time < size(); time++)
+      if (ama(time) == model) inHorizon++;
+    datas.reserve(datas.size() + inHorizon);
+  }
+}
+
+ADA HorizonManager::acquireData(const AMA &model) {
+  std::map<AMA, std::vector<ADA> >::iterator it =
+      nodes_->dataPool.find(model);
+  if (it == nodes_->dataPool.end()) {
+    // The model was not given to reserveData: it is pooled from now on, so
+    // that the recedes allocate (and fail the CHECK_RUNTIME_MALLOC check of
+    // the WBC) until its datas come back from the horizon.
+    SOBEC_TRACE_WARNING("HorizonManager: pooling a model not given to "
+                        "reserveData");
+    nodes_->dataPool[model];
+    return model->createData();
+  }
+  if (it->second.empty()) return model->createData();
+  const ADA data = it->second.back();
+  it->second.pop_back();
+  return data;
+}
+
+void HorizonManager::releaseData(const AMA &model, const ADA &data) {
+  std::map<AMA, std::vector<ADA> >::iterator it =
+      nodes_->dataPool.find(model);
+  if (it != nodes_->dataPool.end()) it->second.push_back(data);
 }
 
 void HorizonManager::recede() {
   ddp_->get_problem()->circularAppend(ama(0), ada(0));
+  nodes_->head = (nodes_->head + 1) % nodes_->handles.size();
 }
 
 unsigned long HorizonManager::size() { return ddp_->get_problem()->get_T(); }
@@ -220,18 +515,27 @@ unsigned long HorizonManager::size() { return ddp_->get_problem()->get_T(); }
 void HorizonManager::solve(const Eigen::VectorXd &measured_x,
                            const std::size_t &ddpIteration,
                            const bool &is_feasible) {
-  warm_xs_ = ddp_->get_xs();
-  warm_xs_.erase(warm_xs_.begin());
+  const std::vector<Eigen::VectorXd> &xs = ddp_->get_xs();
+  const std::vector<Eigen::VectorXd> &us = ddp_->get_us();
+  const unsigned long T = size();
+
+  // Node t starts from node t + 1 of the previous solution, the last node
+  // being repeated. The vectors keep their size, so the copies do not
+  // allocate once the buffers are sized.
+  warm_xs_.resize(T + 1);
+  warm_us_.resize(T);
+  for (unsigned long t = 1; t <= T; t++)
+    warm_xs_[t] = xs[std::min<std::size_t>(t + 1, xs.size() - 1)];
   warm_xs_[0] = measured_x;
-  warm_xs_.push_back(warm_xs_[warm_xs_.size() - 1]);
-
-  warm_us_ = ddp_->get_us();
-  warm_us_.erase(warm_us_.begin());
-  warm_us_.push_back(warm_us_[warm_us_.size() - 1]);
+  for (unsigned long t = 0; t < T; t++)
+    warm_us_[t] = us[std::min<std::size_t>(t + 1, us.size() - 1)];
 
   // Update initial state
   ddp_->get_problem()->set_x0(measured_x);
-  ddp_->allocateData();
+  if (allocated_size_ != T) {
+    ddp_->allocateData();
+    allocated_size_ = T;
+  }
 
   ddp_->solve(warm_xs_, warm_us_, ddpIteration, is_feasible);
 }
@@ -1,8 +1,15 @@
 #include "sobec/model_factory.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <crocoddyl/multibody/fwd.hpp>
+#include <exception>
+#include <mutex>
+#include <thread>
 
+#include "sobec/cost-stack.hpp"
 #include "sobec/designer.hpp"
+#include "sobec/trace.hpp"
 
 namespace sobec {
 
@@ -25,10 +32,80 @@ void ModelMaker::initialize(const ModelMakerSettings &settings,
 
   x0_.resize(designer_.get_rModel().nq + designer_.get_rModel().nv);
   x0_ << designer_.get_q0(), Eigen::VectorXd::Zero(designer_.get_rModel().nv);
+  prototype_.reset();
 
   initialized_ = true;
 }
 
+void ModelMaker::updatePrototype() {
+  boost::shared_ptr<NodePrototype> prototype =
+      boost::make_shared<NodePrototype>();
+
+  // Wrench cones
+  const double Mg = -designer_.getRobotMass() * settings_.gravity(2);
+  const crocoddyl::WrenchCone wrenchCone_LF(
+      designer_.get_LF_frame().rotation().transpose(), settings_.mu,
+      settings_.coneBox, 4, true, settings_.minNforce, settings_.maxNforce);
+  const crocoddyl::WrenchCone wrenchCone_RF(
+      designer_.get_RF_frame().rotation().transpose(), settings_.mu,
+      settings_.coneBox, 4, true, settings_.minNforce, settings_.maxNforce);
+  prototype->residual_LF_Wrench =
+      boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
+          state_, designer_.get_LF_id(), wrenchCone_LF, actuation_->get_nu());
+  prototype->residual_RF_Wrench =
+      boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
+          state_, designer_.get_RF_id(), wrenchCone_RF, actuation_->get_nu());
+  for (const Support support : {LEFT, RIGHT, DOUBLE}) {
+    const double Fz_ref = support == Support::DOUBLE ? Mg / 2 : Mg;
+    eVector6 refWrench_LF = eVector6::Zero();
+    eVector6 refWrench_RF = eVector6::Zero();
+    if (support == Support::LEFT || support == Support::DOUBLE)
+      refWrench_LF(2) = Fz_ref;
+    if (support == Support::RIGHT || support == Support::DOUBLE)
+      refWrench_RF(2) = Fz_ref;
+    prototype->refCost_LF[support] = wrenchCone_LF.get_A() * refWrench_LF;
+    prototype->refCost_RF[support] = wrenchCone_RF.get_A() * refWrench_RF;
+  }
+  SOBEC_TRACE_INFO("Fz ref", Mg / 2, Mg);
+
+  prototype->activationTracking =
+      boost::make_shared<crocoddyl::ActivationModelQuadFlatLog>(6, 0.01);
+  prototype->activationPosture =
+      boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+          settings_.stateWeights);
+  prototype->activationActuation =
+      boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+          settings_.controlWeights);
+
+  // Joint limits
+  Eigen::VectorXd lower_bound(2 * state_->get_nv()),
+      upper_bound(2 * state_->get_nv());
+  double inf = 9999.0;
+  lower_bound << Eigen::VectorXd::Constant(6, -inf),
+      designer_.get_rModel().lowerPositionLimit.tail(state_->get_nq() - 7),
+      Eigen::VectorXd::Constant(state_->get_nv(), -inf);
+
+  upper_bound << Eigen::VectorXd::Constant(6, inf),
+      designer_.get_rModel().upperPositionLimit.tail(state_->get_nq() - 7),
+      Eigen::VectorXd::Constant(state_->get_nv(), inf);
+
+  crocoddyl::ActivationBounds bounds =
+      crocoddyl::ActivationBounds(lower_bound, upper_bound, 1.);
+
+  prototype->jointLimits = boost::make_shared<crocoddyl::CostModelResidual>(
+      state_,
+      boost::make_shared<crocoddyl::ActivationModelQuadraticBarrier>(bounds),
+      boost::make_shared<crocoddyl::ResidualModelState>(state_,
+                                                        actuation_->get_nu()));
+
+  prototype_ = prototype;
+}
+
+const NodePrototype &ModelMaker::prototype() {
+  if (!prototype_) updatePrototype();
+  return *prototype_;
+}
+
 void ModelMaker::defineFeetContact(Contact &contactCollector,
                                    const Support &support) {
   boost::shared_ptr<crocoddyl::ContactModelAbstract> ContactModelLeft =
@@ -55,56 +132,19 @@ void ModelMaker::defineFeetContact(Contact &contactCollector,
 
 void ModelMaker::defineFeetWrenchCost(Cost &costCollector,
                                       const Support &support) {
-  double Mg = -designer_.getRobotMass() * settings_.gravity(2);
-  double Fz_ref;
-  support == Support::DOUBLE ? Fz_ref = Mg / 2 : Fz_ref = Mg;
-
-  std::cout << "Fz ref " << Fz_ref << std::endl;
-
-  Eigen::Matrix3d coneRotationLeft =
-      designer_.get_LF_frame().rotation().transpose();
-  Eigen::Matrix3d coneRotationRight =
-      designer_.get_RF_frame().rotation().transpose();
-
-  crocoddyl::WrenchCone wrenchCone_LF =
-      crocoddyl::WrenchCone(coneRotationLeft, settings_.mu, settings_.coneBox,
-                            4, true, settings_.minNforce, settings_.maxNforce);
-  crocoddyl::WrenchCone wrenchCone_RF =
-      crocoddyl::WrenchCone(coneRotationRight, settings_.mu, settings_.coneBox,
-                            4, true, settings_.minNforce, settings_.maxNforce);
-
-  eVector6 refWrench_LF = eVector6::Zero();
-  eVector6 refWrench_RF = eVector6::Zero();
-  if (support == Support::LEFT || support == Support::DOUBLE)
-    refWrench_LF(2) = Fz_ref;
-  if (support == Support::RIGHT || support == Support::DOUBLE)
-    refWrench_RF(2) = Fz_ref;
-
-  Eigen::VectorXd refCost_LF = wrenchCone_LF.get_A() * refWrench_LF;
-  Eigen::VectorXd refCost_RF = wrenchCone_LF.get_A() * refWrench_RF;
-
-  boost::shared_ptr<ActivationModelQuadRef> activation_LF_Wrench =
-      boost::make_shared<ActivationModelQuadRef>(refCost_LF);
-  boost::shared_ptr<ActivationModelQuadRef> activation_RF_Wrench =
-      boost::make_shared<ActivationModelQuadRef>(refCost_RF);
+  const NodePrototype &p = prototype();
 
-  boost::shared_ptr<crocoddyl::ResidualModelContactWrenchCone>
-      residual_LF_Wrench =
-          boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
-              state_, designer_.get_LF_id(), wrenchCone_LF,
-              actuation_->get_nu());
+  // The activations hold the force references of the node.
   boost::shared_ptr<crocoddyl::CostModelAbstract> wrenchModel_LF =
       boost::make_shared<crocoddyl::CostModelResidual>(
-          state_, activation_LF_Wrench, residual_LF_Wrench);
-
-  boost::shared_ptr<crocoddyl::ResidualModelContactWrenchCone>
-      residual_RF_Wrench =
-          boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
-              state_, designer_.get_RF_id(), wrenchCone_RF,
-              actuation_->get_nu());
+          state_,
+          boost::make_shared<ActivationModelQuadRef>(p.refCost_LF[support]),
+          p.residual_LF_Wrench);
   boost::shared_ptr<crocoddyl::CostModelAbstract> wrenchModel_RF =
       boost::make_shared<crocoddyl::CostModelResidual>(
-          state_, activation_RF_Wrench, residual_RF_Wrench);
+          state_,
+          boost::make_shared<ActivationModelQuadRef>(p.refCost_RF[support]),
+          p.residual_RF_Wrench);
 
   costCollector.get()->addCost("wrench_LF", wrenchModel_LF,
                                settings_.wWrenchCone, true);
@@ -113,8 +153,8 @@ void ModelMaker::defineFeetWrenchCost(Cost &costCollector,
 }
 
 void ModelMaker::defineFeetTracking(Cost &costCollector) {
-  boost::shared_ptr<crocoddyl::ActivationModelQuadFlatLog> activationQF =
-      boost::make_shared<crocoddyl::ActivationModelQuadFlatLog>(6, 0.01);
+  const boost::shared_ptr<crocoddyl::ActivationModelQuadFlatLog>
+      &activationQF = prototype().activationTracking;
 
   boost::shared_ptr<crocoddyl::ResidualModelFramePlacement>
       residual_LF_Tracking =
@@ -145,9 +185,8 @@ void ModelMaker::definePostureTask(Cost &costCollector) {
   if (settings_.stateWeights.size() != designer_.get_rModel().nv * 2) {
     throw std::invalid_argument("State weight size is wrong ");
   }
-  boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad> activationWQ =
-      boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
-          settings_.stateWeights);
+  const boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad>
+      &activationWQ = prototype().activationPosture;
 
   boost::shared_ptr<crocoddyl::CostModelAbstract> postureModel =
       boost::make_shared<crocoddyl::CostModelResidual>(
@@ -163,9 +202,8 @@ void ModelMaker::defineActuationTask(Cost &costCollector) {
   if (settings_.controlWeights.size() != (int)actuation_->get_nu()) {
     throw std::invalid_argument("Control weight size is wrong ");
   }
-  boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad> activationWQ =
-      boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
-          settings_.controlWeights);  //.tail(actuation->get_nu())
+  const boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad>
+      &activationWQ = prototype().activationActuation;
 
   boost::shared_ptr<crocoddyl::CostModelAbstract> actuationModel =
       boost::make_shared<crocoddyl::CostModelResidual>(
@@ -177,30 +215,8 @@ void ModelMaker::defineActuationTask(Cost &costCollector) {
 }
 
 void ModelMaker::defineJointLimits(Cost &costCollector) {
-  Eigen::VectorXd lower_bound(2 * state_->get_nv()),
-      upper_bound(2 * state_->get_nv());
-  double inf = 9999.0;
-  lower_bound << Eigen::VectorXd::Constant(6, -inf),
-      designer_.get_rModel().lowerPositionLimit.tail(state_->get_nq() - 7),
-      Eigen::VectorXd::Constant(state_->get_nv(), -inf);
-
-  upper_bound << Eigen::VectorXd::Constant(6, inf),
-      designer_.get_rModel().upperPositionLimit.tail(state_->get_nq() - 7),
-      Eigen::VectorXd::Constant(state_->get_nv(), inf);
-
-  crocoddyl::ActivationBounds bounds =
-      crocoddyl::ActivationBounds(lower_bound, upper_bound, 1.);
-
-  boost::shared_ptr<crocoddyl::ActivationModelQuadraticBarrier> activationQB =
-      boost::make_shared<crocoddyl::ActivationModelQuadraticBarrier>(bounds);
-  boost::shared_ptr<crocoddyl::CostModelAbstract> jointLimitCost =
-      boost::make_shared<crocoddyl::CostModelResidual>(
-          state_, activationQB,
-          boost::make_shared<crocoddyl::ResidualModelState>(
-              state_, actuation_->get_nu()));
-
-  costCollector.get()->addCost("jointLimits", jointLimitCost, settings_.wLimit,
-                               true);
+  costCollector.get()->addCost("jointLimits", prototype().jointLimits,
+                               settings_.wLimit, true);
 }
 
 void ModelMaker::defineCoMVelocity(Cost &costCollector) {
@@ -215,6 +231,13 @@ void ModelMaker::defineCoMVelocity(Cost &costCollector) {
 }
 
 AMA ModelMaker::formulateStepTracker(const Support &support) {
+  updatePrototype();
+  costStackReports_.assign(1, CostStackReport());
+  return formulateStepTrackerNode(support, costStackReports_[0]);
+}
+
+AMA ModelMaker::formulateStepTrackerNode(const Support &support,
+                                         CostStackReport &report) {
   Contact contacts = boost::make_shared<crocoddyl::ContactModelMultiple>(
       state_, actuation_->get_nu());
   Cost costs =
@@ -229,6 +252,9 @@ AMA ModelMaker::formulateStepTracker(const Support &support) {
   defineFeetWrenchCost(costs, support);
   defineFeetTracking(costs);
 
+  // The zero-weight costs are deactivated, setCostWeight reactivates them.
+  report = compileCostStack(*costs);
+
   DAM runningDAM =
       boost::make_shared<crocoddyl::DifferentialActionModelContactFwdDynamics>(
           state_, actuation_, contacts, costs, 0., true);
@@ -240,12 +266,46 @@ AMA ModelMaker::formulateStepTracker(const Support &support) {
 
 std::vector<AMA> ModelMaker::formulateHorizon(
     const std::vector<Support> &supports) {
-  // for loop to generate a vector of IAMs
-  std::vector<AMA> models;
-  for (std::size_t i = 0; i < supports.size(); i++) {
-    models.push_back(formulateStepTracker(supports[i]));
+  std::vector<AMA> models(supports.size());
+  // Shared by all the nodes of the horizon.
+  updatePrototype();
+  costStackReports_.assign(supports.size(), CostStackReport());
+  std::size_t nthreads =
+      settings_.nthreads > 0
+          ? static_cast<std::size_t>(settings_.nthreads)
+          : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  nthreads = std::min(nthreads, supports.size());
+  if (nthreads <= 1) {
+    for (std::size_t i = 0; i < supports.size(); i++) {
+      models[i] = formulateStepTrackerNode(supports[i], costStackReports_[i]);
+    }
+    return models;
   }
 
+  // The workers take the next node to build, and store it and its cost stack
+  // report at its index. The formulation only reads the designer, state,
+  // actuation and prototype, which are shared by all the nodes.
+  std::atomic<std::size_t> next(0);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto work = [&]() {
+    for (std::size_t i = next++; i < supports.size(); i = next++) {
+      try {
+        models[i] = formulateStepTrackerNode(supports[i], costStackReports_[i]);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = std::current_exception();
+        next = supports.size();
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(nthreads - 1);
+  for (std::size_t t = 1; t < nthreads; t++) workers.emplace_back(work);
+  work();
+  for (std::thread &worker : workers) worker.join();
+  if (error) std::rethrow_exception(error);
+
   return models;
 }
 
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <crocoddyl/core/utils/exception.hpp>
+
+#include "sobec/mpc-walk-async.hpp"
+#include "sobec/trace.hpp"
+
+namespace sobec {
+
+MPCWalkAsync::MPCWalkAsync(boost::shared_ptr<MPCWalk> mpc)
+    : mpc(mpc), running_(false), posted_(0), consumed_(0) {
+  resetStatistics();
+}
+
+MPCWalkAsync::~MPCWalkAsync() { stop(); }
+
+void MPCWalkAsync::start() {
+  if (running_.load()) return;
+  if (!mpc->solver) {
+    throw_pretty("Invalid argument: "
+                 << "MPCWalk::initialize must be called before starting");
+  }
+
+  // Preallocate both slots of the buffers, so that no allocation happens
+  // when filling or copying them.
+  Request request;
+  request.x = mpc->problem->get_x0();
+  request.t = 0;
+  request.id = 0;
+  requests_.initialize(request);
+
+  MPCWalkPolicySnapshot policy;
+  policy.xs0 = mpc->solver->get_xs()[0];
+  policy.us0 = mpc->solver->get_us()[0];
+  policy.K0 = mpc->solver->get_K()[0];
+  policy.t = 0;
+  policy.solveDuration = 0.;
+  policies_.initialize(policy);
+
+  posted_.store(0);
+  consumed_.store(0);
+  running_.store(true);
+  worker_ = std::thread(&MPCWalkAsync::run, this);
+}
+
+void MPCWalkAsync::stop() {
+  running_.store(false);
+  wakeup_.notify_one();
+  if (worker_.joinable()) worker_.join();
+}
+
+void MPCWalkAsync::setState(const Eigen::Ref<const Eigen::VectorXd>& x,
+                            const int t) {
+  const std::size_t id = posted_.load(std::memory_order_relaxed) + 1;
+  // The previous request was never taken by the worker.
+  if (consumed_.load(std::memory_order_acquire) + 1 < id) ++missed_;
+
+  Request& request = requests_.beginWrite();
+  request.x = x;
+  request.t = t;
+  request.id = id;
+  request.timestamp = Clock::now();
+  requests_.publish();
+
+  posted_.store(id, std::memory_order_release);
+  wakeup_.notify_one();
+}
+
+bool MPCWalkAsync::getPolicy(MPCWalkPolicySnapshot& policy) {
+  if (!policies_.read(policy)) return false;
+
+  lastAge_ =
+      std::chrono::duration<double>(Clock::now() - policy.timestamp).count();
+  sumAge_ += lastAge_;
+  if (lastAge_ > maxAge_) maxAge_ = lastAge_;
+  ++reads_;
+  return true;
+}
+
+MPCWalkAsyncStatistics MPCWalkAsync::get_statistics() const {
+  MPCWalkAsyncStatistics stats;
+  stats.requests = posted_.load();
+  stats.solves = solves_.load();
+  stats.missed = missed_.load();
+  stats.failed = failed_.load();
+  stats.lastAge = lastAge_;
+  stats.meanAge = reads_ > 0 ? sumAge_ / static_cast<double>(reads_) : 0.;
+  stats.maxAge = maxAge_;
+  return stats;
+}
+
+void MPCWalkAsync::resetStatistics() {
+  solves_.store(0);
+  missed_.store(0);
+  failed_.store(0);
+  reads_ = 0;
+  lastAge_ = 0.;
+  sumAge_ = 0.;
+  maxAge_ = 0.;
+}
+
+void MPCWalkAsync::run() {
+  Request request;
+  request.x = mpc->problem->get_x0();
+
+  while (running_.load()) {
+    if (posted_.load(std::memory_order_acquire) ==
+            consumed_.load(std::memory_order_relaxed) ||
+        !requests_.read(request)) {
+      // setState does not take the lock, so a notification may be lost:
+      // the timeout bounds the latency in that case.
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeup_.wait_for(lock, std::chrono::milliseconds(1));
+      continue;
+    }
+    consumed_.store(request.id, std::memory_order_release);
+
+    const Clock::time_point start = Clock::now();
+    try {
+      mpc->calc(request.x, request.t);
+    } catch (const std::exception& e) {
+      SOBEC_TRACE_WARNING("MPCWalkAsync: solve failed at tick",
+                          trace::Label(e.what()), request.t);
+      ++failed_;
+      continue;
+    }
+
+    MPCWalkPolicySnapshot& policy = policies_.beginWrite();
+    policy.xs0 = mpc->solver->get_xs()[0];
+    policy.us0 = mpc->solver->get_us()[0];
+    policy.K0 = mpc->solver->get_K()[0];
+    policy.t = request.t;
+    policy.timestamp = request.timestamp;
+    policy.solveDuration =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    policies_.publish();
+    ++solves_;
+  }
+}
+
+}  // namespace sobec
@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <crocoddyl/core/costs/cost-sum.hpp>
+#include <crocoddyl/core/costs/residual.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <crocoddyl/core/utils/exception.hpp>
+#include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
+#include <crocoddyl/multibody/residuals/state.hpp>
+#include <crocoddyl/multibody/states/multibody.hpp>
+#include <typeinfo>
+
+#include "sobec/mpc-walk.hpp"
+
+namespace sobec {
+using namespace crocoddyl;
+
+namespace {
+// True if a data created by the node a can evaluate the node b: the contact
+// and cost datas are looked up by name, and the residual datas point to the
+// contact datas of their node, so both nodes must have the same contacts and
+// costs of the same types.
+bool sameDataLayout(const ActionModelAbstract& a,
+                    const ActionModelAbstract& b) {
+  if (&a == &b) return true;
+  const IntegratedActionModelEuler* ia =
+      dynamic_cast<const IntegratedActionModelEuler*>(&a);
+  const IntegratedActionModelEuler* ib =
+      dynamic_cast<const IntegratedActionModelEuler*>(&b);
+  if (!ia || !ib) return false;
+  const DifferentialActionModelContactFwdDynamics* da =
+      dynamic_cast<const DifferentialActionModelContactFwdDynamics*>(
+          ia->get_differential().get());
+  const DifferentialActionModelContactFwdDynamics* db =
+      dynamic_cast<const DifferentialActionModelContactFwdDynamics*>(
+          ib->get_differential().get());
+  if (!da || !db || da->get_state() != db->get_state() ||
+      da->get_nu() != db->get_nu()) {
+    return false;
+  }
+
+  const ContactModelMultiple::ContactModelContainer& ca =
+      da->get_contacts()->get_contacts();
+  const ContactModelMultiple::ContactModelContainer& cb =
+      db->get_contacts()->get_contacts();
+  if (ca.size() != cb.size()) return false;
+  for (ContactModelMultiple::ContactModelContainer::const_iterator
+           ita = ca.begin(),
+           itb = cb.begin();
+       ita != ca.end(); ++ita, ++itb) {
+    const ContactModelAbstract& contact_a = *ita->second->contact;
+    const ContactModelAbstract& contact_b = *itb->second->contact;
+    if (ita->first != itb->first || typeid(contact_a) != typeid(contact_b) ||
+        contact_a.get_nc() != contact_b.get_nc()) {
+      return false;
+    }
+  }
+
+  const CostModelSum::CostModelContainer& costs_a =
+      da->get_costs()->get_costs();
+  const CostModelSum::CostModelContainer& costs_b =
+      db->get_costs()->get_costs();
+  if (costs_a.size() != costs_b.size()) return false;
+  for (CostModelSum::CostModelContainer::const_iterator
+           ita = costs_a.begin(),
+           itb = costs_b.begin();
+       ita != costs_a.end(); ++ita, ++itb) {
+    const CostModelAbstract& cost_a = *ita->second->cost;
+    const CostModelAbstract& cost_b = *itb->second->cost;
+    if (ita->first != itb->first || typeid(cost_a) != typeid(cost_b) ||
+        typeid(*cost_a.get_residual()) != typeid(*cost_b.get_residual()) ||
+        typeid(*cost_a.get_activation()) !=
+            typeid(*cost_b.get_activation()) ||
+        cost_a.get_activation()->get_nr() !=
+            cost_b.get_activation()->get_nr()) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+MPCWalk::MPCWalk(boost::shared_ptr<ShootingProblem> problem)
+    : vcomRef(3),
+      Tfine(0),
+      coarseStride(1),
+      solver_th_stop(1e-9),
+      solver_deadline(0.),
+      nthreads(0),
+      compactStorage(false),
+      policySubsteps(10),
+      stateRegCostName("stateReg")
+
+      ,
+      storage(problem),
+      deadlineHit(false),
+      iterations(0) {
+  // std::cout << "Constructor" << std::endl;
+}
+
+void MPCWalk::initialize(const std::vector<Eigen::VectorXd>& xs,
+                         const std::vector<Eigen::VectorXd>& us) {
+  assert(Tmpc > 0);
+  assert(coarseStride >= 1);
+  assert(coarseStride == 1 || (Tfine >= 1 && Tfine <= Tmpc));
+  if (compactStorage) {
+    compactStorageNodes();
+  } else {
+    assert(Tstart + Tend + 2 * (Tdouble + Tsingle) <= storage->get_T());
+  }
+  assert(Tmpc <= static_cast<int>(storage->get_T()));
+
+  if (x0.size() == 0) x0 = storage->get_x0();
+
+  nodeOffsets.resize(Tmpc + 1);
+  for (int i = 0; i <= Tmpc; ++i) {
+    nodeOffsets[i] = (coarseStride == 1 || i <= Tfine)
+                         ? i
+                         : Tfine + (i - Tfine) * coarseStride;
+  }
+  if (coarseStride > 1) buildCoarseModels();
+  createStorageDatas();
+
+  // Init shooting problem for mpc solver. The nodes are taken from storage
+  // along with the datas of this MPC, as done by calc() when receding.
+  ActionList runmodels(Tmpc);
+  std::vector<boost::shared_ptr<ActionDataAbstract> > rundatas(Tmpc);
+  for (int i = 0; i < Tmpc; ++i) {
+    if (coarseStride == 1) {
+      runmodels[i] = storage->get_runningModels()[i];
+      rundatas[i] = storageDatas.empty() ? runmodels[i]->createData()
+                                         : storageDatas[i];
+    } else if (i < Tfine) {
+      runmodels[i] = storage->get_runningModels()[scheduledNode(i)];
+      rundatas[i] = storageDatas[scheduledNode(i)];
+    } else {
+      runmodels[i] = coarseModels[scheduledNode(nodeOffsets[i])];
+      rundatas[i] = coarseDatas[scheduledNode(nodeOffsets[i])];
+    }
+  }
+  problem = boost::make_shared<ShootingProblem>(
+      x0, runmodels, storage->get_terminalModel(), rundatas, terminalData);
+  if (nthreads > 0) problem->set_nthreads(nthreads);
+
+  findTerminalStateResidualModel();
+  findStateModel();
+  xref = x0;
+  updateTerminalCost(0);
+
+  // Init solverc
+  profiledSolver = boost::make_shared<SolverFDDPProfiled>(problem, profiler);
+  solver = profiledSolver;
+  solver->set_th_stop(solver_th_stop);
+  solver->set_reg_min(solver_reg_min);
+
+  reg = solver_reg_min;
+
+  // Run first solve. With coarse nodes, a guess given at the resolution of
+  // the storage over the whole horizon is sampled at the start of each node.
+  if (coarseStride > 1 && xs.size() > static_cast<std::size_t>(Tmpc + 1)) {
+    assert(xs.size() > static_cast<std::size_t>(get_horizonTicks()));
+    assert(us.size() >= static_cast<std::size_t>(get_horizonTicks()));
+    xs_guess.resize(Tmpc + 1);
+    us_guess.resize(Tmpc);
+    for (int i = 0; i <= Tmpc; ++i) {
+      xs_guess[i] = xs[nodeOffsets[i]];
+      if (i < Tmpc) us_guess[i] = us[nodeOffsets[i]];
+    }
+    solver->solve(xs_guess, us_guess);
+  } else {
+    solver->solve(xs, us);
+  }
+
+  // Preallocate the warm-start buffers used at every tick by calc().
+  xs_guess = solver->get_xs();
+  us_guess = solver->get_us();
+  dx_guess =
+      VectorXd::Zero(problem->get_terminalModel()->get_state()->get_ndx());
+
+  policy.initialize(problem->get_terminalModel()->get_state(),
+                    us_guess[0].size(), policySubsteps);
+  policy.update(*solver);
+}
+
+int MPCWalk::scheduledNode(const int k) const {
+  if (k <= Tstart) return k;
+  const int Tcycle = 2 * (Tsingle + Tdouble);
+  return Tstart + 1 + ((k - Tstart - 1) % Tcycle);
+}
+
+void MPCWalk::compactStorageNodes() {
+  const int Tcycle = 2 * (Tsingle + Tdouble);
+  const std::size_t nnodes = static_cast<std::size_t>(Tstart + 1 + Tcycle);
+  if (nnodes > storage->get_T()) {
+    throw_pretty("Invalid argument: the storage should contain the start "
+                 "phase and a full gait cycle ("
+                 << nnodes << " nodes)");
+  }
+
+  // The models are shared with the previous storage, which is released with
+  // its datas and the nodes that are never scheduled (unless the caller still
+  // holds it). The MPC evaluates the nodes with its own datas, so the new
+  // storage only gets placeholders: the nodes share one data per type of
+  // data, which must not be used to evaluate them.
+  const ActionList models(storage->get_runningModels().begin(),
+                          storage->get_runningModels().begin() + nnodes);
+  std::vector<boost::shared_ptr<ActionDataAbstract> > datas(nnodes);
+  std::vector<boost::shared_ptr<ActionDataAbstract> > placeholders;
+  for (std::size_t n = 0; n < nnodes; ++n) {
+    for (std::size_t k = 0; k < placeholders.size() && !datas[n]; ++k) {
+      if (models[n]->checkData(placeholders[k])) datas[n] = placeholders[k];
+    }
+    if (!datas[n]) {
+      datas[n] = models[n]->createData();
+      placeholders.push_back(datas[n]);
+    }
+  }
+  storage = boost::make_shared<ShootingProblem>(
+      storage->get_x0(), models, storage->get_terminalModel(), datas,
+      storage->get_terminalData());
+}
+
+void MPCWalk::createStorageDatas() {
+  terminalData = storage->get_terminalModel()->createData();
+  if (compactStorage && coarseStride == 1) {
+    // Only the nodes of the horizon get a data, see recycleData(). The nodes
+    // are sorted by layout of their datas to know which datas are recycled.
+    storageDatas.clear();
+    dataLayouts.clear();
+    ActionList layouts;
+    for (std::size_t n = 0; n < storage->get_T(); ++n) {
+      const ActionPtr& model = storage->get_runningModels()[n];
+      std::size_t k = 0;
+      while (k < layouts.size() && !sameDataLayout(*layouts[k], *model)) ++k;
+      if (k == layouts.size()) layouts.push_back(model);
+      dataLayouts[model.get()] = k;
+    }
+    return;
+  }
+
+  // The datas of the storage problem are left to it, so that several MPCs
+  // can be built on the same storage. Only the nodes used by the first
+  // horizon or returned by scheduledNode get a data.
+  const std::size_t nnodes =
+      std::min(storage->get_T(),
+               static_cast<std::size_t>(std::max(
+                   Tmpc, Tstart + 1 + 2 * (Tsingle + Tdouble))));
+  storageDatas.assign(storage->get_T(),
+                      boost::shared_ptr<ActionDataAbstract>());
+  for (std::size_t n = 0; n < nnodes; ++n)
+    storageDatas[n] = storage->get_runningModels()[n]->createData();
+}
+
+boost::shared_ptr<ActionDataAbstract> MPCWalk::recycleData(
+    const ActionPtr& model) const {
+  // The data of the node leaving the horizon goes to the entering node when
+  // they have the same layout. Otherwise it is released along with the
+  // leaving node, and the entering node gets a new data.
+  const ActionModelAbstract* leaving = problem->get_runningModels()[0].get();
+  if (dataLayouts.at(leaving) == dataLayouts.at(model.get())) {
+    return problem->get_runningDatas()[0];
+  }
+  return model->createData();
+}
+
+void MPCWalk::buildCoarseModels() {
+  // Any node that scheduledNode can return may fall on a coarse node. They
+  // share the differential model of the storage node, hence its references.
+  const std::size_t nnodes = std::min(
+      storage->get_T(),
+      static_cast<std::size_t>(Tstart + 1 + 2 * (Tsingle + Tdouble)));
+  coarseModels.resize(nnodes);
+  coarseDatas.resize(nnodes);
+  for (std::size_t n = 0; n < nnodes; ++n) {
+    boost::shared_ptr<IntegratedActionModelEuler> iam =
+        boost::dynamic_pointer_cast<IntegratedActionModelEuler>(
+            storage->get_runningModels()[n]);
+    if (!iam) {
+      throw_pretty("Invalid argument: "
+                   << "coarse nodes need Euler integrated models");
+    }
+    coarseModels[n] = boost::make_shared<IntegratedActionModelEuler>(
+        iam->get_differential(), iam->get_dt() * coarseStride);
+    coarseDatas[n] = coarseModels[n]->createData();
+  }
+}
+
+void MPCWalk::updateHorizonNodes(const int t) {
+  // Each node moves forward by one storage node: the fine nodes take the
+  // place of the next one, while the coarse nodes get the next coarse model.
+  for (int i = 0; i < Tmpc; ++i) {
+    const int n = scheduledNode(t + 1 + nodeOffsets[i]);
+    const ActionPtr& model =
+        i < Tfine ? storage->get_runningModels()[n] : coarseModels[n];
+    if (problem->get_runningModels()[i] != model) {
+      problem->updateNode(i, model,
+                          i < Tfine ? storageDatas[n] : coarseDatas[n]);
+    }
+  }
+}
+
+void MPCWalk::shiftWarmStart() {
+  // The previous solution is shifted by one storage node into the buffers
+  // allocated by initialize(), so that no memory is allocated while receding.
+  // Node i of the new horizon starts one storage node after node i of the
+  // previous one: for a uniform horizon, this is node i+1.
+  const std::vector<Eigen::VectorXd>& xs_opt = solver->get_xs();
+  const std::vector<Eigen::VectorXd>& us_opt = solver->get_us();
+  const boost::shared_ptr<StateAbstract>& xstate =
+      problem->get_terminalModel()->get_state();
+  int j = 0;
+  for (int i = 0; i <= Tmpc; ++i) {
+    const int start = nodeOffsets[i] + 1;
+    while (j < Tmpc && nodeOffsets[j + 1] <= start) ++j;
+    if (j == Tmpc || nodeOffsets[j] == start) {
+      xs_guess[i] = xs_opt[j];
+    } else {
+      xstate->diff(xs_opt[j], xs_opt[j + 1], dx_guess);
+      dx_guess *= double(start - nodeOffsets[j]) /
+                  double(nodeOffsets[j + 1] - nodeOffsets[j]);
+      xstate->integrate(xs_opt[j], dx_guess, xs_guess[i]);
+    }
+    if (i < Tmpc) us_guess[i] = us_opt[std::min(j, Tmpc - 1)];
+  }
+}
+
+void MPCWalk::findStateModel() {
+  state = boost::dynamic_pointer_cast<StateMultibody>(
+      problem->get_terminalModel()->get_state());
+}
+
+void MPCWalk::findTerminalStateResidualModel() {
+  boost::shared_ptr<IntegratedActionModelEuler> iam =
+      boost::dynamic_pointer_cast<IntegratedActionModelEuler>(
+          problem->get_terminalModel());
+  assert(iam != 0);
+  // std::cout << "IAM" << std::endl;
+
+  boost::shared_ptr<crocoddyl::DifferentialActionModelContactFwdDynamics> dam =
+      boost::dynamic_pointer_cast<
+          crocoddyl::DifferentialActionModelContactFwdDynamics>(
+          iam->get_differential());
+  assert(dam != 0);
+  // std::cout<<"DAM0" << *dam << std::endl;
+
+  boost::shared_ptr<CostModelSum> costsum = dam->get_costs();
+  // std::cout << "Cost sum" << std::endl;
+
+  const CostModelSum::CostModelContainer& costs = costsum->get_costs();
+  // std::cout << "Costs" << std::endl;
+  assert(costs.find(stateRegCostName) != costs.end());
+
+  boost::shared_ptr<CostModelAbstract> costa =
+      boost::const_pointer_cast<CostModelAbstract>(
+          costs.at(stateRegCostName)->cost);
+  // std::cout << "IAM" << std::endl;
+
+  boost::shared_ptr<CostModelResidual> cost =
+      boost::dynamic_pointer_cast<CostModelResidual>(costa);
+  assert(cost != 0);
+  // std::cout << "Cost" << std::endl;
+
+  cost->get_residual();
+  boost::shared_ptr<ResidualModelState> residual =
+      boost::dynamic_pointer_cast<ResidualModelState>(cost->get_residual());
+  assert(residual != 0);
+  residual->get_reference();
+  // std::cout << "Res" << std::endl;
+
+  this->terminalStateResidual = residual;
+}
+
+void MPCWalk::updateTerminalCost(const int t) {
+  xref = x0;
+  xref.head<3>() += vcomRef * (t + get_horizonTicks()) * DT;
+  terminalStateResidual->set_reference(xref);
+}
+
+void MPCWalk::calc(const Eigen::Ref<const VectorXd>& x, const int t) {
+  // std::cout << "calc Tmpc=" << Tmpc << std::endl;
+  ScopedTickPhase tick(profiler, TickProfiler::TICK);
+  // The deadline budget covers the whole tick, recede and warm start
+  // included.
+  const TickProfiler::Clock::time_point start = TickProfiler::Clock::now();
+
+  /// Change the value of the reference cost
+  updateTerminalCost(t);
+
+  /// Recede the horizon
+  {
+    ScopedTickPhase phase(profiler, TickProfiler::RECEDE);
+    if (coarseStride == 1) {
+      const int tlast = scheduledNode(t + Tmpc);
+      // std::cout << "tlast = " << tlast << std::endl;
+      const ActionPtr& model = storage->get_runningModels()[tlast];
+      problem->circularAppend(model, storageDatas.empty()
+                                         ? recycleData(model)
+                                         : storageDatas[tlast]);
+    } else {
+      updateHorizonNodes(t);
+    }
+  }
+
+  /// Change Warm start
+  {
+    ScopedTickPhase phase(profiler, TickProfiler::WARM_START);
+    shiftWarmStart();
+  }
+
+  /// Change init constraint
+  problem->set_x0(x);
+
+  /// Solve
+  {
+    ScopedTickPhase phase(profiler, TickProfiler::SOLVE);
+    profiledSolver->prepareSolve(
+        solver_deadline > 0.,
+        start + std::chrono::duration_cast<TickProfiler::Clock::duration>(
+                    std::chrono::duration<double>(solver_deadline)));
+    solver->solve(xs_guess, us_guess, solver_maxiter, false, reg);
+    iterations = static_cast<int>(profiledSolver->get_nbIterations());
+    deadlineHit = profiledSolver->get_deadlineHit();
+  }
+  profiledSolver->flushLineSearch();
+  reg = solver->get_xreg();
+  policy.update(*solver);
+}
+
+}  // namespace sobec
@@ -1,5 +1,7 @@
 #include "sobec/ocp.hpp"
 
+#include "sobec/trace.hpp"
+
 namespace sobec {
 
 OCP::OCP() {}
@@ -25,15 +27,15 @@ void OCP::initialize(const OCPSettings &settings,
   xc_.resize(designer_.get_rModel().nq + designer_.get_rModel().nv);
   xc_ << q0, v0;
 
-  std::cout << "left contact name = " << designer_.get_LF_name() << std::endl;
+  SOBEC_TRACE_INFO("Left contact name", trace::Label(designer_.get_LF_name()));
   sobec::HorizonManagerSettings horizonSettings = {designer_.get_LF_name(),
                                                    designer_.get_RF_name()};
   horizon_ =
       sobec::HorizonManager(horizonSettings, xc_, runningModels, terminalModel);
 
-  std::cout << "horizon left contact is "
-            << horizon_.contacts(0)->getContactStatus(designer_.get_LF_name())
-            << std::endl;
+  SOBEC_TRACE_INFO(
+      "Horizon left contact status",
+      horizon_.contacts(0)->getContactStatus(designer_.get_LF_name()));
 
   std::vector<Eigen::VectorXd> x_init;
   std::vector<Eigen::VectorXd> u_init;
@@ -111,7 +113,7 @@ void OCP::updateEndPhase() {
   if (TswitchPhase_ == 0) {
     TswitchPhase_ = OCP_settings_.Tstep;
     swingRightPhase_ = not(swingRightPhase_);
-    std::cout << "TswitchPhase = 0" << std::endl;
+    SOBEC_TRACE_DEBUG("TswitchPhase = 0");
   }
   // If this is the end of a step, update next foot trajectory
   if (TswitchTraj_ == 0) {
@@ -129,7 +131,7 @@ void OCP::updateEndPhase() {
           0., OCP_settings_.TsimpleSupport * OCP_settings_.Dt,
           starting_position_left_, final_position_left_);
 
-      std::cout << "TswitchTraj = 0 update left traj" << std::endl;
+      SOBEC_TRACE_DEBUG("TswitchTraj = 0 update left traj");
     } else {
       starting_position_right_ =
           designer_.get_rData().oMf[designer_.get_RF_id()];
@@ -143,7 +145,7 @@ void OCP::updateEndPhase() {
           0., OCP_settings_.TsimpleSupport * OCP_settings_.Dt,
           starting_position_right_, final_position_right_);
 
-      std::cout << "TswitchTraj = 0 update right traj" << std::endl;
+      SOBEC_TRACE_DEBUG("TswitchTraj = 0 update right traj");
     }
 
     TswitchTraj_ = OCP_settings_.Tstep + 5;
@@ -152,7 +154,7 @@ void OCP::updateEndPhase() {
 }
 
 void OCP::updateOCP(const Eigen::VectorXd &qc, const Eigen::VectorXd &vc) {
-  designer_.updateReducedModel(qc);
+  designer_.updateReducedKinematics(qc);
   xc_ << qc, vc;
   if (!contacts_sequence_.empty()) {
     TswitchTraj_--;
@@ -162,8 +164,8 @@ void OCP::updateOCP(const Eigen::VectorXd &qc, const Eigen::VectorXd &vc) {
     // " << Tswitch_ << " and iteration " << iteration_ << std::endl;
     // If contacts_sequence[0] > 0 , this is a swing phase
     if (contacts_sequence_[0] > 0) {
-      std::cout << "Simple support phase with TswitchTraj = " << TswitchTraj_
-                << ", and TswitchPhase = " << TswitchPhase_ << std::endl;
+      SOBEC_TRACE_DEBUG("Simple support phase, TswitchTraj and TswitchPhase",
+                        TswitchTraj_, TswitchPhase_);
       // Get desired foot reference for the end of the horizon
       if (swingRightPhase_) {
         starting_position_right_ = swing_trajectory_right_->compute(
@@ -181,8 +183,8 @@ void OCP::updateOCP(const Eigen::VectorXd &qc, const Eigen::VectorXd &vc) {
     }
     // else, this is a double support phase
     else {
-      std::cout << "Double support phase with TswitchTraj = " << TswitchTraj_
-                << ", and TswitchPhase = " << TswitchPhase_ << std::endl;
+      SOBEC_TRACE_DEBUG("Double support phase, TswitchTraj and TswitchPhase",
+                        TswitchTraj_, TswitchPhase_);
       horizon_.setDoubleSupport(0, starting_position_right_,
                                 starting_position_left_,
                                 wrench_reference_double_);
@@ -0,0 +1,868 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "sobec/serialization.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <crocoddyl/core/activations/quadratic-barrier.hpp>
+#include <crocoddyl/core/activations/quadratic-flat-log.hpp>
+#include <crocoddyl/core/activations/quadratic.hpp>
+#include <crocoddyl/core/activations/weighted-quadratic.hpp>
+#include <crocoddyl/core/costs/cost-sum.hpp>
+#include <crocoddyl/core/costs/residual.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/residuals/control.hpp>
+#include <crocoddyl/core/utils/exception.hpp>
+#include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
+#include <crocoddyl/multibody/actuations/floating-base.hpp>
+#include <crocoddyl/multibody/contacts/contact-3d.hpp>
+#include <crocoddyl/multibody/contacts/contact-6d.hpp>
+#include <crocoddyl/multibody/contacts/multiple-contacts.hpp>
+#include <crocoddyl/multibody/residuals/com-position.hpp>
+#include <crocoddyl/multibody/residuals/contact-force.hpp>
+#include <crocoddyl/multibody/residuals/contact-wrench-cone.hpp>
+#include <crocoddyl/multibody/residuals/frame-placement.hpp>
+#include <crocoddyl/multibody/residuals/frame-rotation.hpp>
+#include <crocoddyl/multibody/residuals/frame-translation.hpp>
+#include <crocoddyl/multibody/residuals/frame-velocity.hpp>
+#include <crocoddyl/multibody/residuals/state.hpp>
+#include <crocoddyl/multibody/states/multibody.hpp>
+#include <fstream>
+#include <map>
+#include <typeinfo>
+
+#include "sobec/activation-quad-ref.hpp"
+#include "sobec/contact/contact-force.hpp"
+#include "sobec/contact/contact-fwddyn.hpp"
+#include "sobec/contact/contact1d.hpp"
+#include "sobec/contact/contact3d.hpp"
+#include "sobec/contact/multiple-contacts.hpp"
+#include "sobec/fwd.hpp"
+#include "sobec/lowpassfilter/lpf.hpp"
+#include "sobec/residual-com-velocity.hpp"
+#include "sobec/residual-cop.hpp"
+#include "sobec/residual-feet-collision.hpp"
+#include "sobec/residual-fly-high.hpp"
+#include "sobec/residual-vel-collision.hpp"
+
+namespace sobec {
+
+namespace {
+
+const char kMagic[8] = {'S', 'O', 'B', 'E', 'C', 'P', 'B', '\0'};
+const uint32_t kVersion = 1;
+
+enum ActionTag : uint8_t {
+  ACTION_SHARED = 0,  // Same model as a previous node, stored by its index.
+  ACTION_EULER,
+  ACTION_LPF
+};
+
+enum DifferentialTag : uint8_t {
+  DAM_CONTACT_FWDDYN = 0,
+  DAM_SOBEC_CONTACT_FWDDYN
+};
+
+enum ContactTag : uint8_t {
+  CONTACTS_MULTIPLE = 0,
+  CONTACTS_SOBEC_MULTIPLE,
+  CONTACT_6D,
+  CONTACT_3D,
+  CONTACT_SOBEC_3D,
+  CONTACT_SOBEC_1D
+};
+
+enum ActivationTag : uint8_t {
+  ACTIVATION_QUAD = 0,
+  ACTIVATION_WEIGHTED_QUAD,
+  ACTIVATION_QUADRATIC_BARRIER,
+  ACTIVATION_QUAD_FLAT_LOG,
+  ACTIVATION_QUAD_REF
+};
+
+enum ResidualTag : uint8_t {
+  RESIDUAL_STATE = 0,
+  RESIDUAL_CONTROL,
+  RESIDUAL_COM_POSITION,
+  RESIDUAL_FRAME_PLACEMENT,
+  RESIDUAL_FRAME_TRANSLATION,
+  RESIDUAL_FRAME_ROTATION,
+  RESIDUAL_FRAME_VELOCITY,
+  RESIDUAL_CONTACT_FORCE,
+  RESIDUAL_SOBEC_CONTACT_FORCE,
+  RESIDUAL_CONTACT_WRENCH_CONE,
+  RESIDUAL_COM_VELOCITY,
+  RESIDUAL_COP,
+  RESIDUAL_FLY_HIGH,
+  RESIDUAL_FEET_COLLISION
+};
+
+template <typename Derived, typename Base>
+boost::shared_ptr<Derived> as(const boost::shared_ptr<Base> &ptr) {
+  return boost::dynamic_pointer_cast<Derived>(ptr);
+}
+
+// The state of the LPF nodes is augmented with the filtered torques: the
+// multibody state is the one of the differential model.
+boost::shared_ptr<crocoddyl::StateMultibody> getMultibodyState(
+    const boost::shared_ptr<crocoddyl::ActionModelAbstract> &model) {
+  boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract> dam;
+  if (boost::shared_ptr<IntegratedActionModelLPF> lpf =
+          as<IntegratedActionModelLPF>(model)) {
+    dam = lpf->get_differential();
+  } else if (boost::shared_ptr<crocoddyl::IntegratedActionModelEuler> euler =
+                 as<crocoddyl::IntegratedActionModelEuler>(model)) {
+    dam = euler->get_differential();
+  }
+  return as<crocoddyl::StateMultibody>(dam ? dam->get_state()
+                                           : model->get_state());
+}
+
+class ProblemWriter {
+ public:
+  explicit ProblemWriter(std::ostream &os) : os_(os) {}
+
+  void writeHeader(const pinocchio::Model &model) {
+    os_.write(kMagic, sizeof(kMagic));
+    write<uint32_t>(kVersion);
+    writeString(model.name);
+    writeSize(static_cast<std::size_t>(model.nq));
+    writeSize(static_cast<std::size_t>(model.nv));
+    writeSize(model.frames.size());
+  }
+
+  void writeSize(const std::size_t n) { write<uint64_t>(n); }
+  void writeBool(const bool b) { write<uint8_t>(b ? 1 : 0); }
+  void writeDouble(const double d) { write<double>(d); }
+
+  void writeString(const std::string &s) {
+    writeSize(s.size());
+    os_.write(s.data(), static_cast<std::streamsize>(s.size()));
+  }
+
+  template <typename Derived>
+  void writeVector(const Eigen::MatrixBase<Derived> &v) {
+    const Eigen::VectorXd dense = v;
+    writeSize(static_cast<std::size_t>(dense.size()));
+    os_.write(reinterpret_cast<const char *>(dense.data()),
+              static_cast<std::streamsize>(dense.size() * sizeof(double)));
+  }
+
+  void writeVectors(const std::vector<Eigen::VectorXd> &vs) {
+    writeSize(vs.size());
+    for (const Eigen::VectorXd &v : vs) writeVector(v);
+  }
+
+  void writeRotation(const Eigen::Matrix3d &R) {
+    writeVector(Eigen::Map<const Eigen::VectorXd>(R.data(), 9));
+  }
+
+  void writeAction(
+      const boost::shared_ptr<crocoddyl::ActionModelAbstract> &model) {
+    std::map<const void *, std::size_t>::const_iterator it =
+        actionIds_.find(model.get());
+    if (it != actionIds_.end()) {
+      write<uint8_t>(ACTION_SHARED);
+      writeSize(it->second);
+      return;
+    }
+    const std::size_t id = actionIds_.size();
+    actionIds_[model.get()] = id;
+
+    if (boost::shared_ptr<IntegratedActionModelLPF> lpf =
+            as<IntegratedActionModelLPF>(model)) {
+      write<uint8_t>(ACTION_LPF);
+      writeDifferential(lpf->get_differential());
+      writeDouble(lpf->get_dt());
+      writeBool(lpf->get_with_cost_residual());
+      writeDouble(lpf->get_fc());
+      writeBool(lpf->get_tau_plus_integration());
+      write<int32_t>(lpf->get_filter());
+      writeBool(lpf->get_is_terminal());
+      writeDouble(lpf->get_control_reg_weight());
+      writeVector(lpf->get_control_reg_reference());
+      writeDouble(lpf->get_control_lim_weight());
+    } else if (boost::shared_ptr<crocoddyl::IntegratedActionModelEuler> euler =
+                   as<crocoddyl::IntegratedActionModelEuler>(model)) {
+      write<uint8_t>(ACTION_EULER);
+      writeDifferential(euler->get_differential());
+      writeDouble(euler->get_dt());
+    } else {
+      throw_pretty("Cannot serialize action model of type "
+                   << typeid(*model).name());
+    }
+  }
+
+ private:
+  template <typename T>
+  void write(const T value) {
+    os_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void writeDifferential(
+      const boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract>
+          &model) {
+    boost::shared_ptr<crocoddyl::DifferentialActionModelContactFwdDynamics>
+        dam = as<crocoddyl::DifferentialActionModelContactFwdDynamics>(model);
+    if (!dam) {
+      throw_pretty("Cannot serialize differential model of type "
+                   << typeid(*model).name());
+    }
+    if (!as<crocoddyl::ActuationModelFloatingBase>(dam->get_actuation())) {
+      throw_pretty("Only the floating-base actuation can be serialized");
+    }
+    boost::shared_ptr<DifferentialActionModelContactFwdDynamics> sobecDam =
+        as<DifferentialActionModelContactFwdDynamics>(model);
+    write<uint8_t>(sobecDam ? DAM_SOBEC_CONTACT_FWDDYN : DAM_CONTACT_FWDDYN);
+    writeContacts(dam->get_contacts());
+    writeCosts(dam->get_costs());
+    writeDouble(dam->get_damping());
+    if (sobecDam) writeBool(sobecDam->get_enable_force());
+  }
+
+  void writeContacts(
+      const boost::shared_ptr<crocoddyl::ContactModelMultiple> &contacts) {
+    write<uint8_t>(as<ContactModelMultiple>(contacts) ? CONTACTS_SOBEC_MULTIPLE
+                                                      : CONTACTS_MULTIPLE);
+    writeSize(contacts->get_nu());
+    writeSize(contacts->get_contacts().size());
+    for (const auto &item : contacts->get_contacts()) {
+      writeString(item.first);
+      writeBool(item.second->active);
+      writeContact(item.second->contact);
+    }
+  }
+
+  void writeContact(
+      const boost::shared_ptr<crocoddyl::ContactModelAbstract> &contact) {
+    if (boost::shared_ptr<ContactModel1D> c1 = as<ContactModel1D>(contact)) {
+      write<uint8_t>(CONTACT_SOBEC_1D);
+      writeSize(c1->get_id());
+      writeVector(c1->get_reference());
+      writeVector(c1->get_gains());
+      write<int32_t>(c1->get_mask());
+      write<int32_t>(c1->get_type());
+    } else if (boost::shared_ptr<ContactModel3D> c3 =
+                   as<ContactModel3D>(contact)) {
+      write<uint8_t>(CONTACT_SOBEC_3D);
+      writeSize(c3->get_id());
+      writeVector(c3->get_reference());
+      writeVector(c3->get_gains());
+      write<int32_t>(c3->get_type());
+    } else if (boost::shared_ptr<crocoddyl::ContactModel3D> c3 =
+                   as<crocoddyl::ContactModel3D>(contact)) {
+      write<uint8_t>(CONTACT_3D);
+      writeSize(c3->get_id());
+      writeVector(c3->get_reference());
+      writeVector(c3->get_gains());
+    } else if (boost::shared_ptr<crocoddyl::ContactModel6D> c6 =
+                   as<crocoddyl::ContactModel6D>(contact)) {
+      write<uint8_t>(CONTACT_6D);
+      writeSize(c6->get_id());
+      writeRotation(c6->get_reference().rotation());
+      writeVector(c6->get_reference().translation());
+      writeVector(c6->get_gains());
+    } else {
+      throw_pretty("Cannot serialize contact model of type "
+                   << typeid(*contact).name());
+    }
+  }
+
+  void writeCosts(const boost::shared_ptr<crocoddyl::CostModelSum> &costs) {
+    writeSize(costs->get_nu());
+    writeSize(costs->get_costs().size());
+    for (const auto &item : costs->get_costs()) {
+      boost::shared_ptr<crocoddyl::CostModelResidual> cost =
+          as<crocoddyl::CostModelResidual>(item.second->cost);
+      if (!cost) {
+        throw_pretty("Cannot serialize cost "
+                     << item.first << " of type "
+                     << typeid(*item.second->cost).name());
+      }
+      writeString(item.first);
+      writeDouble(item.second->weight);
+      writeBool(item.second->active);
+      writeActivation(cost->get_activation());
+      writeResidual(cost->get_residual());
+    }
+  }
+
+  void writeActivation(
+      const boost::shared_ptr<crocoddyl::ActivationModelAbstract> &act) {
+    if (boost::shared_ptr<ActivationModelQuadRef> a =
+            as<ActivationModelQuadRef>(act)) {
+      write<uint8_t>(ACTIVATION_QUAD_REF);
+      writeVector(a->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ActivationModelWeightedQuad> a =
+                   as<crocoddyl::ActivationModelWeightedQuad>(act)) {
+      write<uint8_t>(ACTIVATION_WEIGHTED_QUAD);
+      writeVector(a->get_weights());
+    } else if (boost::shared_ptr<crocoddyl::ActivationModelQuadraticBarrier> a =
+                   as<crocoddyl::ActivationModelQuadraticBarrier>(act)) {
+      // The bounds are stored as used, i.e. after the beta scaling.
+      write<uint8_t>(ACTIVATION_QUADRATIC_BARRIER);
+      writeVector(a->get_bounds().lb);
+      writeVector(a->get_bounds().ub);
+      writeDouble(a->get_bounds().beta);
+    } else if (boost::shared_ptr<crocoddyl::ActivationModelQuadFlatLog> a =
+                   as<crocoddyl::ActivationModelQuadFlatLog>(act)) {
+      write<uint8_t>(ACTIVATION_QUAD_FLAT_LOG);
+      writeSize(a->get_nr());
+      writeDouble(a->get_alpha());
+    } else if (as<crocoddyl::ActivationModelQuad>(act)) {
+      write<uint8_t>(ACTIVATION_QUAD);
+      writeSize(act->get_nr());
+    } else {
+      throw_pretty("Cannot serialize activation model of type "
+                   << typeid(*act).name());
+    }
+  }
+
+  void writeResidual(
+      const boost::shared_ptr<crocoddyl::ResidualModelAbstract> &res) {
+    if (boost::shared_ptr<crocoddyl::ResidualModelState> r =
+            as<crocoddyl::ResidualModelState>(res)) {
+      write<uint8_t>(RESIDUAL_STATE);
+      writeVector(r->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelControl> r =
+                   as<crocoddyl::ResidualModelControl>(res)) {
+      write<uint8_t>(RESIDUAL_CONTROL);
+      writeVector(r->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelCoMPosition> r =
+                   as<crocoddyl::ResidualModelCoMPosition>(res)) {
+      write<uint8_t>(RESIDUAL_COM_POSITION);
+      writeVector(r->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelFramePlacement> r =
+                   as<crocoddyl::ResidualModelFramePlacement>(res)) {
+      write<uint8_t>(RESIDUAL_FRAME_PLACEMENT);
+      writeSize(r->get_id());
+      writeRotation(r->get_reference().rotation());
+      writeVector(r->get_reference().translation());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameTranslation> r =
+                   as<crocoddyl::ResidualModelFrameTranslation>(res)) {
+      write<uint8_t>(RESIDUAL_FRAME_TRANSLATION);
+      writeSize(r->get_id());
+      writeVector(r->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameRotation> r =
+                   as<crocoddyl::ResidualModelFrameRotation>(res)) {
+      write<uint8_t>(RESIDUAL_FRAME_ROTATION);
+      writeSize(r->get_id());
+      writeRotation(r->get_reference());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelFrameVelocity> r =
+                   as<crocoddyl::ResidualModelFrameVelocity>(res)) {
+      write<uint8_t>(RESIDUAL_FRAME_VELOCITY);
+      writeSize(r->get_id());
+      writeVector(r->get_reference().toVector());
+      write<int32_t>(r->get_type());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelContactForce> r =
+                   as<crocoddyl::ResidualModelContactForce>(res)) {
+      write<uint8_t>(as<ResidualModelContactForce>(res)
+                         ? RESIDUAL_SOBEC_CONTACT_FORCE
+                         : RESIDUAL_CONTACT_FORCE);
+      writeSize(r->get_id());
+      writeVector(r->get_reference().toVector());
+      writeSize(r->get_nr());
+    } else if (boost::shared_ptr<crocoddyl::ResidualModelContactWrenchCone> r =
+                   as<crocoddyl::ResidualModelContactWrenchCone>(res)) {
+      const crocoddyl::WrenchCone &cone = r->get_reference();
+      write<uint8_t>(RESIDUAL_CONTACT_WRENCH_CONE);
+      writeSize(r->get_id());
+      writeRotation(cone.get_R());
+      writeDouble(cone.get_mu());
+      writeVector(cone.get_box());
+      writeSize(cone.get_nf());
+      writeBool(cone.get_inner_appr());
+      writeDouble(cone.get_min_nforce());
+      writeDouble(cone.get_max_nforce());
+    } else if (boost::shared_ptr<ResidualModelCoMVelocity> r =
+                   as<ResidualModelCoMVelocity>(res)) {
+      write<uint8_t>(RESIDUAL_COM_VELOCITY);
+      writeVector(r->get_reference());
+    } else if (boost::shared_ptr<ResidualModelCenterOfPressure> r =
+                   as<ResidualModelCenterOfPressure>(res)) {
+      write<uint8_t>(RESIDUAL_COP);
+      writeSize(r->get_contact_id());
+    } else if (boost::shared_ptr<ResidualModelFlyHigh> r =
+                   as<ResidualModelFlyHigh>(res)) {
+      write<uint8_t>(RESIDUAL_FLY_HIGH);
+      writeSize(r->get_frame_id());
+      writeDouble(r->getSlope());
+    } else if (boost::shared_ptr<ResidualModelFeetCollision> r =
+                   as<ResidualModelFeetCollision>(res)) {
+      write<uint8_t>(RESIDUAL_FEET_COLLISION);
+      writeSize(r->get_frame_id1());
+      writeSize(r->get_frame_id2());
+    } else {
+#ifdef PINOCCHIO_WITH_HPP_FCL
+      // The collision geometries (hpp-fcl meshes) are not part of the
+      // snapshot, which only stores the parameters of the nodes.
+      if (as<ResidualModelVelCollision>(res)) {
+        throw_pretty("Cannot serialize ResidualModelVelCollision: its "
+                     "geometry model is not stored in the snapshot, add the "
+                     "collision costs again after loading");
+      }
+#endif
+      throw_pretty("Cannot serialize residual model of type "
+                   << typeid(*res).name());
+    }
+    writeSize(res->get_nu());
+  }
+
+  std::ostream &os_;
+  std::map<const void *, std::size_t> actionIds_;
+};
+
+class ProblemReader {
+ public:
+  ProblemReader(const char *buffer, const std::size_t size,
+                boost::shared_ptr<pinocchio::Model> model)
+      : cursor_(buffer), end_(buffer + size), model_(model) {}
+
+  void readHeader() {
+    if (static_cast<std::size_t>(end_ - cursor_) < sizeof(kMagic) ||
+        std::memcmp(cursor_, kMagic, sizeof(kMagic)) != 0) {
+      throw_pretty("Invalid snapshot: not a sobec shooting problem");
+    }
+    cursor_ += sizeof(kMagic);
+    const uint32_t version = read<uint32_t>();
+    if (version != kVersion) {
+      throw_pretty("Invalid snapshot: version " << version << " (expected "
+                                                << kVersion << ")");
+    }
+    const std::string name = readString();
+    const std::size_t nq = readSize();
+    const std::size_t nv = readSize();
+    const std::size_t nframes = readSize();
+    if (name != model_->name || nq != static_cast<std::size_t>(model_->nq) ||
+        nv != static_cast<std::size_t>(model_->nv) ||
+        nframes != model_->frames.size()) {
+      throw_pretty("Invalid snapshot: it was saved with model "
+                   << name << " (nq=" << nq << ", nv=" << nv
+                   << ", frames=" << nframes << ")");
+    }
+    state_ = boost::make_shared<crocoddyl::StateMultibody>(model_);
+    actuation_ =
+        boost::make_shared<crocoddyl::ActuationModelFloatingBase>(state_);
+  }
+
+  std::size_t readSize() { return static_cast<std::size_t>(read<uint64_t>()); }
+  bool readBool() { return read<uint8_t>() != 0; }
+  double readDouble() { return read<double>(); }
+
+  std::string readString() {
+    const std::size_t n = readSize();
+    const char *data = take(n);
+    return std::string(data, n);
+  }
+
+  Eigen::VectorXd readVector() {
+    const std::size_t n = readSize();
+    if (n > static_cast<std::size_t>(end_ - cursor_) / sizeof(double)) {
+      throw_pretty("Invalid snapshot: truncated data");
+    }
+    Eigen::VectorXd v(n);
+    std::memcpy(v.data(), take(n * sizeof(double)), n * sizeof(double));
+    return v;
+  }
+
+  template <int N>
+  Eigen::Matrix<double, N, 1> readFixedVector() {
+    const Eigen::VectorXd v = readVector();
+    if (v.size() != N) throw_pretty("Invalid snapshot: wrong vector size");
+    return v;
+  }
+
+  std::vector<Eigen::VectorXd> readVectors() {
+    std::vector<Eigen::VectorXd> vs(readSize());
+    for (Eigen::VectorXd &v : vs) v = readVector();
+    return vs;
+  }
+
+  Eigen::Matrix3d readRotation() {
+    const Eigen::VectorXd v = readVector();
+    if (v.size() != 9) throw_pretty("Invalid snapshot: wrong rotation size");
+    return Eigen::Map<const Eigen::Matrix3d>(v.data());
+  }
+
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> readAction() {
+    const uint8_t tag = read<uint8_t>();
+    if (tag == ACTION_SHARED) {
+      const std::size_t id = readSize();
+      if (id >= actions_.size()) {
+        throw_pretty("Invalid snapshot: unknown shared action " << id);
+      }
+      return actions_[id];
+    }
+
+    boost::shared_ptr<crocoddyl::ActionModelAbstract> action;
+    if (tag == ACTION_LPF) {
+      boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract> dam =
+          readDifferential();
+      const double dt = readDouble();
+      const bool with_cost_residual = readBool();
+      const double fc = readDouble();
+      const bool tau_plus_integration = readBool();
+      const int filter = read<int32_t>();
+      const bool is_terminal = readBool();
+      boost::shared_ptr<IntegratedActionModelLPF> lpf =
+          boost::make_shared<IntegratedActionModelLPF>(
+              dam, dt, with_cost_residual, fc, tau_plus_integration, filter,
+              is_terminal);
+      const double wreg = readDouble();
+      const Eigen::VectorXd wref = readVector();
+      const double wlim = readDouble();
+      if (wreg > 0.) lpf->set_control_reg_cost(wreg, wref);
+      if (wlim > 0.) lpf->set_control_lim_cost(wlim);
+      action = lpf;
+    } else if (tag == ACTION_EULER) {
+      boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract> dam =
+          readDifferential();
+      action = boost::make_shared<crocoddyl::IntegratedActionModelEuler>(
+          dam, readDouble());
+    } else {
+      throw_pretty("Invalid snapshot: unknown action tag " << int(tag));
+    }
+    actions_.push_back(action);
+    return action;
+  }
+
+ private:
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char *take(const std::size_t n) {
+    if (n > static_cast<std::size_t>(end_ - cursor_)) {
+      throw_pretty("Invalid snapshot: truncated data");
+    }
+    const char *data = cursor_;
+    cursor_ += n;
+    return data;
+  }
+
+  boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract>
+  readDifferential() {
+    const uint8_t tag = read<uint8_t>();
+    boost::shared_ptr<crocoddyl::ContactModelMultiple> contacts =
+        readContacts();
+    boost::shared_ptr<crocoddyl::CostModelSum> costs = readCosts();
+    const double damping = readDouble();
+    if (tag == DAM_SOBEC_CONTACT_FWDDYN) {
+      return boost::make_shared<DifferentialActionModelContactFwdDynamics>(
+          state_, actuation_, contacts, costs, damping, readBool());
+    } else if (tag == DAM_CONTACT_FWDDYN) {
+      // enable_force is not exposed by crocoddyl: it is restored to true, as
+      // set by all the sobec OCP builders.
+      return boost::make_shared<
+          crocoddyl::DifferentialActionModelContactFwdDynamics>(
+          state_, actuation_, contacts, costs, damping, true);
+    }
+    throw_pretty("Invalid snapshot: unknown differential tag " << int(tag));
+  }
+
+  boost::shared_ptr<crocoddyl::ContactModelMultiple> readContacts() {
+    const uint8_t tag = read<uint8_t>();
+    const std::size_t nu = readSize();
+    boost::shared_ptr<crocoddyl::ContactModelMultiple> contacts;
+    if (tag == CONTACTS_SOBEC_MULTIPLE) {
+      contacts = boost::make_shared<ContactModelMultiple>(state_, nu);
+    } else if (tag == CONTACTS_MULTIPLE) {
+      contacts =
+          boost::make_shared<crocoddyl::ContactModelMultiple>(state_, nu);
+    } else {
+      throw_pretty("Invalid snapshot: unknown contact stack tag " << int(tag));
+    }
+    const std::size_t n = readSize();
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::string name = readString();
+      const bool active = readBool();
+      contacts->addContact(name, readContact(nu), active);
+    }
+    return contacts;
+  }
+
+  boost::shared_ptr<crocoddyl::ContactModelAbstract> readContact(
+      const std::size_t nu) {
+    const uint8_t tag = read<uint8_t>();
+    const pinocchio::FrameIndex id = readSize();
+    if (tag == CONTACT_SOBEC_1D) {
+      const eVector3 ref = readFixedVector<3>();
+      const eVector2 gains = readFixedVector<2>();
+      const Vector3MaskType mask =
+          static_cast<Vector3MaskType>(read<int32_t>());
+      const pinocchio::ReferenceFrame type =
+          static_cast<pinocchio::ReferenceFrame>(read<int32_t>());
+      return boost::make_shared<ContactModel1D>(state_, id, ref, nu, gains,
+                                                mask, type);
+    } else if (tag == CONTACT_SOBEC_3D) {
+      const eVector3 ref = readFixedVector<3>();
+      const eVector2 gains = readFixedVector<2>();
+      const pinocchio::ReferenceFrame type =
+          static_cast<pinocchio::ReferenceFrame>(read<int32_t>());
+      return boost::make_shared<ContactModel3D>(state_, id, ref, nu, gains,
+                                                type);
+    } else if (tag == CONTACT_3D) {
+      const eVector3 ref = readFixedVector<3>();
+      const eVector2 gains = readFixedVector<2>();
+      return boost::make_shared<crocoddyl::ContactModel3D>(state_, id, ref, nu,
+                                                           gains);
+    } else if (tag == CONTACT_6D) {
+      const Eigen::Matrix3d R = readRotation();
+      const eVector3 p = readFixedVector<3>();
+      const eVector2 gains = readFixedVector<2>();
+      return boost::make_shared<crocoddyl::ContactModel6D>(
+          state_, id, pinocchio::SE3(R, p), nu, gains);
+    }
+    throw_pretty("Invalid snapshot: unknown contact tag " << int(tag));
+  }
+
+  boost::shared_ptr<crocoddyl::CostModelSum> readCosts() {
+    const std::size_t nu = readSize();
+    boost::shared_ptr<crocoddyl::CostModelSum> costs =
+        boost::make_shared<crocoddyl::CostModelSum>(state_, nu);
+    const std::size_t n = readSize();
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::string name = readString();
+      const double weight = readDouble();
+      const bool active = readBool();
+      boost::shared_ptr<crocoddyl::ActivationModelAbstract> activation =
+          readActivation();
+      boost::shared_ptr<crocoddyl::ResidualModelAbstract> residual =
+          readResidual();
+      costs->addCost(name,
+                     boost::make_shared<crocoddyl::CostModelResidual>(
+                         state_, activation, residual),
+                     weight, active);
+    }
+    return costs;
+  }
+
+  boost::shared_ptr<crocoddyl::ActivationModelAbstract> readActivation() {
+    const uint8_t tag = read<uint8_t>();
+    switch (tag) {
+      case ACTIVATION_QUAD_REF:
+        return boost::make_shared<ActivationModelQuadRef>(readVector());
+      case ACTIVATION_WEIGHTED_QUAD:
+        return boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+            readVector());
+      case ACTIVATION_QUADRATIC_BARRIER: {
+        // Assign the bounds directly, the constructor of ActivationBounds
+        // would apply the beta scaling a second time.
+        crocoddyl::ActivationBounds bounds;
+        bounds.lb = readVector();
+        bounds.ub = readVector();
+        bounds.beta = readDouble();
+        return boost::make_shared<crocoddyl::ActivationModelQuadraticBarrier>(
+            bounds);
+      }
+      case ACTIVATION_QUAD_FLAT_LOG: {
+        const std::size_t nr = readSize();
+        return boost::make_shared<crocoddyl::ActivationModelQuadFlatLog>(
+            nr, readDouble());
+      }
+      case ACTIVATION_QUAD:
+        return boost::make_shared<crocoddyl::ActivationModelQuad>(readSize());
+    }
+    throw_pretty("Invalid snapshot: unknown activation tag " << int(tag));
+  }
+
+  boost::shared_ptr<crocoddyl::ResidualModelAbstract> readResidual() {
+    const uint8_t tag = read<uint8_t>();
+    switch (tag) {
+      case RESIDUAL_STATE: {
+        const Eigen::VectorXd xref = readVector();
+        return boost::make_shared<crocoddyl::ResidualModelState>(state_, xref,
+                                                                 readSize());
+      }
+      case RESIDUAL_CONTROL: {
+        const Eigen::VectorXd uref = readVector();
+        if (readSize() != static_cast<std::size_t>(uref.size())) {
+          throw_pretty("Invalid snapshot: wrong control residual size");
+        }
+        return boost::make_shared<crocoddyl::ResidualModelControl>(state_,
+                                                                   uref);
+      }
+      case RESIDUAL_COM_POSITION: {
+        const eVector3 cref = readFixedVector<3>();
+        return boost::make_shared<crocoddyl::ResidualModelCoMPosition>(
+            state_, cref, readSize());
+      }
+      case RESIDUAL_FRAME_PLACEMENT: {
+        const pinocchio::FrameIndex id = readSize();
+        const Eigen::Matrix3d R = readRotation();
+        const eVector3 p = readFixedVector<3>();
+        return boost::make_shared<crocoddyl::ResidualModelFramePlacement>(
+            state_, id, pinocchio::SE3(R, p), readSize());
+      }
+      case RESIDUAL_FRAME_TRANSLATION: {
+        const pinocchio::FrameIndex id = readSize();
+        const eVector3 ref = readFixedVector<3>();
+        return boost::make_shared<crocoddyl::ResidualModelFrameTranslation>(
+            state_, id, ref, readSize());
+      }
+      case RESIDUAL_FRAME_ROTATION: {
+        const pinocchio::FrameIndex id = readSize();
+        const Eigen::Matrix3d R = readRotation();
+        return boost::make_shared<crocoddyl::ResidualModelFrameRotation>(
+            state_, id, R, readSize());
+      }
+      case RESIDUAL_FRAME_VELOCITY: {
+        const pinocchio::FrameIndex id = readSize();
+        const pinocchio::Motion ref(readFixedVector<6>());
+        const pinocchio::ReferenceFrame type =
+            static_cast<pinocchio::ReferenceFrame>(read<int32_t>());
+        return boost::make_shared<crocoddyl::ResidualModelFrameVelocity>(
+            state_, id, ref, type, readSize());
+      }
+      case RESIDUAL_CONTACT_FORCE:
+      case RESIDUAL_SOBEC_CONTACT_FORCE: {
+        const pinocchio::FrameIndex id = readSize();
+        const pinocchio::Force ref(readFixedVector<6>());
+        const std::size_t nc = readSize();
+        const std::size_t nu = readSize();
+        if (tag == RESIDUAL_SOBEC_CONTACT_FORCE) {
+          return boost::make_shared<ResidualModelContactForce>(state_, id, ref,
+                                                               nc, nu);
+        }
+        return boost::make_shared<crocoddyl::ResidualModelContactForce>(
+            state_, id, ref, nc, nu);
+      }
+      case RESIDUAL_CONTACT_WRENCH_CONE: {
+        const pinocchio::FrameIndex id = readSize();
+        const Eigen::Matrix3d R = readRotation();
+        const double mu = readDouble();
+        const eVector2 box = readFixedVector<2>();
+        const std::size_t nf = readSize();
+        const bool inner_appr = readBool();
+        const double min_nforce = readDouble();
+        const double max_nforce = readDouble();
+        const crocoddyl::WrenchCone cone(R, mu, box, nf, inner_appr,
+                                         min_nforce, max_nforce);
+        return boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
+            state_, id, cone, readSize());
+      }
+      case RESIDUAL_COM_VELOCITY: {
+        const eVector3 vref = readFixedVector<3>();
+        return boost::make_shared<ResidualModelCoMVelocity>(state_, vref,
+                                                            readSize());
+      }
+      case RESIDUAL_COP: {
+        const pinocchio::FrameIndex id = readSize();
+        return boost::make_shared<ResidualModelCenterOfPressure>(state_, id,
+                                                                 readSize());
+      }
+      case RESIDUAL_FLY_HIGH: {
+        const pinocchio::FrameIndex id = readSize();
+        const double slope = readDouble();
+        return boost::make_shared<ResidualModelFlyHigh>(state_, id, slope,
+                                                        readSize());
+      }
+      case RESIDUAL_FEET_COLLISION: {
+        const pinocchio::FrameIndex id1 = readSize();
+        const pinocchio::FrameIndex id2 = readSize();
+        return boost::make_shared<ResidualModelFeetCollision>(state_, id1, id2,
+                                                              readSize());
+      }
+    }
+    throw_pretty("Invalid snapshot: unknown residual tag " << int(tag));
+  }
+
+  const char *cursor_;
+  const char *end_;
+  boost::shared_ptr<pinocchio::Model> model_;
+  boost::shared_ptr<crocoddyl::StateMultibody> state_;
+  boost::shared_ptr<crocoddyl::ActuationModelFloatingBase> actuation_;
+  std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> > actions_;
+};
+
+}  // namespace
+
+void saveShootingProblem(std::ostream &os,
+                         const crocoddyl::ShootingProblem &problem,
+                         const std::vector<Eigen::VectorXd> &xs,
+                         const std::vector<Eigen::VectorXd> &us) {
+  boost::shared_ptr<crocoddyl::StateMultibody> state =
+      getMultibodyState(problem.get_terminalModel());
+  if (!state) throw_pretty("Only multibody problems can be serialized");
+
+  ProblemWriter writer(os);
+  writer.writeHeader(*state->get_pinocchio());
+  writer.writeVector(problem.get_x0());
+  writer.writeSize(problem.get_T());
+  for (const auto &model : problem.get_runningModels())
+    writer.writeAction(model);
+  writer.writeAction(problem.get_terminalModel());
+  writer.writeVectors(xs);
+  writer.writeVectors(us);
+  if (!os) throw_pretty("Error while writing the shooting problem");
+}
+
+void saveShootingProblem(const std::string &filename,
+                         const crocoddyl::ShootingProblem &problem,
+                         const std::vector<Eigen::VectorXd> &xs,
+                         const std::vector<Eigen::VectorXd> &us) {
+  std::ofstream os(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!os) throw_pretty("Cannot open " << filename);
+  saveShootingProblem(os, problem, xs, us);
+}
+
+ShootingProblemSnapshot loadShootingProblem(
+    const char *buffer, const std::size_t size,
+    boost::shared_ptr<pinocchio::Model> model) {
+  ProblemReader reader(buffer, size, model);
+  reader.readHeader();
+  const Eigen::VectorXd x0 = reader.readVector();
+  std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> >
+      runningModels(reader.readSize());
+  for (auto &action : runningModels) action = reader.readAction();
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> terminalModel =
+      reader.readAction();
+
+  ShootingProblemSnapshot snapshot;
+  snapshot.problem = boost::make_shared<crocoddyl::ShootingProblem>(
+      x0, runningModels, terminalModel);
+  snapshot.xs = reader.readVectors();
+  snapshot.us = reader.readVectors();
+  return snapshot;
+}
+
+ShootingProblemSnapshot loadShootingProblem(
+    const std::string &filename, boost::shared_ptr<pinocchio::Model> model) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) throw_pretty("Cannot open " << filename);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    throw_pretty("Cannot read " << filename);
+  }
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) throw_pretty("Cannot map " << filename);
+
+  try {
+    ShootingProblemSnapshot snapshot =
+        loadShootingProblem(static_cast<const char *>(data), size, model);
+    munmap(data, size);
+    return snapshot;
+  } catch (...) {
+    munmap(data, size);
+    throw;
+  }
+}
+
+}  // namespace sobec
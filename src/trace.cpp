@@ -0,0 +1,133 @@
+#include "sobec/trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sobec {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> enabled(false);
+}  // namespace detail
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Rings of all the threads which emitted an event. They are never released,
+// so that the drainer can read them after their thread exited.
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<EventRing> > rings;
+
+// Ticks of Clock at start(), read by now() in the threads emitting events
+// while start() may set it: it is atomic since the emitters only do a relaxed
+// load of detail::enabled.
+std::atomic<Clock::rep> origin(Clock::now().time_since_epoch().count());
+
+// Background thread writing the events.
+std::mutex drainerMutex;
+std::thread drainer;
+std::atomic<bool> running(false);
+std::ofstream file;
+std::ostream* out = &std::cout;
+
+const char* levelName(const std::uint8_t level) {
+  switch (level) {
+    case WARNING:
+      return "WARNING";
+    case INFO:
+      return "INFO";
+    case DEBUG:
+      return "DEBUG";
+    default:
+      return "";
+  }
+}
+
+void write(const Event& event) {
+  *out << "[" << static_cast<double>(event.time) * 1e-9 << "] "
+       << levelName(event.level) << " " << event.message;
+  if (event.label[0] != '\0') *out << " " << event.label;
+  for (std::uint8_t i = 0; i < event.nvalues; ++i)
+    *out << (i == 0 ? " " : ", ") << event.values[i];
+  *out << "\n";
+}
+
+void drainAll() {
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  Event event;
+  for (const std::unique_ptr<EventRing>& ring : rings) {
+    while (ring->pop(event)) write(event);
+    const std::uint64_t dropped = ring->takeDropped();
+    if (dropped > 0) *out << "(" << dropped << " events dropped)\n";
+  }
+  out->flush();
+}
+
+void drain() {
+  while (running.load(std::memory_order_acquire)) {
+    drainAll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+}
+
+}  // namespace
+
+namespace detail {
+
+EventRing& threadRing() {
+  thread_local EventRing* ring = NULL;
+  if (ring == NULL) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.emplace_back(new EventRing());
+    ring = rings.back().get();
+  }
+  return *ring;
+}
+
+std::uint64_t now() {
+  // The origin is read first, so that it is not after the time of the event.
+  const Clock::duration start(origin.load(std::memory_order_acquire));
+  const Clock::duration elapsed = Clock::now().time_since_epoch() - start;
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+}  // namespace detail
+
+void start(const std::string& path) {
+  stop();
+  std::lock_guard<std::mutex> lock(drainerMutex);
+  if (path.empty()) {
+    out = &std::cout;
+  } else {
+    file.open(path.c_str());
+    if (!file) throw std::runtime_error("Cannot open the trace file " + path);
+    out = &file;
+  }
+  origin.store(Clock::now().time_since_epoch().count(),
+               std::memory_order_release);
+  running.store(true, std::memory_order_release);
+  drainer = std::thread(drain);
+  detail::enabled.store(true, std::memory_order_release);
+}
+
+void stop() {
+  std::lock_guard<std::mutex> lock(drainerMutex);
+  detail::enabled.store(false, std::memory_order_release);
+  if (!drainer.joinable()) return;
+  running.store(false, std::memory_order_release);
+  drainer.join();
+  drainAll();
+  if (file.is_open()) file.close();
+  out = &std::cout;
+}
+
+}  // namespace trace
+}  // namespace sobec
@@ -0,0 +1,514 @@
+#include "sobec/walk/ocp.hpp"
+
+#include <algorithm>
+#include <crocoddyl/core/activations/quadratic-barrier.hpp>
+#include <crocoddyl/core/activations/weighted-quadratic.hpp>
+#include <crocoddyl/core/costs/cost-sum.hpp>
+#include <crocoddyl/core/costs/residual.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/residuals/control.hpp>
+#include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
+#include <crocoddyl/multibody/actuations/floating-base.hpp>
+#include <crocoddyl/multibody/contacts/contact-6d.hpp>
+#include <crocoddyl/multibody/contacts/multiple-contacts.hpp>
+#include <crocoddyl/multibody/residuals/com-position.hpp>
+#include <crocoddyl/multibody/residuals/contact-force.hpp>
+#include <crocoddyl/multibody/residuals/contact-wrench-cone.hpp>
+#include <crocoddyl/multibody/residuals/frame-rotation.hpp>
+#include <crocoddyl/multibody/residuals/frame-translation.hpp>
+#include <crocoddyl/multibody/residuals/frame-velocity.hpp>
+#include <crocoddyl/multibody/residuals/state.hpp>
+#include <limits>
+#include <stdexcept>
+
+#include "sobec/mpc-walk.hpp"
+#include "sobec/residual-com-velocity.hpp"
+#include "sobec/residual-cop.hpp"
+#include "sobec/residual-feet-collision.hpp"
+#include "sobec/residual-fly-high.hpp"
+
+namespace sobec {
+namespace walk {
+
+namespace {
+
+typedef boost::shared_ptr<crocoddyl::StateMultibody> StatePtr;
+typedef boost::shared_ptr<crocoddyl::ActuationModelFloatingBase> ActuationPtr;
+
+Contact buildContacts(const RobotWrapper &robot, const StatePtr &state,
+                      const ActuationPtr &actuation,
+                      const std::vector<bool> &pattern,
+                      const WalkParams &p) {
+  Contact contacts = boost::make_shared<crocoddyl::ContactModelMultiple>(
+      state, actuation->get_nu());
+  for (std::size_t k = 0; k < robot.contactIds.size(); ++k) {
+    if (!pattern[k]) continue;
+    const pinocchio::FrameIndex cid = robot.contactIds[k];
+    contacts->addContact(robot.model->frames[cid].name + "_contact",
+                         boost::make_shared<crocoddyl::ContactModel6D>(
+                             state, cid, pinocchio::SE3::Identity(),
+                             actuation->get_nu(), p.baumgartGains));
+  }
+  return contacts;
+}
+
+AMA buildAction(const StatePtr &state, const ActuationPtr &actuation,
+                const Contact &contacts, const Cost &costs,
+                const WalkParams &p) {
+  DAM damodel =
+      boost::make_shared<crocoddyl::DifferentialActionModelContactFwdDynamics>(
+          state, actuation, contacts, costs, p.kktDamping, true);
+  return boost::make_shared<crocoddyl::IntegratedActionModelEuler>(damodel,
+                                                                   p.DT);
+}
+
+}  // namespace
+
+ContactPattern buildWalkContactPattern(const WalkParams &p) {
+  const std::vector<bool> both = {true, true};
+  const std::vector<bool> right = {false, true};
+  const std::vector<bool> left = {true, false};
+
+  ContactPattern pattern;
+  pattern.insert(pattern.end(), p.Tstart, both);
+  pattern.insert(pattern.end(), p.Tdouble, both);
+  pattern.insert(pattern.end(), p.Tsingle, right);
+  pattern.insert(pattern.end(), p.Tdouble, both);
+  pattern.insert(pattern.end(), p.Tsingle, left);
+  pattern.insert(pattern.end(), p.Tdouble, both);
+  pattern.insert(pattern.end(), p.Tend, both);
+  pattern.push_back(both);
+  return pattern;
+}
+
+Eigen::MatrixXd weightShareSmoothProfile(const ContactPattern &contactPattern,
+                                         const int duration) {
+  const int nrows = static_cast<int>(contactPattern.size());
+  const int ncontacts = static_cast<int>(contactPattern[0].size());
+  Eigen::MatrixXd contactImportance(nrows, ncontacts);
+  for (int t = 0; t < nrows; ++t) {
+    for (int k = 0; k < ncontacts; ++k)
+      contactImportance(t, k) = contactPattern[t][k] ? 1. : 0.;
+    contactImportance.row(t) /= contactImportance.row(t).sum();
+  }
+
+  const int T = nrows - 1;
+  const int Ttrans = duration;
+  // switch_linear
+  Eigen::VectorXd trans(Ttrans);
+  for (int i = 0; i < Ttrans; ++i) trans[i] = (i + 1.) / (Ttrans + 1.);
+
+  for (int t = 1; t < T; ++t) {
+    bool creation = false;
+    for (int k = 0; k < ncontacts; ++k)
+      creation |= !contactPattern[t - 1][k] && contactPattern[t][k];
+    if (!creation) continue;
+    for (int k = 0; k < ncontacts; ++k) {
+      const double before = contactImportance(t - 1, k);
+      const double after = contactImportance(t, k);
+      for (int i = 0; i < Ttrans && t + i < nrows; ++i)
+        contactImportance(t + i, k) = before * (1 - trans[i]) + after * trans[i];
+    }
+  }
+  for (int t = T - 1; t >= 1; --t) {
+    bool rupture = false;
+    for (int k = 0; k < ncontacts; ++k)
+      rupture |= !contactPattern[t][k] && contactPattern[t - 1][k];
+    if (!rupture) continue;
+    for (int k = 0; k < ncontacts; ++k) {
+      const double before = contactImportance(t - 1, k);
+      const double after = contactImportance(t, k);
+      for (int i = 0; i < Ttrans; ++i) {
+        if (t - Ttrans + i < 0) continue;
+        contactImportance(t - Ttrans + i, k) =
+            after * trans[i] + before * (1 - trans[i]);
+      }
+    }
+  }
+  return contactImportance;
+}
+
+std::vector<std::vector<eVector6> > computeReferenceForces(
+    const ContactPattern &contactPattern, const double robotweight,
+    const int maxTransitionDuration) {
+  const int T = static_cast<int>(contactPattern.size());
+
+  // Search the contact phase of minimal duration (typically double support)
+  const std::vector<bool> *contactState = NULL;
+  int dur = T, mindur = T;
+  for (const std::vector<bool> &s : contactPattern) {
+    dur += 1;
+    if (contactState == NULL || s != *contactState) {
+      contactState = &s;
+      mindur = std::min(mindur, dur);
+      dur = 0;
+    }
+  }
+
+  // Select the smoothing transition to be smaller than half of the minimal
+  // duration.
+  const int transitionDuration =
+      std::min((mindur - 1) / 2, maxTransitionDuration);
+
+  // Contact importance, ie how much of the weight should be supported by each
+  // foot at each time.
+  const Eigen::MatrixXd contactImportance =
+      weightShareSmoothProfile(contactPattern, transitionDuration);
+
+  // Contact reference forces are set to contactimportance*weight
+  eVector6 weightReaction;
+  weightReaction << 0, 0, robotweight, 0, 0, 0;
+  std::vector<std::vector<eVector6> > referenceForces(T);
+  for (int t = 0; t < T; ++t) {
+    for (std::size_t k = 0; k < contactPattern[t].size(); ++k)
+      referenceForces[t].push_back(weightReaction * contactImportance(t, k));
+  }
+  return referenceForces;
+}
+
+std::vector<AMA> buildRunningModels(const RobotWrapper &robot,
+                                    const ContactPattern &contactPattern,
+                                    const WalkParams &p) {
+  const std::vector<std::vector<eVector6> > referenceForces =
+      computeReferenceForces(contactPattern, robot.gravForce);
+  const pinocchio::Model &model = *robot.model;
+
+  // The models are stateless, so the nodes share the state and actuation.
+  StatePtr state = boost::make_shared<crocoddyl::StateMultibody>(robot.model);
+  ActuationPtr actuation =
+      boost::make_shared<crocoddyl::ActuationModelFloatingBase>(state);
+  const std::size_t nu = actuation->get_nu();
+
+  // Selection of the main joints, to be kept at their reference at impact.
+  Eigen::VectorXd jselec = Eigen::VectorXd::Zero(model.nv * 2);
+  for (const std::string &name : p.mainJointIds) {
+    if (!model.existJointName(name))
+      throw std::invalid_argument("Joint " + name + " not in the model");
+    jselec[model.joints[model.getJointId(name)].idx_v()] = 1;
+  }
+
+  std::vector<AMA> models;
+  for (std::size_t t = 0; t + 1 < contactPattern.size(); ++t) {
+    const std::vector<bool> &pattern = contactPattern[t];
+
+    // Contacts
+    Contact contacts = buildContacts(robot, state, actuation, pattern, p);
+
+    // Costs
+    Cost costs = boost::make_shared<crocoddyl::CostModelSum>(state, nu);
+
+    costs->addCost(
+        "stateReg",
+        boost::make_shared<crocoddyl::CostModelResidual>(
+            state,
+            boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                p.stateImportance.cwiseAbs2()),
+            boost::make_shared<crocoddyl::ResidualModelState>(state, robot.x0,
+                                                              nu)),
+        p.refStateWeight);
+
+    if (p.refTorqueWeight > 0) {
+      costs->addCost(
+          "ctrlReg",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  p.controlImportance.cwiseAbs2()),
+              boost::make_shared<crocoddyl::ResidualModelControl>(state, nu)),
+          p.refTorqueWeight);
+    }
+
+    if (p.comWeight > 0) {
+      costs->addCost(
+          "com",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  eVector3(0, 0, 1)),
+              boost::make_shared<crocoddyl::ResidualModelCoMPosition>(
+                  state, robot.com0, nu)),
+          p.comWeight);
+    }
+
+    costs->addCost(
+        "comVelCost",
+        boost::make_shared<crocoddyl::CostModelResidual>(
+            state,
+            boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                p.vcomImportance),
+            boost::make_shared<ResidualModelCoMVelocity>(state, p.vcomRef, nu)),
+        p.vcomWeight);
+
+    // Contact costs
+    for (std::size_t k = 0; k < robot.contactIds.size(); ++k) {
+      if (!pattern[k]) continue;
+      const pinocchio::FrameIndex cid = robot.contactIds[k];
+      const std::string &name = model.frames[cid].name;
+
+      costs->addCost(
+          name + "_cop",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  eVector2::Constant(1.0 / (p.footSize * p.footSize))),
+              boost::make_shared<ResidualModelCenterOfPressure>(state, cid,
+                                                                nu)),
+          p.copWeight);
+
+      // Cone with enormous friction (Assuming the robot will barely ever
+      // slide). p.footSize is the allowed area size, while cone expects the
+      // corner coordinates => x2
+      const crocoddyl::WrenchCone cone(Eigen::Matrix3d::Identity(), 1000,
+                                       eVector2::Constant(p.footSize * 2), 4,
+                                       true, 1, 10000);
+      Eigen::VectorXd ub = cone.get_ub();
+      ub.head(4).setConstant(std::numeric_limits<double>::infinity());
+      ub.tail(8).setConstant(std::numeric_limits<double>::infinity());
+      costs->addCost(
+          name + "_cone",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelQuadraticBarrier>(
+                  crocoddyl::ActivationBounds(cone.get_lb(), ub)),
+              boost::make_shared<crocoddyl::ResidualModelContactWrenchCone>(
+                  state, cid, cone, nu)),
+          p.conePenaltyWeight);
+
+      // Penalize the distance to the central axis of the cone ...
+      //  ... using normalization weights depending on the axis.
+      // The weights are squared to match the tuning of the CASADI formulation.
+      eVector6 w = p.forceImportance.cwiseAbs2();
+      w[2] = 0;
+      costs->addCost(
+          name + "_coneaxis",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(w),
+              boost::make_shared<crocoddyl::ResidualModelContactForce>(
+                  state, cid, pinocchio::Force::Zero(), 6, nu)),
+          p.coneAxisWeight);
+
+      // Follow reference (smooth) contact forces
+      costs->addCost(
+          name + "_forceref",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state, boost::make_shared<crocoddyl::ResidualModelContactForce>(
+                         state, cid, pinocchio::Force(referenceForces[t][k]),
+                         6, nu)),
+          p.refForceWeight / (robot.gravForce * robot.gravForce));
+    }
+
+    // IMPACT
+    for (std::size_t k = 0; k < robot.contactIds.size(); ++k) {
+      if (t == 0 || contactPattern[t - 1][k] || !pattern[k]) continue;
+      // REMEMBER TO divide the weight by p.DT, as impact should be
+      // independant of the node duration (at least, that s how weights are
+      // tuned in casadi).
+      const pinocchio::FrameIndex cid = robot.contactIds[k];
+      const std::string &name = model.frames[cid].name;
+
+      costs->addCost(
+          name + "_altitudeimpact",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  eVector3(0, 0, 1)),
+              boost::make_shared<crocoddyl::ResidualModelFrameTranslation>(
+                  state, cid, eVector3::Zero(), nu)),
+          p.impactAltitudeWeight / p.DT);
+
+      costs->addCost(
+          name + "_velimpact",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state, boost::make_shared<crocoddyl::ResidualModelFrameVelocity>(
+                         state, cid, pinocchio::Motion::Zero(),
+                         pinocchio::LOCAL, nu)),
+          p.impactVelocityWeight / p.DT);
+
+      costs->addCost(
+          name + "_rotimpact",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  eVector3(1, 1, 0)),
+              boost::make_shared<crocoddyl::ResidualModelFrameRotation>(
+                  state, cid, Eigen::Matrix3d::Identity(), nu)),
+          p.impactRotationWeight / p.DT);
+
+      costs->addCost(
+          "impactRefJoint",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  jselec),
+              boost::make_shared<crocoddyl::ResidualModelState>(
+                  state, robot.x0, nu)),
+          p.refMainJointsAtImpactWeight / p.DT);
+    }
+
+    // Flying foot
+    for (std::size_t k = 0; k < robot.contactIds.size(); ++k) {
+      if (pattern[k]) continue;
+      const pinocchio::FrameIndex fid = robot.contactIds[k];
+      const std::string &name = model.frames[fid].name;
+
+      eVector6 vselec;
+      vselec << 0, 0, 1, 0, 0, 0;
+      costs->addCost(
+          name + "_vfoot_vel",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                  vselec),
+              boost::make_shared<crocoddyl::ResidualModelFrameVelocity>(
+                  state, fid, pinocchio::Motion::Zero(),
+                  pinocchio::LOCAL_WORLD_ALIGNED, nu)),
+          p.verticalFootVelWeight);
+
+      // Slope is /2 since it is squared in casadi (je me comprends)
+      costs->addCost(name + "_flyhigh",
+                     boost::make_shared<crocoddyl::CostModelResidual>(
+                         state, boost::make_shared<ResidualModelFlyHigh>(
+                                    state, fid, p.flyHighSlope / 2.0, nu)),
+                     p.flyWeight);
+
+      // np.inf introduces an error on lb[2] in python, hence 1000.
+      costs->addCost(
+          name + "_groundcol",
+          boost::make_shared<crocoddyl::CostModelResidual>(
+              state,
+              boost::make_shared<crocoddyl::ActivationModelQuadraticBarrier>(
+                  crocoddyl::ActivationBounds(eVector3(-1000, -1000, 0.0),
+                                              eVector3(1000, 1000, 1000))),
+              boost::make_shared<crocoddyl::ResidualModelFrameTranslation>(
+                  state, fid, eVector3::Zero(), nu)),
+          p.groundColWeight);
+
+      for (std::size_t kc = 0; kc < robot.contactIds.size(); ++kc) {
+        if (!pattern[kc]) continue;
+        const pinocchio::FrameIndex cid = robot.contactIds[kc];
+        assert(fid != cid);
+
+        const pinocchio::FrameIndex ids1[] = {cid, robot.towIds.at(cid),
+                                              robot.heelIds.at(cid)};
+        const pinocchio::FrameIndex ids2[] = {fid, robot.towIds.at(fid),
+                                              robot.heelIds.at(fid)};
+        for (pinocchio::FrameIndex id1 : ids1) {
+          for (pinocchio::FrameIndex id2 : ids2) {
+            costs->addCost(
+                "feetcol_" + model.frames[id1].name + "_VS_" +
+                    model.frames[id2].name,
+                boost::make_shared<crocoddyl::CostModelResidual>(
+                    state,
+                    boost::make_shared<
+                        crocoddyl::ActivationModelQuadraticBarrier>(
+                        crocoddyl::ActivationBounds(
+                            Eigen::VectorXd::Constant(1, p.footMinimalDistance),
+                            Eigen::VectorXd::Constant(1, 1000))),
+                    boost::make_shared<ResidualModelFeetCollision>(state, id1,
+                                                                   id2, nu)),
+                p.feetCollisionWeight);
+          }
+        }
+      }
+    }
+
+    models.push_back(buildAction(state, actuation, contacts, costs, p));
+  }
+
+  return models;
+}
+
+AMA buildTerminalModel(const RobotWrapper &robot,
+                       const ContactPattern &contactPattern,
+                       const WalkParams &p) {
+  const std::vector<bool> &pattern = contactPattern.back();
+
+  // Horizon length
+  const double T = static_cast<double>(contactPattern.size() - 1);
+
+  StatePtr state = boost::make_shared<crocoddyl::StateMultibody>(robot.model);
+  ActuationPtr actuation =
+      boost::make_shared<crocoddyl::ActuationModelFloatingBase>(state);
+  const std::size_t nu = actuation->get_nu();
+
+  Contact contacts = buildContacts(robot, state, actuation, pattern, p);
+
+  Cost costs = boost::make_shared<crocoddyl::CostModelSum>(state, nu);
+
+  Eigen::VectorXd stateTerminalTarget = robot.x0;
+  stateTerminalTarget.head<3>() += p.vcomRef * T * p.DT;
+  costs->addCost("stateReg",
+                 boost::make_shared<crocoddyl::CostModelResidual>(
+                     state,
+                     boost::make_shared<crocoddyl::ActivationModelWeightedQuad>(
+                         p.stateTerminalImportance.cwiseAbs2()),
+                     boost::make_shared<crocoddyl::ResidualModelState>(
+                         state, stateTerminalTarget, nu)),
+                 p.stateTerminalWeight);
+
+  return buildAction(state, actuation, contacts, costs, p);
+}
+
+DDP buildSolver(const RobotWrapper &robot, const ContactPattern &contactPattern,
+                const WalkParams &p) {
+  const std::vector<AMA> models = buildRunningModels(robot, contactPattern, p);
+  const AMA termmodel = buildTerminalModel(robot, contactPattern, p);
+
+  boost::shared_ptr<crocoddyl::ShootingProblem> problem =
+      boost::make_shared<crocoddyl::ShootingProblem>(robot.x0, models,
+                                                     termmodel);
+  DDP ddp = boost::make_shared<crocoddyl::SolverFDDP>(problem);
+  ddp->set_th_stop(p.solver_th_stop);
+  return ddp;
+}
+
+void buildInitialGuess(const crocoddyl::ShootingProblem &problem,
+                       std::vector<Eigen::VectorXd> &xs,
+                       std::vector<Eigen::VectorXd> &us) {
+  const std::size_t T = problem.get_T();
+  xs.assign(T + 1, problem.get_x0());
+  us.resize(T);
+  for (std::size_t t = 0; t < T; ++t) {
+    const AMA &model = problem.get_runningModels()[t];
+    us[t] = Eigen::VectorXd::Zero(model->get_nu());
+    model->quasiStatic(problem.get_runningDatas()[t], us[t], xs[t]);
+  }
+}
+
+void configureMPCWalk(MPCWalk &mpc, const WalkParams &p) {
+  mpc.Tmpc = p.Tmpc;
+  mpc.Tstart = p.Tstart;
+  mpc.Tdouble = p.Tdouble;
+  mpc.Tsingle = p.Tsingle;
+  mpc.Tend = p.Tend;
+  mpc.DT = p.DT;
+  mpc.solver_th_stop = p.solver_th_stop;
+  mpc.vcomRef = p.vcomRef;
+  mpc.solver_reg_min = p.solver_reg_min;
+  mpc.solver_maxiter = p.solver_maxiter;
+}
+
+boost::shared_ptr<MPCWalk> buildMPCWalk(const RobotWrapper &robot,
+                                        const WalkParams &params,
+                                        const std::size_t maxiter) {
+  const ContactPattern contactPattern = buildWalkContactPattern(params);
+  DDP ddp = buildSolver(robot, contactPattern, params);
+
+  std::vector<Eigen::VectorXd> x0s, u0s;
+  buildInitialGuess(*ddp->get_problem(), x0s, u0s);
+  ddp->solve(x0s, u0s, maxiter);
+
+  boost::shared_ptr<MPCWalk> mpc =
+      boost::make_shared<MPCWalk>(ddp->get_problem());
+  configureMPCWalk(*mpc, params);
+  const std::vector<Eigen::VectorXd> &xs = ddp->get_xs();
+  const std::vector<Eigen::VectorXd> &us = ddp->get_us();
+  mpc->initialize(
+      std::vector<Eigen::VectorXd>(xs.begin(), xs.begin() + params.Tmpc + 1),
+      std::vector<Eigen::VectorXd>(us.begin(), us.begin() + params.Tmpc));
+  return mpc;
+}
+
+}  // namespace walk
+}  // namespace sobec
@@ -0,0 +1,53 @@
+#include "sobec/walk/params.hpp"
+
+#include <stdexcept>
+
+namespace sobec {
+namespace walk {
+
+namespace {
+
+// ### TALOS INFO
+// Main info we need for Talos, used to build the state importances.
+const double basisQWeights[] = {0, 0, 0, 50, 50, 0};
+const double legQWeights[] = {5, 5, 1, 2, 1, 1};
+const double armQWeight = 3;
+const double basisVWeights[] = {0, 0, 0, 3, 3, 1};  // ## was 003331
+const double legVWeight = 1;
+const double armVWeight = 2;
+
+// Importances for Talos legs, with narms arm joints (0 or 2).
+void talosImportances(const int narms, WalkParams &p) {
+  const int nv = 6 + 12 + narms;
+
+  p.stateImportance.resize(2 * nv);
+  Eigen::VectorXd &w = p.stateImportance;
+  w.head<6>() = Eigen::Map<const eVector6>(basisQWeights);
+  w.segment<6>(6) = Eigen::Map<const eVector6>(legQWeights);
+  w.segment<6>(12) = Eigen::Map<const eVector6>(legQWeights);
+  w.segment(18, narms).setConstant(armQWeight);
+  w.segment<6>(nv) = Eigen::Map<const eVector6>(basisVWeights);
+  w.segment<12>(nv + 6).setConstant(legVWeight);
+  w.segment(nv + 18, narms).setConstant(armVWeight);
+
+  p.stateTerminalImportance = Eigen::VectorXd::Zero(2 * nv);
+  p.stateTerminalImportance.head<6>() << 3, 3, 0, 0, 0, 30;
+  p.stateTerminalImportance.tail(nv).setOnes();
+
+  p.controlImportance = Eigen::VectorXd::Ones(nv - 6);
+}
+
+}  // namespace
+
+WalkParams::WalkParams(const std::string &robotName) {
+  if (robotName == "talos_14") {
+    talosImportances(2, *this);
+  } else if (robotName == "talos_12") {
+    talosImportances(0, *this);
+  } else {
+    throw std::invalid_argument("No walk parameters for robot " + robotName);
+  }
+}
+
+}  // namespace walk
+}  // namespace sobec
@@ -0,0 +1,63 @@
+#include "sobec/walk/robot_wrapper.hpp"
+
+#include <pinocchio/algorithm/center-of-mass.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <stdexcept>
+
+namespace sobec {
+namespace walk {
+
+void addChildrenFrames(pinocchio::Model &model,
+                       const std::vector<pinocchio::FrameIndex> &parentFrameIds,
+                       const std::string &subname,
+                       const pinocchio::SE3 &displacement) {
+  for (pinocchio::FrameIndex cid : parentFrameIds) {
+    assert(cid < model.frames.size());
+    const pinocchio::Frame f = model.frames[cid];
+    model.addFrame(pinocchio::Frame(f.name + "_" + subname, f.parent,
+                                    f.previousFrame, f.placement * displacement,
+                                    pinocchio::OP_FRAME));
+  }
+}
+
+RobotWrapper::RobotWrapper(const pinocchio::Model &model_,
+                           const std::string &contactKey,
+                           const std::string &refPosture)
+    : model(boost::make_shared<pinocchio::Model>(model_)) {
+  name = model->name + "_" + std::to_string(model->nv - 6);
+  for (pinocchio::FrameIndex i = 0; i < model->frames.size(); ++i) {
+    if (model->frames[i].name.find(contactKey) != std::string::npos)
+      contactIds.push_back(i);
+  }
+
+  pinocchio::SE3 displacement = pinocchio::SE3::Identity();
+  displacement.translation() << 0.1, 0, 0;
+  addChildrenFrames(*model, contactIds, "tow", displacement);
+  for (pinocchio::FrameIndex idf : contactIds)
+    towIds[idf] = model->getFrameId(model->frames[idf].name + "_tow");
+
+  displacement.translation() << -0.1, 0, 0;
+  addChildrenFrames(*model, contactIds, "heel", displacement);
+  for (pinocchio::FrameIndex idf : contactIds)
+    heelIds[idf] = model->getFrameId(model->frames[idf].name + "_heel");
+
+  if (model->referenceConfigurations.find(refPosture) ==
+      model->referenceConfigurations.end()) {
+    throw std::invalid_argument("No reference configuration " + refPosture);
+  }
+  const Eigen::VectorXd q0 = model->referenceConfigurations[refPosture];
+  x0.resize(model->nq + model->nv);
+  x0 << q0, Eigen::VectorXd::Zero(model->nv);
+
+  // Some key elements of the model
+  baseId = model->getFrameId("root_joint");
+  double mass = 0;
+  for (const pinocchio::Inertia &Y : model->inertias) mass += Y.mass();
+  gravForce = -mass * model->gravity.linear()[2];
+
+  pinocchio::Data data(*model);
+  com0 = pinocchio::centerOfMass(*model, data, q0);
+}
+
+}  // namespace walk
+}  // namespace sobec
@@ -0,0 +1,152 @@
+#include "sobec/wbc-async.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "sobec/trace.hpp"
+
+namespace sobec {
+
+WBCAsync::WBCAsync(boost::shared_ptr<WBC> wbc, const int policyNodes)
+    : wbc(wbc),
+      policyNodes_(std::max(1, policyNodes)),
+      Nc_(1),
+      running_(false),
+      posted_(0),
+      consumed_(0),
+      solves_(0),
+      missed_(0),
+      policySolves_(0),
+      policyAge_(0) {}
+
+WBCAsync::~WBCAsync() { stop(); }
+
+void WBCAsync::start() {
+  if (running_.load()) return;
+  if (!wbc->initialized_) {
+    throw std::runtime_error("The WBC must be initialized before starting.");
+  }
+  HorizonManager horizon = wbc->get_horizon();
+  const DDP ddp = horizon.get_ddp();
+  state_ = horizon.state(0);
+  Nc_ = std::max(1, wbc->get_settings().Nc);
+
+  // Preallocate both slots of the buffers, so that no allocation happens
+  // when filling or copying them.
+  const std::size_t n =
+      std::min<std::size_t>(policyNodes_, ddp->get_us().size());
+  policy_.xs.assign(ddp->get_xs().begin(), ddp->get_xs().begin() + n);
+  policy_.us.assign(ddp->get_us().begin(), ddp->get_us().begin() + n);
+  policy_.K.assign(ddp->get_K().begin(), ddp->get_K().begin() + n);
+  policy_.iteration = 0;
+  policy_.solveDuration = 0.;
+  policies_.initialize(policy_);
+
+  Request request;
+  request.x = ddp->get_xs()[0];
+  request.iteration = 0;
+  request.is_feasible = false;
+  request.id = 0;
+  requests_.initialize(request);
+
+  x_ = Eigen::VectorXd::Zero(state_->get_nx());
+  dx_ = Eigen::VectorXd::Zero(state_->get_ndx());
+  u_ = policy_.us[0];
+  posted_.store(0);
+  consumed_.store(0);
+  solves_.store(0);
+  missed_.store(0);
+  policySolves_ = 0;
+  running_.store(true);
+  worker_ = std::thread(&WBCAsync::run, this);
+}
+
+void WBCAsync::stop() {
+  running_.store(false);
+  wakeup_.notify_one();
+  if (worker_.joinable()) worker_.join();
+}
+
+const Eigen::VectorXd &WBCAsync::iterate(const int iteration,
+                                         const Eigen::VectorXd &q_current,
+                                         const Eigen::VectorXd &v_current,
+                                         const bool is_feasible) {
+  // shapeState only reads the gather map, which the worker does not touch.
+  wbc->shapeState(q_current, v_current, x_);
+  if (wbc->timeToSolveDDP(iteration)) {
+    const std::size_t id = posted_.load(std::memory_order_relaxed) + 1;
+    // The previous request was never taken by the worker.
+    if (consumed_.load(std::memory_order_acquire) + 1 < id) ++missed_;
+
+    Request &request = requests_.beginWrite();
+    request.x = x_;
+    request.iteration = iteration;
+    request.is_feasible = is_feasible;
+    request.id = id;
+    requests_.publish();
+
+    posted_.store(id, std::memory_order_release);
+    wakeup_.notify_one();
+  }
+  return currentTorques(iteration, x_);
+}
+
+const Eigen::VectorXd &WBCAsync::currentTorques(const int iteration,
+                                                const Eigen::VectorXd &x) {
+  // Copy the published solution only when a new one is available.
+  const std::size_t solves = solves_.load(std::memory_order_acquire);
+  if (solves != policySolves_ && policies_.read(policy_)) {
+    policySolves_ = solves;
+  }
+
+  policyAge_ = iteration - policy_.iteration;
+  const int node = std::min(std::max(policyAge_ / Nc_, 0),
+                            static_cast<int>(policy_.us.size()) - 1);
+  state_->diff(x, policy_.xs[node], dx_);
+  u_ = policy_.us[node];
+  u_.noalias() += policy_.K[node] * dx_;
+  return u_;
+}
+
+void WBCAsync::run() {
+  typedef std::chrono::steady_clock Clock;
+  const DDP ddp = wbc->get_horizon().get_ddp();
+  Request request;
+  request.x = ddp->get_xs()[0];
+
+  while (running_.load()) {
+    if (posted_.load(std::memory_order_acquire) ==
+            consumed_.load(std::memory_order_relaxed) ||
+        !requests_.read(request)) {
+      // iterate does not take the lock, so a notification may be lost: the
+      // timeout bounds the latency in that case.
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeup_.wait_for(lock, std::chrono::milliseconds(1));
+      continue;
+    }
+    consumed_.store(request.id, std::memory_order_release);
+
+    const Clock::time_point start = Clock::now();
+    try {
+      wbc->solveDDP(request.x, request.is_feasible);
+    } catch (const std::exception &e) {
+      SOBEC_TRACE_WARNING("WBCAsync: solve failed at iteration",
+                          trace::Label(e.what()), request.iteration);
+      continue;
+    }
+
+    WBCPolicySnapshot &policy = policies_.beginWrite();
+    for (std::size_t t = 0; t < policy.us.size(); ++t) {
+      policy.xs[t] = ddp->get_xs()[t];
+      policy.us[t] = ddp->get_us()[t];
+      policy.K[t] = ddp->get_K()[t];
+    }
+    policy.iteration = request.iteration;
+    policy.solveDuration =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    policies_.publish();
+    ++solves_;
+  }
+}
+
+}  // namespace sobec
@@ -1,7 +1,30 @@
 #include "sobec/wbc.hpp"
 
+#include "sobec/trace.hpp"
+
 namespace sobec {
 
+namespace {
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+// Debug check (CHECK_RUNTIME_MALLOC): disallows the Eigen allocations for the
+// scope of a DDP tick, and allows them again even if the tick throws. Only
+// the Eigen code compiled in libsobec is checked: the allocations done in
+// crocoddyl or pinocchio, or by the standard containers, are not seen.
+class ScopedNoMalloc {
+ public:
+  ScopedNoMalloc() : allowed_(Eigen::internal::is_malloc_allowed()) {
+    Eigen::internal::set_is_malloc_allowed(false);
+  }
+  ~ScopedNoMalloc() { Eigen::internal::set_is_malloc_allowed(allowed_); }
+
+ private:
+  const bool allowed_;
+};
+#endif
+
+}  // namespace
+
 WBC::WBC() {}
 
 WBC::WBC(const WBCSettings &settings, const RobotDesigner &design,
@@ -25,21 +48,18 @@ void WBC::initialize(const WBCSettings &settings, const RobotDesigner &design,
 
   // designer settings
   controlled_joints_id_ = designer_.get_controlledJointsIDs();
-  x_internal_.resize(designer_.get_rModel().nq + designer_.get_rModel().nv);
+  buildGatherMaps();
+  x_internal_.resize(nq_reduced_ + nv_reduced_);
 
-  x0_.resize(designer_.get_rModel().nq + designer_.get_rModel().nv);
-  x0_ << shapeState(q0, v0);
-  std::cout << x0_.size() << std::endl;
+  x0_.resize(nq_reduced_ + nv_reduced_);
+  shapeState(q0, v0, x0_);
+  SOBEC_TRACE_INFO("WBC state size", x0_.size());
   designer_.updateReducedModel(x0_);
   designer_.updateCompleteModel(q0);
 
-  ref_LF_poses_.reserve(horizon_.size());
-  ref_RF_poses_.reserve(horizon_.size());
-
-  for (unsigned long i = 0; i < horizon_.size(); i++) {
-    ref_LF_poses_.push_back(designer_.get_LF_frame());
-    ref_RF_poses_.push_back(designer_.get_RF_frame());
-  }
+  ref_LF_poses_.initialize(horizon_.size(), designer_.get_LF_frame());
+  ref_RF_poses_.initialize(horizon_.size(), designer_.get_RF_frame());
+  ref_com_vel_.initialize(horizon_.size(), eVector3::Zero());
 
   // horizon settings
   std::vector<Eigen::VectorXd> xs_init;
@@ -66,6 +86,15 @@ void WBC::initialize(const WBCSettings &settings, const RobotDesigner &design,
   initialized_ = true;
 }
 
+void WBC::set_horizon(HorizonManager horizon) {
+  horizon_ = horizon;
+  // Before initialize, the rings are built from the first horizon.
+  if (!initialized_) return;
+  ref_LF_poses_.resize(horizon_.size(), designer_.get_LF_frame());
+  ref_RF_poses_.resize(horizon_.size(), designer_.get_RF_frame());
+  ref_com_vel_.resize(horizon_.size(), eVector3::Zero());
+}
+
 void WBC::generateWalkigCycle(ModelMaker &mm) {
   std::vector<Support> cycle;
   int takeoff_RF, land_RF, takeoff_LF, land_LF;
@@ -89,6 +118,7 @@ void WBC::generateWalkigCycle(ModelMaker &mm) {
                                   designer_.get_RF_name()};
   walkingCycle_ = HorizonManager(names, x0_, cyclicModels,
                                  cyclicModels[2 * settings_.Tstep - 1]);
+  horizon_.reserveData(cyclicModels);
 }
 
 void WBC::generateStandingCycle(ModelMaker &mm) {
@@ -99,6 +129,7 @@ void WBC::generateStandingCycle(ModelMaker &mm) {
                                   designer_.get_RF_name()};
   standingCycle_ = HorizonManager(names, x0_, cyclicModels,
                                   cyclicModels[2 * settings_.Tstep - 1]);
+  horizon_.reserveData(cyclicModels);
 }
 
 void WBC::updateStepCycleTiming() {
@@ -121,44 +152,53 @@ Eigen::VectorXd WBC::iterate(const int &iteration,
                              const Eigen::VectorXd &q_current,
                              const Eigen::VectorXd &v_current,
                              const bool &is_feasible) {
-  x0_ = shapeState(q_current, v_current);
-  if (timeToSolveDDP(iteration)) {
-    // ~~TIMING~~ //
-    updateStepCycleTiming();
-    recedeWithCycle();
-
-    // ~~REFERENCES~~ //
-    designer_.updateReducedModel(x0_);
-    switch (settings_.typeOfCommand) {
-      case StepTracker:
-        updateStepTrackerReferences();
-        break;
-      case NonThinking:
-        updateNonThinkingReferences();
-        break;
-      default:
-        break;
-    }
+  shapeState(q_current, v_current, x0_);
+  if (timeToSolveDDP(iteration)) solveDDP(x0_, is_feasible);
+  return horizon_.currentTorques(x0_);
+}
+
+void WBC::solveDDP(const Eigen::VectorXd &x, const bool &is_feasible) {
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+  // The DDP tick must not allocate.
+  ScopedNoMalloc noMalloc;
+#endif
+  x0_ = x;
+  // ~~TIMING~~ //
+  updateStepCycleTiming();
+  recedeWithCycle();
 
-    // ~~SOLVER~~ //
-    horizon_.solve(x0_, settings_.ddpIteration, is_feasible);
+  // ~~REFERENCES~~ //
+  designer_.updateReducedKinematics(x0_);
+  switch (settings_.typeOfCommand) {
+    case StepTracker:
+      updateStepTrackerReferences();
+      break;
+    case NonThinking:
+      updateNonThinkingReferences();
+      break;
+    default:
+      break;
   }
-  return horizon_.currentTorques(x0_);
+
+  // ~~SOLVER~~ //
+  horizon_.solve(x0_, settings_.ddpIteration, is_feasible);
 }
 
 void WBC::updateStepTrackerReferences() {
-  for (unsigned long time = 0; time < horizon_.size(); time++) {
-    horizon_.setPoseReferenceLF(time, "placement_LF", getPoseRef_LF(time));
-    horizon_.setPoseReferenceRF(time, "placement_RF", getPoseRef_RF(time));
-    ///@todo: the names must be provided by the user
-  }
+  ref_LF_poses_.flush(
+      [this](const std::size_t time, const pinocchio::SE3 &pose) {
+        horizon_.setPoseReferenceLF(time, pose);
+      });
+  ref_RF_poses_.flush(
+      [this](const std::size_t time, const pinocchio::SE3 &pose) {
+        horizon_.setPoseReferenceRF(time, pose);
+      });
 }
 
 void WBC::updateNonThinkingReferences() {
-  for (unsigned long time = 0; time < horizon_.size(); time++) {
-    horizon_.setVelocityRefCOM(time, "comVelocity", ref_com_vel_[time]);
-    ///@todo: the names must be provided by the user
-  }
+  ref_com_vel_.flush([this](const std::size_t time, const eVector3 &velocity) {
+    horizon_.setVelocityRefCOM(time, velocity);
+  });
 }
 
 void WBC::recedeWithCycle() {
@@ -180,31 +220,88 @@ void WBC::recedeWithCycle() {
 }
 
 void WBC::recedeWithCycle(HorizonManager &cycle) {
-  horizon_.recede(cycle.ama(0), cycle.ada(0));
+  horizon_.recede(cycle.ama(0), cycle.handles(0));
   cycle.recede();
+  ref_LF_poses_.recede();
+  ref_RF_poses_.recede();
+  ref_com_vel_.recede();
   return;
 }
 
-Eigen::VectorXd WBC::shapeState(Eigen::VectorXd q, Eigen::VectorXd v) {
-  if (q.size() == designer_.get_rModelComplete().nq &&
-      v.size() == designer_.get_rModelComplete().nv) {
-    x_internal_.head<7>() = q.head<7>();
-    x_internal_.segment<6>(designer_.get_rModel().nq) = v.head<6>();
-
-    int i = 0;
-    for (unsigned long jointID : controlled_joints_id_)
-      if (jointID > 1) {
-        x_internal_(i + 7) = q(jointID + 5);
-        x_internal_(designer_.get_rModel().nq + i + 6) = v(jointID + 4);
-        i++;
-      }
-    return x_internal_;
-  } else if (q.size() == designer_.get_rModel().nq &&
-             v.size() == designer_.get_rModel().nv) {
-    x_internal_ << q, v;
-    return x_internal_;
+void WBC::buildGatherMaps() {
+  const pinocchio::Model &complete = designer_.get_rModelComplete();
+  nq_complete_ = complete.nq;
+  nv_complete_ = complete.nv;
+  nq_reduced_ = designer_.get_rModel().nq;
+  nv_reduced_ = designer_.get_rModel().nv;
+
+  // Extend the last run when the indices follow it.
+  auto appendRun = [](std::vector<IndexRun> &runs, const Eigen::Index reduced,
+                      const Eigen::Index complete, const Eigen::Index size) {
+    if (size == 0) return;
+    if (!runs.empty() && runs.back().reduced + runs.back().size == reduced &&
+        runs.back().complete + runs.back().size == complete) {
+      runs.back().size += size;
+    } else {
+      runs.push_back({reduced, complete, size});
+    }
+  };
+  q_runs_.clear();
+  v_runs_.clear();
+  tau_runs_.clear();
+  // The controlled joints are in the order of the reduced model, the root
+  // joint first.
+  Eigen::Index iq = 0, iv = 0;
+  for (unsigned long jointID : controlled_joints_id_) {
+    const pinocchio::JointModel &joint = complete.joints[jointID];
+    appendRun(q_runs_, iq, joint.idx_q(), joint.nq());
+    appendRun(v_runs_, iv, joint.idx_v(), joint.nv());
+    // The root joint is not actuated.
+    if (jointID > 1)
+      appendRun(tau_runs_, iv - 6, joint.idx_v() - 6, joint.nv());
+    iq += joint.nq();
+    iv += joint.nv();
+  }
+  if (iq != nq_reduced_ || iv != nv_reduced_) {
+    throw std::runtime_error(
+        "The controlled joints do not match the reduced model.");
+  }
+}
+
+const Eigen::VectorXd &WBC::shapeState(const Eigen::VectorXd &q,
+                                       const Eigen::VectorXd &v) {
+  shapeState(q, v, x_internal_);
+  return x_internal_;
+}
+
+void WBC::shapeState(const Eigen::Ref<const Eigen::VectorXd> &q,
+                     const Eigen::Ref<const Eigen::VectorXd> &v,
+                     Eigen::Ref<Eigen::VectorXd> x) {
+  if (x.size() != nq_reduced_ + nv_reduced_) {
+    throw std::runtime_error("x must have the dimension of the reduced state.");
+  }
+  if (q.size() == nq_complete_ && v.size() == nv_complete_) {
+    for (const IndexRun &run : q_runs_)
+      x.segment(run.reduced, run.size) = q.segment(run.complete, run.size);
+    for (const IndexRun &run : v_runs_)
+      x.segment(nq_reduced_ + run.reduced, run.size) =
+          v.segment(run.complete, run.size);
+  } else if (q.size() == nq_reduced_ && v.size() == nv_reduced_) {
+    x.head(nq_reduced_) = q;
+    x.tail(nv_reduced_) = v;
   } else
     throw std::runtime_error(
         "q and v must have the dimentions of the reduced or complete model.");
 }
+
+void WBC::scatterTorques(const Eigen::Ref<const Eigen::VectorXd> &u,
+                         Eigen::Ref<Eigen::VectorXd> tau) {
+  if (u.size() != nv_reduced_ - 6 || tau.size() != nv_complete_ - 6) {
+    throw std::runtime_error(
+        "u and tau must have the dimensions of the reduced and complete "
+        "torques.");
+  }
+  for (const IndexRun &run : tau_runs_)
+    tau.segment(run.complete, run.size) = u.segment(run.reduced, run.size);
+}
 }  // namespace sobec
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Replaces the allocation functions of the process: to be included by a
+ * single translation unit of each test executable.
+ */
+
+#ifndef SOBEC_UNITTEST_ALLOCATION_COUNTER_HPP_
+#define SOBEC_UNITTEST_ALLOCATION_COUNTER_HPP_
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+// Count the heap allocations of the whole process between
+// startCountingAllocations() and stopCountingAllocations(). With glibc, malloc
+// and its variants are replaced by the ones below, which forward to the libc
+// implementation: the allocations done inside crocoddyl, pinocchio, Eigen and
+// the standard library are all counted. Elsewhere, only operator new is
+// hooked, so the allocations done directly with malloc are not seen.
+static std::atomic<bool> counting_allocations(false);
+static std::atomic<std::size_t> allocation_counter(0);
+
+static inline void countAllocation() {
+  if (counting_allocations.load(std::memory_order_relaxed))
+    ++allocation_counter;
+}
+
+void startCountingAllocations() {
+  allocation_counter = 0;
+  counting_allocations = true;
+}
+
+std::size_t stopCountingAllocations() {
+  counting_allocations = false;
+  return allocation_counter;
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(std::size_t size) noexcept {
+  countAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size) noexcept {
+  countAllocation();
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept {
+  countAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment,
+                   std::size_t size) noexcept {
+  countAllocation();
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr == NULL ? ENOMEM : 0;
+}
+
+void free(void* ptr) noexcept { __libc_free(ptr); }
+}
+#else
+void* operator new(std::size_t size) {
+  countAllocation();
+  void* ptr = std::malloc(size);
+  if (ptr == NULL) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+#endif
+
+#endif  // SOBEC_UNITTEST_ALLOCATION_COUNTER_HPP_
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "designer.hpp"
+
+#include <example-robot-data/path.hpp>
+
+namespace sobec {
+namespace unittest {
+
+TalosDesignerFactory::TalosDesignerFactory() {
+  settings_.urdfPath =
+      EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/robots/talos_reduced.urdf";
+  settings_.srdfPath =
+      EXAMPLE_ROBOT_DATA_MODEL_DIR "/talos_data/srdf/talos.srdf";
+  settings_.leftFootName = "left_sole_link";
+  settings_.rightFootName = "right_sole_link";
+  settings_.controlledJointsNames = {
+      "root_joint",        "leg_left_1_joint",  "leg_left_2_joint",
+      "leg_left_3_joint",  "leg_left_4_joint",  "leg_left_5_joint",
+      "leg_left_6_joint",  "leg_right_1_joint", "leg_right_2_joint",
+      "leg_right_3_joint", "leg_right_4_joint", "leg_right_5_joint",
+      "leg_right_6_joint", "torso_1_joint",     "torso_2_joint"};
+}
+
+TalosDesignerFactory::~TalosDesignerFactory() {}
+
+const RobotDesignerSettings& TalosDesignerFactory::get_settings() const {
+  return settings_;
+}
+
+RobotDesigner TalosDesignerFactory::create() const {
+  return RobotDesigner(settings_);
+}
+
+ModelMakerSettings TalosDesignerFactory::create_makerSettings(
+    RobotDesigner& designer) const {
+  ModelMakerSettings settings;
+  const long nv = designer.get_rModel().nv;
+  settings.wStateReg = 100;
+  settings.wControlReg = 0.001;
+  settings.wWrenchCone = 0.05;
+  settings.wFootPlacement = 1000;
+  settings.stateWeights = Eigen::VectorXd::Ones(2 * nv);
+  settings.controlWeights = Eigen::VectorXd::Ones(nv - 6);
+  return settings;
+}
+
+}  // namespace unittest
+}  // namespace sobec
@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOBEC_DESIGNER_FACTORY_HPP_
+#define SOBEC_DESIGNER_FACTORY_HPP_
+
+#include "sobec/designer.hpp"
+#include "sobec/model_factory.hpp"
+
+namespace sobec {
+namespace unittest {
+
+/**
+ * @brief Designer of the legs and torso of Talos (talos_reduced of
+ * example-robot-data), with the weights of the nodes built on it by
+ * ModelMaker.
+ */
+class TalosDesignerFactory {
+ public:
+  TalosDesignerFactory();
+  ~TalosDesignerFactory();
+
+  const RobotDesignerSettings& get_settings() const;
+  RobotDesigner create() const;
+  ModelMakerSettings create_makerSettings(RobotDesigner& designer) const;
+
+ private:
+  RobotDesignerSettings settings_;
+};
+
+}  // namespace unittest
+}  // namespace sobec
+
+#endif  // SOBEC_DESIGNER_FACTORY_HPP_
@@ -0,0 +1,51 @@
+"""
+Walking problem used by the C++ tests of MPCWalk (loaded with initMPCWalk).
+
+Same OCP as benchmark/mpc_description.py, on shorter timings: each node of the
+gait cycle has its own contacts and costs (double support, left and right
+single supports, impacts), while keeping the loading time of the tests low.
+The MPC is initialized but calc is never called, so that the tests start from
+the state of a fresh MPC.
+"""
+
+import example_robot_data as robex
+
+import sobec
+from sobec.walk.robot_wrapper import RobotWrapper
+from sobec.walk import ocp
+from sobec.walk.config_mpc import configureMPCWalk
+from sobec.walk.params import WalkParams
+
+urdf = robex.load("talos_legs")
+urdf.model.name = "talos"
+robot = RobotWrapper(urdf.model, contactKey="sole_link")
+
+walkParams = WalkParams(robot.name)
+walkParams.Tstart = 5
+walkParams.Tdouble = 3
+walkParams.Tsingle = 15
+walkParams.Tend = 5
+# Shorter than the gait cycle 2 * (Tsingle + Tdouble).
+walkParams.Tmpc = 30
+maxiter = 20
+
+contactPattern = (
+    []
+    + [[1, 1]] * walkParams.Tstart
+    + [[1, 1]] * walkParams.Tdouble
+    + [[0, 1]] * walkParams.Tsingle
+    + [[1, 1]] * walkParams.Tdouble
+    + [[1, 0]] * walkParams.Tsingle
+    + [[1, 1]] * walkParams.Tdouble
+    + [[1, 1]] * walkParams.Tend
+    + [[1, 1]]
+)
+
+ddp = ocp.buildSolver(robot, contactPattern, walkParams)
+problem = ddp.problem
+x0s, u0s = ocp.buildInitialGuess(ddp.problem, walkParams)
+ddp.solve(x0s, u0s, maxiter)
+
+mpc = sobec.MPCWalk(ddp.problem)
+configureMPCWalk(mpc, walkParams)
+mpc.initialize(ddp.xs[: walkParams.Tmpc + 1], ddp.us[: walkParams.Tmpc])
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE cost stack
+#include <boost/test/included/unit_test.hpp>
+#include <crocoddyl/core/costs/residual.hpp>
+#include <crocoddyl/multibody/residuals/com-position.hpp>
+#include <crocoddyl/multibody/residuals/frame-placement.hpp>
+#include <crocoddyl/multibody/residuals/frame-translation.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "factory/pinocchio_model.hpp"
+#include "sobec/cost-stack.hpp"
+
+BOOST_AUTO_TEST_CASE(test_cost_stack_report) {
+  sobec::unittest::PinocchioModelFactory factory(
+      sobec::unittest::PinocchioModelTypes::RandomHumanoid);
+  const boost::shared_ptr<crocoddyl::StateMultibody> state =
+      boost::make_shared<crocoddyl::StateMultibody>(factory.create());
+  const std::size_t nu = state->get_nv() - 6;
+  const pinocchio::FrameIndex frame = factory.get_frame_id();
+  const pinocchio::FrameIndex other = frame > 1 ? frame - 1 : frame + 1;
+
+  crocoddyl::CostModelSum costs(state, nu);
+  costs.addCost(
+      "placement",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state, boost::make_shared<crocoddyl::ResidualModelFramePlacement>(
+                     state, frame, pinocchio::SE3::Identity(), nu)),
+      1.);
+  costs.addCost(
+      "translation",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state, boost::make_shared<crocoddyl::ResidualModelFrameTranslation>(
+                     state, frame, Eigen::Vector3d::Zero(), nu)),
+      1.);
+  costs.addCost(
+      "unweighted",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state, boost::make_shared<crocoddyl::ResidualModelFramePlacement>(
+                     state, other, pinocchio::SE3::Identity(), nu)),
+      0.);
+  costs.addCost(
+      "com",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state, boost::make_shared<crocoddyl::ResidualModelCoMPosition>(
+                     state, Eigen::Vector3d::Zero(), nu)),
+      1.);
+
+  // The zero-weight cost is deactivated, and is not a reader of the placement
+  // of its frame. The two costs on the placement of the same frame are
+  // reported, the CoM that only one cost reads is not.
+  const sobec::CostStackReport report = sobec::compileCostStack(costs);
+  BOOST_CHECK(report.deactivated == std::vector<std::string>({"unweighted"}));
+  BOOST_CHECK(!costs.get_costs().at("unweighted")->active);
+  BOOST_REQUIRE(report.sharedQuantities.size() == 1);
+  std::ostringstream quantity;
+  quantity << "placement of frame " << frame;
+  BOOST_REQUIRE(report.sharedQuantities.count(quantity.str()) == 1);
+  BOOST_CHECK(report.sharedQuantities.at(quantity.str()) ==
+              std::vector<std::string>({"placement", "translation"}));
+
+  std::ostringstream printed;
+  printed << report;
+  BOOST_CHECK(printed.str().find("Deactivated: unweighted") !=
+              std::string::npos);
+
+  // A cost given a weight again is active, and compiling the stack again
+  // reports nothing new to deactivate.
+  sobec::setCostWeight(costs, "unweighted", 2.);
+  BOOST_CHECK(costs.get_costs().at("unweighted")->active);
+  BOOST_CHECK(sobec::compileCostStack(costs).deactivated.empty());
+}
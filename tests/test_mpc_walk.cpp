@@ -0,0 +1,409 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE mpc walk
+#include <algorithm>
+#include <boost/test/included/unit_test.hpp>
+#include <boost/weak_ptr.hpp>
+#include <chrono>
+#include <cmath>
+#include <crocoddyl/core/actions/unicycle.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/solvers/fddp.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <thread>
+
+#include "allocation_counter.hpp"
+#include "sobec/mpc-walk-async.hpp"
+#include "sobec/mpc-walk.hpp"
+#include "sobec/py2cpp.hpp"
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_calc_does_not_allocate) {
+  // A walking problem, so that the ticks go through the single and double
+  // supports, with their different contacts and costs.
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/mpc_walk_gait.py");
+  mpc->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+  const int Tcycle = 2 * (mpc->Tsingle + mpc->Tdouble);
+
+  Eigen::VectorXd x = mpc->solver->get_xs()[1];
+
+  startCountingAllocations();
+  for (int t = 1; t <= 2 * Tcycle; ++t) {
+    mpc->calc(x, t);
+    x = mpc->solver->get_xs()[1];
+  }
+  const std::size_t allocations = stopCountingAllocations();
+
+  std::cout << "Allocations during MPC ticks: " << allocations << std::endl;
+  BOOST_CHECK(allocations == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_policy) {
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/test_mpc_walk.py");
+  mpc->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+  mpc->DT = 0.1;
+  mpc->solver_maxiter = 2;
+
+  Eigen::VectorXd x = mpc->solver->get_xs()[1];
+  mpc->calc(x, 11);
+  const std::vector<Eigen::VectorXd>& xs = mpc->solver->get_xs();
+  const std::vector<Eigen::VectorXd>& us = mpc->solver->get_us();
+  sobec::FeedbackPolicy& policy = mpc->policy;
+  const int n = policy.get_nsubsteps();
+  BOOST_CHECK(n == mpc->policySubsteps);
+
+  // On the optimal trajectory, the policy gives the feed-forward.
+  Eigen::VectorXd u(us[0].size());
+  policy.calc(0, xs[0], u);
+  BOOST_CHECK((u - us[0]).isZero(1e-9));
+  policy.calc(n, xs[1], u);
+  BOOST_CHECK((u - us[1]).isZero(1e-9));
+
+  // The feedback corrects a perturbation of the state.
+  Eigen::VectorXd dx = Eigen::VectorXd::Zero(mpc->state->get_ndx());
+  dx[0] = 1e-3;
+  Eigen::VectorXd xp(xs[0].size());
+  mpc->state->integrate(xs[0], dx, xp);
+  policy.calc(0, xp, u);
+  BOOST_CHECK((u - (us[0] - mpc->solver->get_K()[0] * dx)).isZero(1e-9));
+
+  // Evaluating the policy at each sub-step does not allocate.
+  startCountingAllocations();
+  for (int k = 0; k < n; ++k) policy.calc(k, xp, u);
+  BOOST_CHECK(stopCountingAllocations() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_profiler) {
+  sobec::LatencyHistogram histogram;
+  for (int i = 1; i <= 100; ++i) histogram.record(i * 1e-6);
+  BOOST_CHECK(histogram.get_count() == 100);
+  BOOST_CHECK(std::abs(histogram.getPercentile(50) - 50e-6) <= 2e-6);
+  BOOST_CHECK(std::abs(histogram.getPercentile(99) - 99e-6) <= 3e-6);
+  BOOST_CHECK(std::abs(histogram.get_max() - 100e-6) <= 1e-8);
+
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/test_mpc_walk.py");
+  mpc->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+  mpc->DT = 0.1;
+  mpc->solver_maxiter = 2;
+  typedef sobec::TickProfiler Profiler;
+
+  // Nothing is recorded while the profiler is disabled.
+  Eigen::VectorXd x = mpc->solver->get_xs()[1];
+  mpc->calc(x, 11);
+  for (int i = 0; i < Profiler::NB_PHASES; ++i) {
+    BOOST_CHECK(mpc->profiler.get_histogram(Profiler::Phase(i)).get_count() ==
+                0);
+  }
+
+  // Once enabled, each phase is recorded, without allocating.
+  mpc->profiler.enabled = true;
+  const int nticks = 20;
+  startCountingAllocations();
+  for (int t = 12; t < 12 + nticks; ++t) {
+    x = mpc->solver->get_xs()[1];
+    mpc->calc(x, t);
+  }
+  BOOST_CHECK(stopCountingAllocations() == 0);
+
+  const sobec::LatencyHistogram& tick =
+      mpc->profiler.get_histogram(Profiler::TICK);
+  BOOST_CHECK(tick.get_count() == nticks);
+  BOOST_CHECK(mpc->profiler.get_histogram(Profiler::RECEDE).get_count() ==
+              nticks);
+  BOOST_CHECK(mpc->profiler.get_histogram(Profiler::SOLVE).get_count() ==
+              nticks);
+  BOOST_CHECK(
+      mpc->profiler.get_histogram(Profiler::BACKWARD_PASS).get_count() >=
+      nticks);
+  BOOST_CHECK(mpc->profiler.get_histogram(Profiler::FORWARD_PASS).get_count() >
+              0);
+  BOOST_CHECK(tick.getPercentile(50) <= tick.getPercentile(99));
+  BOOST_CHECK(tick.getPercentile(99) <= tick.get_max());
+  BOOST_CHECK(mpc->profiler.get_histogram(Profiler::SOLVE).get_max() <=
+              tick.get_max());
+  std::cout << mpc->profiler;
+
+  mpc->profiler.reset();
+  BOOST_CHECK(tick.get_count() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_deadline) {
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/test_mpc_walk.py");
+  mpc->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+  mpc->DT = 0.1;
+  mpc->solver_maxiter = 10;
+  // Never converge, so that only maxiter and the deadline stop the solver.
+  mpc->solver->set_th_stop(0.);
+
+  Eigen::VectorXd x = mpc->solver->get_xs()[1];
+
+  // A generous budget lets the solver reach maxiter.
+  mpc->solver_deadline = 10.;
+  mpc->calc(x, 11);
+  BOOST_CHECK(!mpc->get_deadlineHit());
+  BOOST_CHECK(mpc->get_iterations() == mpc->solver_maxiter);
+  BOOST_CHECK(mpc->get_iterationTime() > 0.);
+  x = mpc->solver->get_xs()[1];
+
+  // A budget shorter than one iteration: only the first one is done.
+  mpc->solver_deadline = 1e-9;
+  mpc->calc(x, 12);
+  BOOST_CHECK(mpc->get_iterations() == 1);
+  BOOST_CHECK(mpc->get_deadlineHit());
+}
+
+BOOST_AUTO_TEST_CASE(test_deadline_infeasible_iterate) {
+  const std::size_t T = 20;
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> model =
+      boost::make_shared<crocoddyl::ActionModelUnicycle>();
+  boost::shared_ptr<crocoddyl::ShootingProblem> problem =
+      boost::make_shared<crocoddyl::ShootingProblem>(
+          Eigen::VectorXd::Random(3),
+          std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> >(
+              T, model),
+          model);
+  sobec::TickProfiler profiler;
+  sobec::SolverFDDPProfiled solver(problem, profiler);
+  // Half steps from a guess with gaps: the iterates keep gaps.
+  solver.set_alphas(std::vector<double>(1, 0.5));
+  solver.set_th_stop(0.);
+  const std::vector<Eigen::VectorXd> xs(T + 1, Eigen::VectorXd::Random(3));
+  const std::vector<Eigen::VectorXd> us(T, Eigen::VectorXd::Zero(2));
+
+  // Without deadline, the last iterate has gaps.
+  solver.prepareSolve(false);
+  solver.solve(xs, us, 3);
+  BOOST_CHECK(!solver.get_is_feasible());
+  BOOST_CHECK(solver.get_iter() == 3);
+
+  // A deadline already passed stops the solve after one iteration, which
+  // returns the feasible rollout of its controls.
+  solver.prepareSolve(true, sobec::TickProfiler::Clock::now());
+  solver.solve(xs, us, 10);
+  BOOST_CHECK(solver.get_deadlineHit());
+  BOOST_CHECK(solver.get_nbIterations() == 1);
+  BOOST_CHECK(solver.get_iter() == 1);
+  BOOST_CHECK(solver.get_is_feasible());
+  std::vector<Eigen::VectorXd> rollout(T + 1, Eigen::VectorXd::Zero(3));
+  problem->rollout(solver.get_us(), rollout);
+  for (std::size_t t = 0; t <= T; ++t)
+    BOOST_CHECK(solver.get_xs()[t].isApprox(rollout[t]));
+  BOOST_CHECK(std::abs(solver.get_cost() -
+                       problem->calc(solver.get_xs(), solver.get_us())) <
+              1e-9);
+}
+
+// Build a new MPC on the storage of the given one, with the same settings.
+// It still needs to be initialized.
+sobec::MPCWalkPtr cloneMPCWalk(const sobec::MPCWalkPtr& mpc) {
+  sobec::MPCWalkPtr clone = boost::make_shared<sobec::MPCWalk>(mpc->storage);
+  clone->Tmpc = mpc->Tmpc;
+  clone->Tstart = mpc->Tstart;
+  clone->Tdouble = mpc->Tdouble;
+  clone->Tsingle = mpc->Tsingle;
+  clone->Tend = mpc->Tend;
+  clone->vcomRef = mpc->vcomRef;
+  clone->DT = mpc->DT;
+  clone->solver_reg_min = mpc->solver_reg_min;
+  clone->solver_maxiter = mpc->solver_maxiter;
+  return clone;
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_compact_storage) {
+  // Each node of the gait cycle has its own contacts and costs, so that
+  // scheduling a wrong node changes the solution.
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/mpc_walk_gait.py");
+  mpc->solver_maxiter = 2;
+
+  sobec::MPCWalkPtr full = cloneMPCWalk(mpc);
+  full->initialize(mpc->solver->get_xs(), mpc->solver->get_us());
+  sobec::MPCWalkPtr compact = cloneMPCWalk(mpc);
+  compact->compactStorage = true;
+  compact->initialize(mpc->solver->get_xs(), mpc->solver->get_us());
+  const int Tcycle = 2 * (mpc->Tsingle + mpc->Tdouble);
+  BOOST_REQUIRE(compact->storage->get_T() ==
+                static_cast<std::size_t>(mpc->Tstart + 1 + Tcycle));
+  BOOST_REQUIRE(compact->storage->get_T() < mpc->storage->get_T());
+  BOOST_CHECK(compact->storage->get_runningModels()[mpc->Tstart] ==
+              mpc->storage->get_runningModels()[mpc->Tstart]);
+
+  // The MPCs share the storage nodes, but not their datas.
+  const std::vector<boost::shared_ptr<crocoddyl::ActionDataAbstract> >&
+      storageDatas = mpc->storage->get_runningDatas();
+  for (int i = 0; i < mpc->Tmpc; ++i) {
+    const boost::shared_ptr<crocoddyl::ActionDataAbstract>& data =
+        full->problem->get_runningDatas()[i];
+    BOOST_CHECK(data != compact->problem->get_runningDatas()[i]);
+    BOOST_CHECK(data != mpc->problem->get_runningDatas()[i]);
+    BOOST_CHECK(std::find(storageDatas.begin(), storageDatas.end(), data) ==
+                storageDatas.end());
+  }
+  BOOST_CHECK(full->problem->get_terminalData() !=
+              compact->problem->get_terminalData());
+  BOOST_CHECK(full->problem->get_terminalData() !=
+              mpc->storage->get_terminalData());
+
+  // The compact storage does not keep the datas of the storage: its nodes
+  // share a placeholder.
+  const std::vector<boost::shared_ptr<crocoddyl::ActionDataAbstract> >&
+      placeholders = compact->storage->get_runningDatas();
+  BOOST_CHECK(std::count(placeholders.begin(), placeholders.end(),
+                         placeholders[0]) ==
+              static_cast<std::ptrdiff_t>(placeholders.size()));
+  BOOST_CHECK(std::find(storageDatas.begin(), storageDatas.end(),
+                        placeholders[0]) == storageDatas.end());
+
+  // Both MPC schedule the same nodes, hence compute the same solutions.
+  std::vector<boost::weak_ptr<crocoddyl::ActionDataAbstract> > compactDatas(
+      compact->problem->get_runningDatas().begin(),
+      compact->problem->get_runningDatas().end());
+  int recycled = 0;
+  Eigen::VectorXd x = full->solver->get_xs()[1];
+  for (int t = 1; t <= 2 * Tcycle; ++t) {
+    full->calc(x, t);
+    const boost::shared_ptr<crocoddyl::ActionDataAbstract> leaving =
+        compact->problem->get_runningDatas()[0];
+    compact->calc(x, t);
+    compactDatas.push_back(compact->problem->get_runningDatas().back());
+    if (compactDatas.back().lock() == leaving) ++recycled;
+    for (int i = 0; i < mpc->Tmpc; ++i) {
+      BOOST_CHECK(full->problem->get_runningModels()[i] ==
+                  compact->problem->get_runningModels()[i]);
+    }
+    BOOST_CHECK((full->solver->get_us()[0] - compact->solver->get_us()[0])
+                    .isZero(1e-9));
+    x = full->solver->get_xs()[1];
+  }
+
+  // The compact MPC only holds the datas of its horizon and its terminal
+  // data: the datas leaving the horizon are recycled or released.
+  BOOST_CHECK(recycled > 0);
+  std::set<crocoddyl::ActionDataAbstract*> live;
+  for (std::size_t k = 0; k < compactDatas.size(); ++k) {
+    if (!compactDatas[k].expired()) live.insert(compactDatas[k].lock().get());
+  }
+  BOOST_CHECK(live.size() == static_cast<std::size_t>(mpc->Tmpc));
+  for (int i = 0; i < mpc->Tmpc; ++i) {
+    BOOST_CHECK(live.count(compact->problem->get_runningDatas()[i].get()) ==
+                1);
+  }
+  BOOST_CHECK(compact->problem->get_terminalData() !=
+              compact->storage->get_terminalData());
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_coarse_nodes) {
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/test_mpc_walk.py");
+  mpc->DT = 0.1;
+  mpc->solver_maxiter = 2;
+
+  // 5 nodes of DT, then 7 nodes of 2*DT: as long as the 19 first nodes of
+  // the storage.
+  sobec::MPCWalkPtr coarse = cloneMPCWalk(mpc);
+  coarse->Tmpc = 12;
+  coarse->Tfine = 5;
+  coarse->coarseStride = 2;
+  BOOST_CHECK(coarse->get_horizonTicks() == 19);
+  // The guess is given at the storage resolution and sampled by initialize.
+  const std::vector<Eigen::VectorXd>& xs = mpc->solver->get_xs();
+  const std::vector<Eigen::VectorXd>& us = mpc->solver->get_us();
+  coarse->initialize(std::vector<Eigen::VectorXd>(xs.begin(), xs.begin() + 20),
+                     std::vector<Eigen::VectorXd>(us.begin(), us.begin() + 19));
+  coarse->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+
+  Eigen::VectorXd x = coarse->solver->get_xs()[1];
+  startCountingAllocations();
+  for (int t = 11; t < 60; ++t) {
+    coarse->calc(x, t);
+    x = coarse->solver->get_xs()[1];
+  }
+  BOOST_CHECK(stopCountingAllocations() == 0);
+
+  // The coarse nodes integrate the storage nodes over twice their duration.
+  const double dt =
+      boost::static_pointer_cast<crocoddyl::IntegratedActionModelEuler>(
+          mpc->storage->get_runningModels()[0])
+          ->get_dt();
+  for (int i = 0; i < coarse->Tmpc; ++i) {
+    boost::shared_ptr<crocoddyl::IntegratedActionModelEuler> iam =
+        boost::static_pointer_cast<crocoddyl::IntegratedActionModelEuler>(
+            coarse->problem->get_runningModels()[i]);
+    BOOST_CHECK(iam->get_dt() == (i < coarse->Tfine ? dt : 2 * dt));
+  }
+}
+
+// Wait until the worker has completed n solves (or failed), without relying
+// on the duration of a solve.
+bool waitForSolves(const sobec::MPCWalkAsync& async, const std::size_t n) {
+  const std::chrono::steady_clock::time_point timeout =
+      std::chrono::steady_clock::now() + std::chrono::seconds(60);
+  for (;;) {
+    const sobec::MPCWalkAsyncStatistics stats = async.get_statistics();
+    if (stats.solves + stats.failed >= n) return true;
+    if (std::chrono::steady_clock::now() > timeout) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpc_walk_async) {
+  sobec::MPCWalkPtr mpc =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/test_mpc_walk.py");
+  mpc->solver->setCallbacks(
+      std::vector<boost::shared_ptr<crocoddyl::CallbackAbstract> >());
+  mpc->DT = 0.1;
+  mpc->solver_maxiter = 2;
+
+  const long nu = mpc->solver->get_us()[0].size();
+  const long ndx = mpc->state->get_ndx();
+  Eigen::VectorXd x = mpc->solver->get_xs()[1];
+
+  sobec::MPCWalkAsync async(mpc);
+  sobec::MPCWalkPolicySnapshot policy;
+  BOOST_CHECK(!async.getPolicy(policy));
+
+  // Each state is posted once the previous one is solved: none is missed and
+  // each policy is the one of the last posted tick.
+  async.start();
+  const int nticks = 20;
+  for (int i = 1; i <= nticks; ++i) {
+    const int t = 10 + i;
+    async.setState(x, t);
+    BOOST_REQUIRE(waitForSolves(async, static_cast<std::size_t>(i)));
+    BOOST_REQUIRE(async.getPolicy(policy));
+    BOOST_CHECK(policy.t == t);
+    x = policy.xs0;
+  }
+  async.stop();
+  BOOST_CHECK(!async.isRunning());
+
+  BOOST_CHECK(async.getPolicy(policy));
+  BOOST_CHECK(policy.us0.size() == nu);
+  BOOST_CHECK(policy.K0.rows() == nu && policy.K0.cols() == ndx);
+  BOOST_CHECK(policy.t == 10 + nticks);
+
+  const sobec::MPCWalkAsyncStatistics stats = async.get_statistics();
+  std::cout << "Async MPC: " << stats.solves << " solves, " << stats.missed
+            << " missed, mean age " << stats.meanAge << "s, max age "
+            << stats.maxAge << "s" << std::endl;
+  BOOST_CHECK(stats.requests == static_cast<std::size_t>(nticks));
+  BOOST_CHECK(stats.failed == 0);
+  BOOST_CHECK(stats.missed == 0);
+  BOOST_CHECK(stats.solves == stats.requests);
+}
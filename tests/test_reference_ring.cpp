@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE reference ring
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <vector>
+
+#include "sobec/reference-ring.hpp"
+
+namespace {
+
+// Nodes visited by flush, with the reference given for each.
+std::map<std::size_t, double> flush(sobec::ReferenceRing<double>& ring) {
+  std::map<std::size_t, double> visited;
+  ring.flush([&visited](const std::size_t time, const double value) {
+    BOOST_CHECK(visited.count(time) == 0);
+    visited[time] = value;
+  });
+  BOOST_CHECK(ring.nbDirty() == 0);
+  return visited;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_reference_ring_dirty_nodes) {
+  sobec::ReferenceRing<double> ring;
+  ring.initialize(5, 0.);
+  BOOST_CHECK(ring.nbDirty() == 5);
+  BOOST_CHECK(flush(ring).size() == 5);
+  BOOST_CHECK(flush(ring).empty());
+
+  // Only the nodes that are set are written, once each.
+  ring.set(1, 1.);
+  ring.set(3, 2.);
+  ring.set(1, 3.);
+  std::map<std::size_t, double> visited = flush(ring);
+  BOOST_CHECK(visited.size() == 2);
+  BOOST_CHECK(visited[1] == 3.);
+  BOOST_CHECK(visited[3] == 2.);
+}
+
+BOOST_AUTO_TEST_CASE(test_reference_ring_recede) {
+  sobec::ReferenceRing<double> ring;
+  ring.initialize(5, 0.);
+  ring.set(std::vector<double>{0., 1., 2., 3., 4.});
+  flush(ring);
+
+  // Each recede only writes the appended node, which takes the reference of
+  // the previous last node.
+  for (int i = 0; i < 3; ++i) ring.recede();
+  BOOST_CHECK(ring.toVector() == std::vector<double>({3., 4., 4., 4., 4.}));
+  std::map<std::size_t, double> visited = flush(ring);
+  BOOST_CHECK(visited.size() == 3);
+  for (std::size_t time = 2; time < 5; ++time) BOOST_CHECK(visited[time] == 4.);
+
+  // A node set before receding is written at its new time.
+  ring.set(2, 7.);
+  ring.recede();
+  visited = flush(ring);
+  BOOST_CHECK(visited.size() == 2);
+  BOOST_CHECK(visited[1] == 7.);
+  BOOST_CHECK(visited[4] == 4.);
+
+  // The references stay right after many recedes (the head wraps around).
+  ring.set(std::vector<double>{10., 11., 12., 13., 14.});
+  for (int i = 0; i < 7; ++i) {
+    ring.recede();
+    ring.set(4, 15. + i);
+  }
+  BOOST_CHECK(ring.toVector() ==
+              std::vector<double>({17., 18., 19., 20., 21.}));
+  visited = flush(ring);
+  BOOST_CHECK(visited.size() == 5);
+  for (std::size_t time = 0; time < 5; ++time)
+    BOOST_CHECK(visited[time] == ring[time]);
+}
+
+BOOST_AUTO_TEST_CASE(test_reference_ring_resize) {
+  sobec::ReferenceRing<double> ring;
+  ring.initialize(3, 0.);
+  ring.set(std::vector<double>{1., 2., 3.});
+  ring.recede();
+  flush(ring);
+
+  // The first nodes keep their reference, the new ones take the last one.
+  ring.resize(5, 0.);
+  BOOST_CHECK(ring.toVector() == std::vector<double>({2., 3., 3., 3., 3.}));
+  BOOST_CHECK(flush(ring).size() == 5);
+  ring.resize(2, 0.);
+  BOOST_CHECK(ring.toVector() == std::vector<double>({2., 3.}));
+  BOOST_CHECK(flush(ring).size() == 2);
+}
@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE serialization
+#include <boost/test/included/unit_test.hpp>
+#include <crocoddyl/core/costs/residual.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <crocoddyl/multibody/residuals/state.hpp>
+#include <crocoddyl/multibody/states/multibody.hpp>
+#include <cstdio>
+#include <sstream>
+
+#include "factory/diff-action.hpp"
+#include "factory/lpf.hpp"
+#include "sobec/activation-quad-ref.hpp"
+#include "sobec/py2cpp.hpp"
+#include "sobec/residual-vel-collision.hpp"
+#include "sobec/serialization.hpp"
+
+using namespace sobec::unittest;
+
+namespace {
+
+boost::shared_ptr<pinocchio::Model> getModel(
+    const crocoddyl::ShootingProblem &problem) {
+  boost::shared_ptr<crocoddyl::StateAbstract> state =
+      problem.get_terminalModel()->get_state();
+  boost::shared_ptr<sobec::IntegratedActionModelLPF> lpf =
+      boost::dynamic_pointer_cast<sobec::IntegratedActionModelLPF>(
+          problem.get_terminalModel());
+  if (lpf) state = lpf->get_differential()->get_state();
+  return boost::static_pointer_cast<crocoddyl::StateMultibody>(state)
+      ->get_pinocchio();
+}
+
+// Both problems must give the same cost and dynamics on random inputs.
+void checkSameProblem(const crocoddyl::ShootingProblem &p1,
+                      const crocoddyl::ShootingProblem &p2) {
+  BOOST_CHECK(p1.get_T() == p2.get_T());
+  BOOST_CHECK((p1.get_x0() - p2.get_x0()).isZero());
+  for (std::size_t t = 0; t <= p1.get_T(); ++t) {
+    const bool terminal = t == p1.get_T();
+    const boost::shared_ptr<crocoddyl::ActionModelAbstract> &m1 =
+        terminal ? p1.get_terminalModel() : p1.get_runningModels()[t];
+    const boost::shared_ptr<crocoddyl::ActionModelAbstract> &m2 =
+        terminal ? p2.get_terminalModel() : p2.get_runningModels()[t];
+    BOOST_REQUIRE(m1->get_nu() == m2->get_nu());
+    BOOST_REQUIRE(m1->get_nr() == m2->get_nr());
+
+    boost::shared_ptr<crocoddyl::ActionDataAbstract> d1 = m1->createData();
+    boost::shared_ptr<crocoddyl::ActionDataAbstract> d2 = m2->createData();
+    const Eigen::VectorXd x = m1->get_state()->rand();
+    const Eigen::VectorXd u = Eigen::VectorXd::Random(m1->get_nu());
+    m1->calc(d1, x, u);
+    m2->calc(d2, x, u);
+    BOOST_CHECK(std::abs(d1->cost - d2->cost) <=
+                1e-9 * (1 + std::abs(d1->cost)));
+    BOOST_CHECK((d1->xnext - d2->xnext).isZero(1e-9));
+    m1->calcDiff(d1, x, u);
+    m2->calcDiff(d2, x, u);
+    BOOST_CHECK((d1->Lx - d2->Lx).isZero(1e-9 * (1 + d1->Lx.norm())));
+    BOOST_CHECK((d1->Fx - d2->Fx).isZero(1e-9 * (1 + d1->Fx.norm())));
+  }
+}
+
+// Save the problem in memory, load it back and compare both.
+void checkRoundtrip(const crocoddyl::ShootingProblem &problem) {
+  const std::vector<Eigen::VectorXd> xs(problem.get_T() + 1,
+                                        problem.get_x0());
+  std::vector<Eigen::VectorXd> us;
+  for (const auto &m : problem.get_runningModels())
+    us.push_back(Eigen::VectorXd::Random(m->get_nu()));
+
+  std::ostringstream os;
+  sobec::saveShootingProblem(os, problem, xs, us);
+  const std::string buffer = os.str();
+  sobec::ShootingProblemSnapshot snapshot = sobec::loadShootingProblem(
+      buffer.data(), buffer.size(), getModel(problem));
+  checkSameProblem(problem, *snapshot.problem);
+  BOOST_CHECK(snapshot.xs.size() == xs.size());
+  BOOST_CHECK(snapshot.us.size() == us.size());
+}
+
+// Sobec contact dynamics of HyQ (3D or 1D contacts) from the unittest
+// factory, with an additional state cost using ActivationModelQuadRef.
+boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract>
+createSobecDifferential(const DifferentialActionModelTypes::Type type,
+                        const PinocchioReferenceTypes::Type ref_type) {
+  boost::shared_ptr<crocoddyl::DifferentialActionModelContactFwdDynamics> dam =
+      boost::static_pointer_cast<
+          crocoddyl::DifferentialActionModelContactFwdDynamics>(
+          DifferentialActionModelFactory().create(type, ref_type,
+                                                  ContactModelMaskTypes::Z));
+  boost::shared_ptr<crocoddyl::StateMultibody> state =
+      boost::static_pointer_cast<crocoddyl::StateMultibody>(dam->get_state());
+  dam->get_costs()->addCost(
+      "stateRef",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state,
+          boost::make_shared<sobec::ActivationModelQuadRef>(
+              Eigen::VectorXd::Random(state->get_ndx())),
+          boost::make_shared<crocoddyl::ResidualModelState>(state,
+                                                            dam->get_nu())),
+      0.1);
+  // Build the model again so that its dimensions account for the new cost.
+  return boost::make_shared<sobec::DifferentialActionModelContactFwdDynamics>(
+      state, dam->get_actuation(), dam->get_contacts(), dam->get_costs(), 0.,
+      true);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_serialization_sobec_contacts) {
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> contact3d =
+      boost::make_shared<crocoddyl::IntegratedActionModelEuler>(
+          createSobecDifferential(
+              DifferentialActionModelTypes::
+                  DifferentialActionModelContact3DFwdDynamics_HyQ,
+              PinocchioReferenceTypes::LOCAL),
+          1e-2);
+  boost::shared_ptr<crocoddyl::DifferentialActionModelAbstract> dam1d =
+      createSobecDifferential(
+          DifferentialActionModelTypes::
+              DifferentialActionModelContact1DFwdDynamics_HyQ,
+          PinocchioReferenceTypes::LOCAL_WORLD_ALIGNED);
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> contact1d =
+      boost::make_shared<crocoddyl::IntegratedActionModelEuler>(dam1d, 1e-2);
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> terminal =
+      boost::make_shared<crocoddyl::IntegratedActionModelEuler>(dam1d, 0.);
+
+  std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> > running;
+  running.push_back(contact3d);
+  running.push_back(contact3d);
+  running.push_back(contact1d);
+  running.push_back(contact1d);
+  crocoddyl::ShootingProblem problem(contact3d->get_state()->zero(), running,
+                                     terminal);
+  checkRoundtrip(problem);
+}
+
+BOOST_AUTO_TEST_CASE(test_serialization_lpf) {
+  std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> > running;
+  for (std::size_t t = 0; t < 3; ++t) {
+    running.push_back(ActionModelLPFFactory().create(
+        ActionModelLPFTypes::IntegratedActionModelLPF,
+        DifferentialActionModelTypes::
+            DifferentialActionModelContact3DFwdDynamics_HyQ));
+  }
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> terminal =
+      ActionModelLPFFactory().create(
+          ActionModelLPFTypes::IntegratedActionModelLPF,
+          DifferentialActionModelTypes::
+              DifferentialActionModelContact1DFwdDynamics_HyQ);
+  crocoddyl::ShootingProblem problem(running[0]->get_state()->zero(), running,
+                                     terminal);
+  checkRoundtrip(problem);
+}
+
+#ifdef PINOCCHIO_WITH_HPP_FCL
+BOOST_AUTO_TEST_CASE(test_serialization_vel_collision_unsupported) {
+  boost::shared_ptr<crocoddyl::DifferentialActionModelContactFwdDynamics> dam =
+      boost::static_pointer_cast<
+          crocoddyl::DifferentialActionModelContactFwdDynamics>(
+          createSobecDifferential(
+              DifferentialActionModelTypes::
+                  DifferentialActionModelContact3DFwdDynamics_HyQ,
+              PinocchioReferenceTypes::LOCAL));
+  boost::shared_ptr<crocoddyl::StateMultibody> state =
+      boost::static_pointer_cast<crocoddyl::StateMultibody>(dam->get_state());
+  dam->get_costs()->addCost(
+      "collision",
+      boost::make_shared<crocoddyl::CostModelResidual>(
+          state, boost::make_shared<sobec::ResidualModelVelCollision>(
+                     state, dam->get_nu(),
+                     boost::make_shared<pinocchio::GeometryModel>(), 0,
+                     state->get_pinocchio()->getFrameId("lf_foot"),
+                     pinocchio::LOCAL, 0.1)),
+      1.);
+  boost::shared_ptr<crocoddyl::ActionModelAbstract> model =
+      boost::make_shared<crocoddyl::IntegratedActionModelEuler>(dam, 1e-2);
+  crocoddyl::ShootingProblem problem(
+      model->get_state()->zero(),
+      std::vector<boost::shared_ptr<crocoddyl::ActionModelAbstract> >(2,
+                                                                      model),
+      model);
+
+  std::ostringstream os;
+  BOOST_CHECK_THROW(
+      sobec::saveShootingProblem(
+          os, problem,
+          std::vector<Eigen::VectorXd>(3, problem.get_x0()),
+          std::vector<Eigen::VectorXd>(2, Eigen::VectorXd::Zero(
+                                              model->get_nu()))),
+      crocoddyl::Exception);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_serialization_roundtrip) {
+  boost::shared_ptr<crocoddyl::ShootingProblem> problem =
+      sobec::initShootingProblem(PROJECT_SOURCE_DIR
+                                 "/tests/python/test_walk.py");
+  const std::vector<Eigen::VectorXd> xs(problem->get_T() + 1,
+                                        problem->get_x0());
+  std::vector<Eigen::VectorXd> us;
+  for (const auto &m : problem->get_runningModels())
+    us.push_back(Eigen::VectorXd::Random(m->get_nu()));
+
+  std::ostringstream os;
+  sobec::saveShootingProblem(os, *problem, xs, us);
+  const std::string buffer = os.str();
+
+  sobec::ShootingProblemSnapshot snapshot = sobec::loadShootingProblem(
+      buffer.data(), buffer.size(), getModel(*problem));
+  checkSameProblem(*problem, *snapshot.problem);
+  BOOST_REQUIRE(snapshot.xs.size() == xs.size());
+  BOOST_REQUIRE(snapshot.us.size() == us.size());
+  for (std::size_t t = 0; t < us.size(); ++t) {
+    BOOST_CHECK(snapshot.xs[t] == xs[t]);
+    BOOST_CHECK(snapshot.us[t] == us[t]);
+  }
+
+  // Same roundtrip through a mapped file.
+  const std::string filename = "test_serialization.bin";
+  sobec::saveShootingProblem(filename, *problem, xs, us);
+  sobec::ShootingProblemSnapshot fromFile =
+      sobec::loadShootingProblem(filename, getModel(*problem));
+  checkSameProblem(*problem, *fromFile.problem);
+  std::remove(filename.c_str());
+
+  // A truncated snapshot, or another robot model, is rejected.
+  BOOST_CHECK_THROW(sobec::loadShootingProblem(
+                        buffer.data(), buffer.size() / 2, getModel(*problem)),
+                    crocoddyl::Exception);
+  boost::shared_ptr<pinocchio::Model> other =
+      boost::make_shared<pinocchio::Model>(*getModel(*problem));
+  other->name = "other";
+  BOOST_CHECK_THROW(
+      sobec::loadShootingProblem(buffer.data(), buffer.size(), other),
+      crocoddyl::Exception);
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+// Only the warnings are compiled in this test, whatever the level of the
+// library.
+#undef SOBEC_TRACE_LEVEL
+#define SOBEC_TRACE_LEVEL 1
+
+#define BOOST_TEST_MODULE trace
+#include <boost/test/included/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "sobec/trace.hpp"
+
+namespace {
+
+sobec::trace::Event makeEvent(const double value) {
+  sobec::trace::Event event;
+  event.time = 0;
+  event.message = "event";
+  event.values[0] = value;
+  event.nvalues = 1;
+  event.label[0] = '\0';
+  event.level = sobec::trace::INFO;
+  return event;
+}
+
+double count(int& counter) { return static_cast<double>(++counter); }
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_trace_ring) {
+  sobec::trace::EventRing ring;
+  sobec::trace::Event event;
+  BOOST_CHECK(!ring.pop(event));
+
+  // Events come out in order.
+  for (int i = 0; i < 3; ++i) BOOST_CHECK(ring.push(makeEvent(i)));
+  for (int i = 0; i < 3; ++i) {
+    BOOST_REQUIRE(ring.pop(event));
+    BOOST_CHECK(event.values[0] == i);
+  }
+  BOOST_CHECK(!ring.pop(event));
+  BOOST_CHECK(ring.takeDropped() == 0);
+
+  // When the ring is full, the new events are dropped and counted.
+  const std::size_t capacity = sobec::trace::EventRing::kCapacity;
+  for (std::size_t i = 0; i < capacity; ++i)
+    BOOST_CHECK(ring.push(makeEvent(static_cast<double>(i))));
+  BOOST_CHECK(!ring.push(makeEvent(-1.)));
+  BOOST_CHECK(!ring.push(makeEvent(-1.)));
+  BOOST_CHECK(ring.takeDropped() == 2);
+  BOOST_CHECK(ring.takeDropped() == 0);
+  for (std::size_t i = 0; i < capacity; ++i) {
+    BOOST_REQUIRE(ring.pop(event));
+    BOOST_CHECK(event.values[0] == static_cast<double>(i));
+  }
+  BOOST_CHECK(!ring.pop(event));
+  BOOST_CHECK(ring.push(makeEvent(0.)));
+}
+
+BOOST_AUTO_TEST_CASE(test_trace_levels) {
+  const std::string path = "test_trace.log";
+  int warnings = 0, infos = 0, debugs = 0;
+  sobec::trace::start(path);
+  SOBEC_TRACE_WARNING("warning event", count(warnings));
+  // Above the compiled level: the sites expand to nothing, and their
+  // arguments are not evaluated.
+  SOBEC_TRACE_INFO("info event", count(infos));
+  SOBEC_TRACE_DEBUG("debug event", count(debugs));
+  sobec::trace::stop();
+  // Not recorded once stopped, though the arguments are evaluated.
+  SOBEC_TRACE_WARNING("stopped event", count(warnings));
+
+  BOOST_CHECK(warnings == 2);
+  BOOST_CHECK(infos == 0);
+  BOOST_CHECK(debugs == 0);
+
+  std::ifstream file(path.c_str());
+  std::stringstream content;
+  content << file.rdbuf();
+  file.close();
+  std::remove(path.c_str());
+  BOOST_CHECK(content.str().find("WARNING warning event 1") !=
+              std::string::npos);
+  BOOST_CHECK(content.str().find("info event") == std::string::npos);
+  BOOST_CHECK(content.str().find("debug event") == std::string::npos);
+  BOOST_CHECK(content.str().find("stopped event") == std::string::npos);
+}
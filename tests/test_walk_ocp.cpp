@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE walk ocp
+#include <boost/test/included/unit_test.hpp>
+#include <crocoddyl/core/integrator/euler.hpp>
+#include <crocoddyl/core/optctrl/shooting.hpp>
+#include <crocoddyl/core/solvers/fddp.hpp>
+#include <crocoddyl/multibody/actions/contact-fwddyn.hpp>
+
+#include "sobec/mpc-walk.hpp"
+#include "sobec/walk/ocp.hpp"
+#ifdef PROJECT_SOURCE_DIR
+#include "sobec/py2cpp.hpp"
+#endif
+
+BOOST_AUTO_TEST_CASE(test_walk_params_timeline) {
+  sobec::walk::WalkParams params("talos_12");
+  BOOST_CHECK(params.Tstart == 30);
+  BOOST_CHECK(params.Tsingle == 80);
+  BOOST_CHECK(params.Tdouble == 11);
+  BOOST_CHECK(params.Tmpc == 160);
+  BOOST_CHECK(params.stateImportance.size() == 36);
+  BOOST_CHECK(params.stateTerminalImportance.size() == 36);
+  BOOST_CHECK(params.controlImportance.size() == 12);
+  BOOST_CHECK_THROW(sobec::walk::WalkParams("unknown"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_walk_reference_forces) {
+  sobec::walk::WalkParams params("talos_12");
+  const sobec::walk::ContactPattern pattern =
+      sobec::walk::buildWalkContactPattern(params);
+  BOOST_CHECK(pattern.size() == static_cast<std::size_t>(
+                                    params.Tstart + 3 * params.Tdouble +
+                                    2 * params.Tsingle + params.Tend + 1));
+
+  const double weight = 500.;
+  const std::vector<std::vector<sobec::eVector6> > forces =
+      sobec::walk::computeReferenceForces(pattern, weight);
+  BOOST_CHECK(forces.size() == pattern.size());
+
+  for (std::size_t t = 0; t < pattern.size(); ++t) {
+    // The weight is always fully supported, only by the feet in contact.
+    double fz = 0.;
+    for (std::size_t k = 0; k < pattern[t].size(); ++k) {
+      fz += forces[t][k][2];
+      if (!pattern[t][k]) BOOST_CHECK(forces[t][k].isZero());
+      BOOST_CHECK(forces[t][k][2] >= 0.);
+    }
+    BOOST_CHECK(std::abs(fz - weight) < 1e-9);
+  }
+}
+
+// Only built with the python interface: compare the native builder with
+// sobec.walk.ocp, on the problem of tests/python/mpc_walk_gait.py.
+#ifdef PROJECT_SOURCE_DIR
+
+sobec::DAM differential(const sobec::AMA& model) {
+  return boost::static_pointer_cast<
+      crocoddyl::DifferentialActionModelContactFwdDynamics>(
+      boost::static_pointer_cast<crocoddyl::IntegratedActionModelEuler>(model)
+          ->get_differential());
+}
+
+bool hasSuffix(const std::string& name, const std::string& suffix) {
+  return name.size() >= suffix.size() &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+BOOST_AUTO_TEST_CASE(test_walk_ocp_matches_python) {
+  sobec::MPCWalkPtr mpcpy =
+      sobec::initMPCWalk(PROJECT_SOURCE_DIR "/tests/python/mpc_walk_gait.py");
+  // Number of iterations of the OCP solve in mpc_walk_gait.py.
+  const std::size_t maxiter = 20;
+
+  // The python RobotWrapper adds the tow and heel frames to the model in
+  // place, after all the other frames: drop them to get back the model it
+  // was built from.
+  pinocchio::Model model = *mpcpy->state->get_pinocchio();
+  std::size_t nframes = model.frames.size();
+  while (hasSuffix(model.frames[nframes - 1].name, "_tow") ||
+         hasSuffix(model.frames[nframes - 1].name, "_heel"))
+    --nframes;
+  model.frames.resize(nframes);
+  model.nframes = static_cast<int>(nframes);
+  const sobec::walk::RobotWrapper robot(model, "sole_link");
+  BOOST_REQUIRE(robot.model->nframes ==
+                mpcpy->state->get_pinocchio()->nframes);
+
+  sobec::walk::WalkParams params(robot.name);
+  params.Tstart = mpcpy->Tstart;
+  params.Tdouble = mpcpy->Tdouble;
+  params.Tsingle = mpcpy->Tsingle;
+  params.Tend = mpcpy->Tend;
+  params.Tmpc = mpcpy->Tmpc;
+  const sobec::walk::ContactPattern pattern =
+      sobec::walk::buildWalkContactPattern(params);
+
+  // Same contacts and cost stack at each node, with the same weights, and
+  // the same cost value.
+  const sobec::DDP ddp = sobec::walk::buildSolver(robot, pattern, params);
+  const crocoddyl::ShootingProblem& problem = *ddp->get_problem();
+  const crocoddyl::ShootingProblem& problempy = *mpcpy->storage;
+  BOOST_REQUIRE(problem.get_T() == problempy.get_T());
+
+  const boost::shared_ptr<crocoddyl::StateAbstract>& state =
+      problem.get_terminalModel()->get_state();
+  Eigen::VectorXd dx = 0.05 * Eigen::VectorXd::Random(state->get_ndx());
+  Eigen::VectorXd x(state->get_nx());
+  state->integrate(robot.x0, dx, x);
+  const Eigen::VectorXd u =
+      10. * Eigen::VectorXd::Random(problem.get_nu_max());
+
+  for (std::size_t t = 0; t < problem.get_T(); ++t) {
+    const sobec::AMA& node = problem.get_runningModels()[t];
+    const sobec::AMA& nodepy = problempy.get_runningModels()[t];
+    const sobec::DAM dam = differential(node);
+    const sobec::DAM dampy = differential(nodepy);
+
+    const crocoddyl::ContactModelMultiple::ContactModelContainer& contacts =
+        dam->get_contacts()->get_contacts();
+    const crocoddyl::ContactModelMultiple::ContactModelContainer& contactspy =
+        dampy->get_contacts()->get_contacts();
+    BOOST_CHECK(contacts.size() == contactspy.size());
+    for (const auto& contact : contacts)
+      BOOST_CHECK(contactspy.find(contact.first) != contactspy.end());
+
+    const crocoddyl::CostModelSum::CostModelContainer& costs =
+        dam->get_costs()->get_costs();
+    const crocoddyl::CostModelSum::CostModelContainer& costspy =
+        dampy->get_costs()->get_costs();
+    BOOST_CHECK(costs.size() == costspy.size());
+    for (const auto& cost : costs) {
+      const auto it = costspy.find(cost.first);
+      BOOST_REQUIRE_MESSAGE(it != costspy.end(),
+                            "node " << t << ": no cost " << cost.first);
+      BOOST_CHECK(std::abs(cost.second->weight - it->second->weight) <=
+                  1e-9 * std::abs(it->second->weight));
+      BOOST_CHECK(cost.second->active == it->second->active);
+    }
+
+    const sobec::ADA data = node->createData();
+    const sobec::ADA datapy = nodepy->createData();
+    node->calc(data, x, u);
+    nodepy->calc(datapy, x, u);
+    BOOST_CHECK_MESSAGE(
+        std::abs(data->cost - datapy->cost) <= 1e-9 * (1 + std::abs(datapy->cost)),
+        "node " << t << ": cost " << data->cost << " vs " << datapy->cost);
+  }
+
+  // Same initial solution, and same solution after an MPC tick.
+  boost::shared_ptr<sobec::MPCWalk> mpc =
+      sobec::walk::buildMPCWalk(robot, params, maxiter);
+  const std::vector<Eigen::VectorXd>& us = mpc->solver->get_us();
+  const std::vector<Eigen::VectorXd>& uspy = mpcpy->solver->get_us();
+  BOOST_CHECK((us[0] - uspy[0]).norm() <= 1e-6 * (1 + uspy[0].norm()));
+
+  const Eigen::VectorXd x1 = mpcpy->solver->get_xs()[1];
+  mpc->calc(x1, 1);
+  mpcpy->calc(x1, 1);
+  BOOST_CHECK((us[0] - uspy[0]).norm() <= 1e-6 * (1 + uspy[0].norm()));
+  BOOST_CHECK((mpc->solver->get_xs()[1] - mpcpy->solver->get_xs()[1]).norm() <=
+              1e-6);
+}
+
+#endif  // PROJECT_SOURCE_DIR
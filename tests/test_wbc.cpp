@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// BSD 3-Clause License
+//
+// Copyright (C) 2022, LAAS-CNRS
+// Copyright note valid unless otherwise stated in individual files.
+// All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#define BOOST_TEST_MODULE wbc
+#include <algorithm>
+#include <boost/make_shared.hpp>
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <crocoddyl/multibody/residuals/frame-placement.hpp>
+#include <iostream>
+#include <thread>
+
+#include "allocation_counter.hpp"
+#include "factory/designer.hpp"
+#include "sobec/designer.hpp"
+#include "sobec/horizon_manager.hpp"
+#include "sobec/model_factory.hpp"
+#include "sobec/wbc-async.hpp"
+#include "sobec/wbc.hpp"
+
+namespace {
+
+// WBC of the Talos legs and torso on a short horizon, with its walking cycle.
+struct WBCFixture {
+  WBCFixture() {
+    sobec::unittest::TalosDesignerFactory factory;
+    designer.initialize(factory.get_settings());
+    maker.initialize(factory.create_makerSettings(designer), designer);
+
+    settings.T = 20;
+    settings.TdoubleSupport = 5;
+    settings.TsingleSupport = 10;
+    settings.Tstep = 15;
+    settings.Dt = 1e-2;
+    settings.simu_step = 1e-3;
+    settings.Nc = 10;
+
+    wbc.initialize(settings, designer, buildHorizon(settings.T),
+                   designer.get_q0Complete(), designer.get_v0Complete(),
+                   "actuationTask");
+    wbc.generateWalkigCycle(maker);
+  }
+
+  sobec::HorizonManager buildHorizon(const int T) {
+    const std::vector<sobec::AMA> models = maker.formulateHorizon(T);
+    sobec::HorizonManagerSettings horizonSettings;
+    horizonSettings.leftFootName = designer.get_LF_name();
+    horizonSettings.rightFootName = designer.get_RF_name();
+    return sobec::HorizonManager(horizonSettings, designer.get_x0(), models,
+                                 models.back());
+  }
+
+  sobec::RobotDesigner designer;
+  sobec::ModelMaker maker;
+  sobec::WBCSettings settings;
+  sobec::WBC wbc;
+};
+
+const pinocchio::SE3& placementLF(sobec::HorizonManager& horizon,
+                                  const unsigned long time) {
+  return boost::static_pointer_cast<crocoddyl::ResidualModelFramePlacement>(
+             horizon.costs(time)->get_costs().at("placement_LF")->cost
+                 ->get_residual())
+      ->get_reference();
+}
+
+// Control of node n of the DDP solution for the state x, with the crocoddyl
+// convention u = us - K (x - xs).
+Eigen::VectorXd policyTorques(const sobec::DDP& ddp,
+                              const crocoddyl::StateMultibody& state,
+                              const std::size_t n, const Eigen::VectorXd& x) {
+  Eigen::VectorXd dx(state.get_ndx());
+  state.diff(ddp->get_xs()[n], x, dx);
+  return ddp->get_us()[n] - ddp->get_K()[n] * dx;
+}
+
+// Wait until the worker has completed n solves, without relying on the
+// duration of a solve.
+bool waitForSolves(const sobec::WBCAsync& async, const std::size_t n) {
+  const std::chrono::steady_clock::time_point timeout =
+      std::chrono::steady_clock::now() + std::chrono::seconds(60);
+  for (;;) {
+    if (async.get_solves() >= n) return true;
+    if (std::chrono::steady_clock::now() > timeout) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_CASE(test_horizon_copies, WBCFixture) {
+  // The copies share the solver, and the handles follow its nodes whichever
+  // copy recedes them.
+  sobec::HorizonManager horizon = buildHorizon(settings.T);
+  sobec::HorizonManager copy = horizon;
+  const unsigned long last = horizon.size() - 1;
+  copy.recede();
+  pinocchio::SE3 pose = pinocchio::SE3::Random();
+  horizon.setPoseReferenceLF(0, pose);
+  BOOST_CHECK(placementLF(copy, 0).isApprox(pose));
+  BOOST_CHECK(!placementLF(copy, last).isApprox(pose));
+
+  sobec::HorizonManager other = buildHorizon(settings.T);
+  copy.recede(other.ama(0), other.ada(0));
+  pose = pinocchio::SE3::Random();
+  horizon.setPoseReferenceLF(last, pose);
+  BOOST_CHECK(placementLF(other, 0).isApprox(pose));
+
+  // Same through the getter and setter of the WBC horizon.
+  sobec::HorizonManager wbcHorizon = wbc.get_horizon();
+  wbcHorizon.recede();
+  wbc.set_horizon(wbcHorizon);
+  pose = pinocchio::SE3::Random();
+  wbc.get_horizon().setPoseReferenceLF(0, pose);
+  BOOST_CHECK(placementLF(wbcHorizon, 0).isApprox(pose));
+  BOOST_CHECK(!placementLF(wbcHorizon, last).isApprox(pose));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_wbc_set_horizon, WBCFixture) {
+  const pinocchio::SE3 kept = pinocchio::SE3::Random();
+  wbc.setPoseRef_LF(kept, 3);
+
+  // The references follow the size of the new horizon.
+  sobec::HorizonManager horizon = buildHorizon(30);
+  wbc.set_horizon(horizon);
+  BOOST_REQUIRE(wbc.getPoseRef_LF().size() == 30);
+  BOOST_REQUIRE(wbc.getPoseRef_RF().size() == 30);
+  BOOST_REQUIRE(wbc.getVelRef_COM().size() == 30);
+  BOOST_CHECK(wbc.getPoseRef_LF(3).isApprox(kept));
+
+  // The nodes past the previous horizon are written in the costs.
+  const pinocchio::SE3 last = pinocchio::SE3::Random();
+  wbc.setPoseRef_LF(last, 25);
+  wbc.solveDDP(wbc.get_x0(), false);
+  BOOST_CHECK(placementLF(horizon, 2).isApprox(kept));
+  BOOST_CHECK(placementLF(horizon, 24).isApprox(last));
+  for (unsigned long time = 0; time < horizon.size(); ++time) {
+    BOOST_CHECK(placementLF(horizon, time).isApprox(wbc.getPoseRef_LF(time)));
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_wbc_solve_does_not_allocate, WBCFixture) {
+  // The nodes entering the horizon come from the walking cycle, with the
+  // datas pooled by generateWalkigCycle. Once the first nodes have left the
+  // horizon, a DDP tick does not allocate.
+  const Eigen::VectorXd x = wbc.get_x0();
+  for (int tick = 0; tick < settings.T; ++tick) wbc.solveDDP(x, false);
+
+  startCountingAllocations();
+  for (int tick = 0; tick < 2 * settings.Tstep; ++tick) wbc.solveDDP(x, false);
+  const std::size_t allocations = stopCountingAllocations();
+  std::cout << "Allocations during DDP ticks: " << allocations << std::endl;
+  BOOST_CHECK(allocations == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_wbc_async, WBCFixture) {
+  wbc.solveDDP(wbc.get_x0(), false);
+  boost::shared_ptr<sobec::WBC> shared = boost::make_shared<sobec::WBC>(wbc);
+  sobec::HorizonManager horizon = shared->get_horizon();
+  const sobec::DDP ddp = horizon.get_ddp();
+  const boost::shared_ptr<crocoddyl::StateMultibody> state = horizon.state(0);
+  BOOST_REQUIRE(!ddp->get_K()[0].isZero());
+
+  const Eigen::VectorXd q = designer.get_q0Complete();
+  const Eigen::VectorXd v = designer.get_v0Complete();
+  const Eigen::VectorXd x0 = shared->shapeState(q, v);
+  Eigen::VectorXd x(state->get_nx());
+  state->integrate(x0, 1e-2 * Eigen::VectorXd::Random(state->get_ndx()), x);
+
+  const int policyNodes = 5;
+  sobec::WBCAsync async(shared, policyNodes);
+  async.start();
+  BOOST_CHECK(async.isRunning());
+
+  // Until the first solve, the initial solution is used, with the same sign
+  // of the feedback as HorizonManager::currentTorques.
+  BOOST_CHECK(async.currentTorques(0, x).isApprox(horizon.currentTorques(x)));
+  BOOST_CHECK(
+      async.currentTorques(0, x).isApprox(policyTorques(ddp, *state, 0, x)));
+
+  // A state is posted at each tick where timeToSolveDDP is true, and only
+  // then. Each one is solved before the next: none is missed.
+  const int Nc = settings.Nc;
+  std::size_t posts = 0;
+  for (int it = 0; it < 3 * Nc; ++it) {
+    async.iterate(it, q, v);
+    if (shared->timeToSolveDDP(it)) ++posts;
+    BOOST_REQUIRE(waitForSolves(async, posts));
+  }
+  BOOST_CHECK(posts == 3);
+  BOOST_CHECK(async.get_solves() == posts);
+  BOOST_CHECK(async.get_missed() == 0);
+
+  // The solution of iteration i0 is used at node (it - i0) / Nc, up to the
+  // last published node. The worker is idle, so its DDP can be read.
+  const int i0 = 2 * Nc;
+  for (int it = i0; it < i0 + (policyNodes + 2) * Nc; it += 3) {
+    const std::size_t node =
+        std::min<std::size_t>((it - i0) / Nc, policyNodes - 1);
+    BOOST_CHECK(async.currentTorques(it, x).isApprox(
+        policyTorques(ddp, *state, node, x)));
+    BOOST_CHECK(async.get_policyAge() == it - i0);
+  }
+
+  // stop joins the worker and can be called again.
+  async.stop();
+  BOOST_CHECK(!async.isRunning());
+  async.stop();
+
+  // Without worker, the second post overwrites the first one.
+  async.iterate(3 * Nc, q, v);
+  BOOST_CHECK(async.get_missed() == 0);
+  async.iterate(4 * Nc, q, v);
+  BOOST_CHECK(async.get_missed() == 1);
+  BOOST_CHECK(async.get_solves() == posts);
+}